@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdint.h>
+#include "epd_driver.h"
+
+///////////////////////////// Drawing internals /////////////////////////////
+//
+// Shared between epd_init and the drawing and font functions. Drawing writes
+// pixel by pixel but records damage once per primitive.
+
+/*
+ * Create the glyph cache lock. Called once from `epd_init`, before any text
+ * is drawn.
+ */
+void epd_font_init();
+
+/*
+ * Like `epd_draw_pixel`, but doesn't record damage.
+ */
+void epd_write_pixel(int x, int y, uint8_t color, uint8_t *framebuffer);
+
+/*
+ * Like `epd_damage_add`, but takes `area` in drawing (rotated) coordinates.
+ */
+void epd_damage_add_rotated(const uint8_t *framebuffer, EpdRect area);
@@ -1,10 +1,14 @@
 #include "epd_driver.h"
 #include "epd_temperature.h"
+#include "draw_internal.h"
+#include "kernels.h"
 
 #include "esp_assert.h"
 #include "esp_heap_caps.h"
 #include "esp_log.h"
 #include "esp_types.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
 
 // Simple x and y coordinate
 typedef struct {
@@ -31,22 +35,184 @@ EpdRect epd_full_screen() {
 
 void epd_clear() { epd_clear_area(epd_full_screen()); }
 
-void epd_draw_hline(int x, int y, int length, uint8_t color,
-                    uint8_t *framebuffer) {
+// Damaged areas within this distance of each other are merged.
+#define DAMAGE_MERGE_DISTANCE 16
+
+static EpdDamage *damage_tracker = NULL;
+
+// Trackers are drawn into and consumed from different tasks. Recording
+// happens once per drawn primitive and is short, so a spinlock is enough.
+static portMUX_TYPE damage_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static inline bool rect_empty(EpdRect r) { return r.width <= 0 || r.height <= 0; }
+
+static inline bool rect_contains(EpdRect outer, EpdRect inner) {
+  return inner.x >= outer.x && inner.y >= outer.y &&
+         inner.x + inner.width <= outer.x + outer.width &&
+         inner.y + inner.height <= outer.y + outer.height;
+}
+
+static inline bool rect_near(EpdRect a, EpdRect b, int distance) {
+  return a.x - distance < b.x + b.width && b.x - distance < a.x + a.width &&
+         a.y - distance < b.y + b.height && b.y - distance < a.y + a.height;
+}
+
+static EpdRect rect_union(EpdRect a, EpdRect b) {
+  int x0 = a.x < b.x ? a.x : b.x;
+  int y0 = a.y < b.y ? a.y : b.y;
+  int x1 = a.x + a.width > b.x + b.width ? a.x + a.width : b.x + b.width;
+  int y1 = a.y + a.height > b.y + b.height ? a.y + a.height : b.y + b.height;
+  EpdRect r = {.x = x0, .y = y0, .width = x1 - x0, .height = y1 - y0};
+  return r;
+}
+
+static EpdRect rect_intersection(EpdRect a, EpdRect b) {
+  int x0 = a.x > b.x ? a.x : b.x;
+  int y0 = a.y > b.y ? a.y : b.y;
+  int x1 = a.x + a.width < b.x + b.width ? a.x + a.width : b.x + b.width;
+  int y1 = a.y + a.height < b.y + b.height ? a.y + a.height : b.y + b.height;
+  EpdRect r = {.x = x0, .y = y0, .width = x1 - x0, .height = y1 - y0};
+  if (rect_empty(r)) {
+    r.width = 0;
+    r.height = 0;
+  }
+  return r;
+}
+
+void epd_set_damage_tracker(EpdDamage *damage) { damage_tracker = damage; }
+
+void epd_damage_add(const uint8_t *framebuffer, EpdRect area) {
+  if (damage_tracker == NULL || framebuffer != damage_tracker->framebuffer) {
+    return;
+  }
+  epd_damage_record(damage_tracker, area);
+}
+
+static void damage_record_locked(EpdDamage *damage, EpdRect area) {
+  for (int i = 0; i < damage->count; i++) {
+    if (rect_contains(damage->rects[i], area)) {
+      return;
+    }
+  }
+  for (int i = 0; i < damage->count; i++) {
+    if (rect_near(damage->rects[i], area, DAMAGE_MERGE_DISTANCE)) {
+      damage->rects[i] = rect_union(damage->rects[i], area);
+      return;
+    }
+  }
+  if (damage->count < EPD_MAX_DAMAGE_RECTS) {
+    damage->rects[damage->count++] = area;
+    return;
+  }
+
+  // out of slots, merge with the area that grows the least.
+  int best = 0;
+  int best_growth = INT32_MAX;
+  for (int i = 0; i < damage->count; i++) {
+    EpdRect u = rect_union(damage->rects[i], area);
+    int growth = u.width * u.height -
+                 damage->rects[i].width * damage->rects[i].height;
+    if (growth < best_growth) {
+      best_growth = growth;
+      best = i;
+    }
+  }
+  damage->rects[best] = rect_union(damage->rects[best], area);
+}
+
+void epd_damage_record(EpdDamage *damage, EpdRect area) {
+  assert(damage != NULL);
+  area = rect_intersection(area, epd_full_screen());
+  if (rect_empty(area)) {
+    return;
+  }
+
+  portENTER_CRITICAL(&damage_lock);
+  damage_record_locked(damage, area);
+  portEXIT_CRITICAL(&damage_lock);
+}
+
+EpdRect epd_damage_take(EpdDamage *damage, EpdRect area) {
+  EpdRect bounds = {.x = 0, .y = 0, .width = 0, .height = 0};
+  assert(damage != NULL);
+
+  portENTER_CRITICAL(&damage_lock);
+  int kept = 0;
+  for (int i = 0; i < damage->count; i++) {
+    EpdRect r = damage->rects[i];
+    EpdRect inside = rect_intersection(r, area);
+    if (!rect_empty(inside)) {
+      bounds = rect_empty(bounds) ? inside : rect_union(bounds, inside);
+    }
+    if (!rect_contains(area, r)) {
+      damage->rects[kept++] = r;
+    }
+  }
+  damage->count = kept;
+  portEXIT_CRITICAL(&damage_lock);
+  return bounds;
+}
+
+void epd_damage_add_rotated(const uint8_t *framebuffer, EpdRect area) {
+  if (damage_tracker == NULL || rect_empty(area)) {
+    return;
+  }
+
+  // Same mapping as _rotate, applied to the whole area.
+  EpdRect r = area;
+  switch (display_rotation) {
+  case EPD_ROT_LANDSCAPE:
+    break;
+  case EPD_ROT_PORTRAIT:
+    r.x = EPD_WIDTH - area.y - area.height;
+    r.y = area.x;
+    r.width = area.height;
+    r.height = area.width;
+    break;
+  case EPD_ROT_INVERTED_LANDSCAPE:
+    r.x = EPD_WIDTH - area.x - area.width;
+    r.y = EPD_HEIGHT - area.y - area.height;
+    break;
+  case EPD_ROT_INVERTED_PORTRAIT:
+    r.x = area.y;
+    r.y = EPD_HEIGHT - area.x - area.width;
+    r.width = area.height;
+    r.height = area.width;
+    break;
+  }
+  epd_damage_add(framebuffer, r);
+}
+
+static void write_hline(int x, int y, int length, uint8_t color,
+                        uint8_t *framebuffer) {
   for (int i = 0; i < length; i++) {
     int xx = x + i;
-    epd_draw_pixel(xx, y, color, framebuffer);
+    epd_write_pixel(xx, y, color, framebuffer);
   }
 }
 
-void epd_draw_vline(int x, int y, int length, uint8_t color,
-                    uint8_t *framebuffer) {
+static void write_vline(int x, int y, int length, uint8_t color,
+                        uint8_t *framebuffer) {
   for (int i = 0; i < length; i++) {
     int yy = y + i;
-    epd_draw_pixel(x, yy, color, framebuffer);
+    epd_write_pixel(x, yy, color, framebuffer);
   }
 }
 
+void epd_draw_hline(int x, int y, int length, uint8_t color,
+                    uint8_t *framebuffer) {
+  write_hline(x, y, length, color, framebuffer);
+  EpdRect area = {.x = x, .y = y, .width = length, .height = 1};
+  epd_damage_add_rotated(framebuffer, area);
+}
+
+void epd_draw_vline(int x, int y, int length, uint8_t color,
+                    uint8_t *framebuffer) {
+  write_vline(x, y, length, color, framebuffer);
+  EpdRect area = {.x = x, .y = y, .width = 1, .height = length};
+  epd_damage_add_rotated(framebuffer, area);
+}
+
 Coord_xy _rotate(uint16_t x, uint16_t y) {
     switch (display_rotation) {
         case EPD_ROT_LANDSCAPE:
@@ -70,7 +236,7 @@ Coord_xy _rotate(uint16_t x, uint16_t y) {
     return coord;
 }
 
-void epd_draw_pixel(int x, int y, uint8_t color, uint8_t *framebuffer) {
+void epd_write_pixel(int x, int y, uint8_t color, uint8_t *framebuffer) {
   // Check rotation and move pixel around if necessary
   Coord_xy coord = _rotate(x, y);
   x = coord.x;
@@ -91,6 +257,12 @@ void epd_draw_pixel(int x, int y, uint8_t color, uint8_t *framebuffer) {
   }
 }
 
+void epd_draw_pixel(int x, int y, uint8_t color, uint8_t *framebuffer) {
+  epd_write_pixel(x, y, color, framebuffer);
+  EpdRect pixel = {.x = x, .y = y, .width = 1, .height = 1};
+  epd_damage_add_rotated(framebuffer, pixel);
+}
+
 void epd_draw_circle(int x0, int y0, int r, uint8_t color,
                      uint8_t *framebuffer) {
   int f = 1 - r;
@@ -99,10 +271,10 @@ void epd_draw_circle(int x0, int y0, int r, uint8_t color,
   int x = 0;
   int y = r;
 
-  epd_draw_pixel(x0, y0 + r, color, framebuffer);
-  epd_draw_pixel(x0, y0 - r, color, framebuffer);
-  epd_draw_pixel(x0 + r, y0, color, framebuffer);
-  epd_draw_pixel(x0 - r, y0, color, framebuffer);
+  epd_write_pixel(x0, y0 + r, color, framebuffer);
+  epd_write_pixel(x0, y0 - r, color, framebuffer);
+  epd_write_pixel(x0 + r, y0, color, framebuffer);
+  epd_write_pixel(x0 - r, y0, color, framebuffer);
 
   while (x < y) {
     if (f >= 0) {
@@ -114,25 +286,41 @@ void epd_draw_circle(int x0, int y0, int r, uint8_t color,
     ddF_x += 2;
     f += ddF_x;
 
-    epd_draw_pixel(x0 + x, y0 + y, color, framebuffer);
-    epd_draw_pixel(x0 - x, y0 + y, color, framebuffer);
-    epd_draw_pixel(x0 + x, y0 - y, color, framebuffer);
-    epd_draw_pixel(x0 - x, y0 - y, color, framebuffer);
-    epd_draw_pixel(x0 + y, y0 + x, color, framebuffer);
-    epd_draw_pixel(x0 - y, y0 + x, color, framebuffer);
-    epd_draw_pixel(x0 + y, y0 - x, color, framebuffer);
-    epd_draw_pixel(x0 - y, y0 - x, color, framebuffer);
+    epd_write_pixel(x0 + x, y0 + y, color, framebuffer);
+    epd_write_pixel(x0 - x, y0 + y, color, framebuffer);
+    epd_write_pixel(x0 + x, y0 - y, color, framebuffer);
+    epd_write_pixel(x0 - x, y0 - y, color, framebuffer);
+    epd_write_pixel(x0 + y, y0 + x, color, framebuffer);
+    epd_write_pixel(x0 - y, y0 + x, color, framebuffer);
+    epd_write_pixel(x0 + y, y0 - x, color, framebuffer);
+    epd_write_pixel(x0 - y, y0 - x, color, framebuffer);
   }
+
+  EpdRect area = {.x = x0 - r, .y = y0 - r, .width = 2 * r + 1, .height = 2 * r + 1};
+  epd_damage_add_rotated(framebuffer, area);
 }
 
+static void fill_circle_helper(int x0, int y0, int r, int corners, int delta,
+                               uint8_t color, uint8_t *framebuffer);
+
 void epd_fill_circle(int x0, int y0, int r, uint8_t color,
                      uint8_t *framebuffer) {
-  epd_draw_vline(x0, y0 - r, 2 * r + 1, color, framebuffer);
-  epd_fill_circle_helper(x0, y0, r, 3, 0, color, framebuffer);
+  write_vline(x0, y0 - r, 2 * r + 1, color, framebuffer);
+  fill_circle_helper(x0, y0, r, 3, 0, color, framebuffer);
+  EpdRect area = {.x = x0 - r, .y = y0 - r, .width = 2 * r + 1, .height = 2 * r + 1};
+  epd_damage_add_rotated(framebuffer, area);
 }
 
 void epd_fill_circle_helper(int x0, int y0, int r, int corners, int delta,
                             uint8_t color, uint8_t *framebuffer) {
+  fill_circle_helper(x0, y0, r, corners, delta, color, framebuffer);
+  // Both halves, the vertical spans end `delta` below the circle.
+  EpdRect area = {.x = x0 - r, .y = y0 - r, .width = 2 * r + 1, .height = 2 * r + 1 + delta};
+  epd_damage_add_rotated(framebuffer, area);
+}
+
+static void fill_circle_helper(int x0, int y0, int r, int corners, int delta,
+                               uint8_t color, uint8_t *framebuffer) {
 
   int f = 1 - r;
   int ddF_x = 1;
@@ -157,15 +345,15 @@ void epd_fill_circle_helper(int x0, int y0, int r, int corners, int delta,
     // for the SSD1306 library which has an INVERT drawing mode.
     if (x < (y + 1)) {
       if (corners & 1)
-        epd_draw_vline(x0 + x, y0 - y, 2 * y + delta, color, framebuffer);
+        write_vline(x0 + x, y0 - y, 2 * y + delta, color, framebuffer);
       if (corners & 2)
-        epd_draw_vline(x0 - x, y0 - y, 2 * y + delta, color, framebuffer);
+        write_vline(x0 - x, y0 - y, 2 * y + delta, color, framebuffer);
     }
     if (y != py) {
       if (corners & 1)
-        epd_draw_vline(x0 + py, y0 - px, 2 * px + delta, color, framebuffer);
+        write_vline(x0 + py, y0 - px, 2 * px + delta, color, framebuffer);
       if (corners & 2)
-        epd_draw_vline(x0 - py, y0 - px, 2 * px + delta, color, framebuffer);
+        write_vline(x0 - py, y0 - px, 2 * px + delta, color, framebuffer);
       py = y;
     }
     px = x;
@@ -186,8 +374,9 @@ void epd_fill_rect(EpdRect rect, uint8_t color, uint8_t *framebuffer) {
 
   int x = rect.x; int y = rect.y; int w = rect.width; int h = rect.height;
   for (int i = y; i < y + h; i++) {
-    epd_draw_hline(x, i, w, color, framebuffer);
+    write_hline(x, i, w, color, framebuffer);
   }
+  epd_damage_add_rotated(framebuffer, rect);
 }
 
 static void epd_write_line(int x0, int y0, int x1, int y1, uint8_t color,
@@ -218,9 +407,9 @@ static void epd_write_line(int x0, int y0, int x1, int y1, uint8_t color,
 
   for (; x0 <= x1; x0++) {
     if (steep) {
-      epd_draw_pixel(y0, x0, color, framebuffer);
+      epd_write_pixel(y0, x0, color, framebuffer);
     } else {
-      epd_draw_pixel(x0, y0, color, framebuffer);
+      epd_write_pixel(x0, y0, color, framebuffer);
     }
     err -= dy;
     if (err < 0) {
@@ -243,6 +432,11 @@ void epd_draw_line(int x0, int y0, int x1, int y1, uint8_t color,
     epd_draw_hline(x0, y0, x1 - x0 + 1, color, framebuffer);
   } else {
     epd_write_line(x0, y0, x1, y1, color, framebuffer);
+    EpdRect area = {.x = x0 < x1 ? x0 : x1,
+                    .y = y0 < y1 ? y0 : y1,
+                    .width = abs(x1 - x0) + 1,
+                    .height = abs(y1 - y0) + 1};
+    epd_damage_add_rotated(framebuffer, area);
   }
 }
 
@@ -312,7 +506,7 @@ void epd_fill_triangle(int x0, int y0, int x1, int y1, int x2, int y2,
     */
     if (a > b)
       _swap_int(a, b);
-    epd_draw_hline(a, y, b - a + 1, color, framebuffer);
+    write_hline(a, y, b - a + 1, color, framebuffer);
   }
 
   // For lower part of triangle, find scanline crossings for segments
@@ -330,8 +524,16 @@ void epd_fill_triangle(int x0, int y0, int x1, int y1, int x2, int y2,
     */
     if (a > b)
       _swap_int(a, b);
-    epd_draw_hline(a, y, b - a + 1, color, framebuffer);
+    write_hline(a, y, b - a + 1, color, framebuffer);
   }
+
+  // Points are sorted by y, so only x needs a bounding box.
+  a = x0 < x1 ? x0 : x1;
+  a = a < x2 ? a : x2;
+  b = x0 > x1 ? x0 : x1;
+  b = b > x2 ? b : x2;
+  EpdRect area = {.x = a, .y = y0, .width = b - a + 1, .height = y2 - y0 + 1};
+  epd_damage_add_rotated(framebuffer, area);
 }
 
 void epd_copy_to_framebuffer(EpdRect image_area, const uint8_t *image_data,
@@ -339,32 +541,12 @@ void epd_copy_to_framebuffer(EpdRect image_area, const uint8_t *image_data,
 
   assert(framebuffer != NULL);
 
-  for (uint32_t i = 0; i < image_area.width * image_area.height; i++) {
+  epd_copy_to_framebuffer_base(image_area, image_data, framebuffer, EPD_WIDTH,
+                               EPD_HEIGHT);
 
-    uint32_t value_index = i;
-    // for images of uneven width,
-    // consume an additional nibble per row.
-    if (image_area.width % 2) {
-      value_index += i / image_area.width;
-    }
-    uint8_t val = (value_index % 2) ? (image_data[value_index / 2] & 0xF0) >> 4
-                                    : image_data[value_index / 2] & 0x0F;
-
-    int xx = image_area.x + i % image_area.width;
-    if (xx < 0 || xx >= EPD_WIDTH) {
-      continue;
-    }
-    int yy = image_area.y + i / image_area.width;
-    if (yy < 0 || yy >= EPD_HEIGHT) {
-      continue;
-    }
-    uint8_t *buf_ptr = &framebuffer[yy * EPD_WIDTH / 2 + xx / 2];
-    if (xx % 2) {
-      *buf_ptr = (*buf_ptr & 0x0F) | (val << 4);
-    } else {
-      *buf_ptr = (*buf_ptr & 0xF0) | val;
-    }
-  }
+  // Only after the pixels are in place, so an update that takes the damage
+  // never copies a half written image to its back buffer.
+  epd_damage_add(framebuffer, image_area);
 }
 
 enum EpdDrawError epd_draw_image(EpdRect area, const uint8_t *data, const EpdWaveform *waveform) {
@@ -450,13 +632,14 @@ static void draw_rotated_transparent_image(EpdRect image_area, const uint8_t *im
           if (y_offset >= epd_rotated_display_height()) continue;
           pixel_color = epd_get_pixel(x, y, image_area.width, image_area.height, image_buffer);
           if(transparent_color == NULL || pixel_color != (*transparent_color))
-              epd_draw_pixel(
+              epd_write_pixel(
                 x_offset,
                 y_offset,
                 pixel_color,
                 framebuffer);
         }
     }
+    epd_damage_add_rotated(framebuffer, image_area);
 }
 
 void epd_draw_rotated_transparent_image(EpdRect image_area, const uint8_t *image_buffer, uint8_t *framebuffer, uint8_t transparent_color) {
@@ -1,4 +1,5 @@
 #include "epd_driver.h"
+#include "draw_internal.h"
 #include "esp_assert.h"
 #include "esp_heap_caps.h"
 #include "esp_log.h"
@@ -7,6 +8,8 @@
 #else
 #include "esp32/rom/miniz.h"
 #endif
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include <math.h>
 #include <stdio.h>
 #include <string.h>
@@ -109,6 +112,203 @@ static int uncompress(uint8_t *dest, size_t uncompressed_size, const uint8_t *so
     return 0;
 }
 
+/*
+ * LRU cache of decompressed glyph bitmaps for compressed fonts,
+ * so text that is redrawn often is not decompressed every time.
+ */
+#define GLYPH_CACHE_ENTRIES 64
+
+#ifdef CONFIG_EPD_GLYPH_CACHE_SIZE
+#define GLYPH_CACHE_SIZE CONFIG_EPD_GLYPH_CACHE_SIZE
+#else
+#define GLYPH_CACHE_SIZE 0
+#endif
+
+#ifdef CONFIG_EPD_GLYPH_CACHE_SPIRAM
+#define GLYPH_CACHE_CAPS MALLOC_CAP_SPIRAM
+#else
+#define GLYPH_CACHE_CAPS (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#endif
+
+typedef struct {
+  const EpdFont *font;
+  uint32_t code_point;
+  uint8_t *bitmap;
+  uint32_t size;
+  uint32_t last_used;
+} GlyphCacheEntry;
+
+static GlyphCacheEntry glyph_cache[GLYPH_CACHE_ENTRIES];
+static uint32_t glyph_cache_clock = 0;
+static EpdGlyphCacheStats glyph_cache_stats = {0};
+
+static StaticSemaphore_t glyph_cache_lock_buffer;
+static SemaphoreHandle_t glyph_cache_lock = NULL;
+
+void epd_font_init() {
+  if (glyph_cache_lock == NULL) {
+    glyph_cache_lock = xSemaphoreCreateMutexStatic(&glyph_cache_lock_buffer);
+  }
+}
+
+static void glyph_cache_acquire() {
+  // Text drawn before epd_init would use the cache unlocked.
+  assert(glyph_cache_lock != NULL);
+  xSemaphoreTake(glyph_cache_lock, portMAX_DELAY);
+}
+
+static void glyph_cache_release() { xSemaphoreGive(glyph_cache_lock); }
+
+static void glyph_cache_evict(GlyphCacheEntry *entry) {
+  heap_caps_free(entry->bitmap);
+  glyph_cache_stats.bytes_used -= entry->size;
+  glyph_cache_stats.entries--;
+  glyph_cache_stats.evictions++;
+  memset(entry, 0, sizeof(GlyphCacheEntry));
+}
+
+/*
+ * Find the bitmap of a glyph, or decompress it into the cache.
+ * Must be called with the cache lock held, the bitmap is only valid until
+ * it is released. Returns NULL if the glyph does not fit the cache.
+ */
+static const uint8_t *glyph_cache_get(const EpdFont *font, uint32_t cp,
+                                      const EpdGlyph *glyph, uint32_t size) {
+  if (size > GLYPH_CACHE_SIZE) {
+    return NULL;
+  }
+  glyph_cache_clock++;
+
+  GlyphCacheEntry *free_entry = NULL;
+  for (int i = 0; i < GLYPH_CACHE_ENTRIES; i++) {
+    GlyphCacheEntry *entry = &glyph_cache[i];
+    if (entry->bitmap == NULL) {
+      if (free_entry == NULL) {
+        free_entry = entry;
+      }
+      continue;
+    }
+    if (entry->font == font && entry->code_point == cp) {
+      entry->last_used = glyph_cache_clock;
+      glyph_cache_stats.hits++;
+      return entry->bitmap;
+    }
+  }
+  glyph_cache_stats.misses++;
+
+  // Make room by dropping the least recently used glyphs.
+  while (free_entry == NULL ||
+         glyph_cache_stats.bytes_used + size > GLYPH_CACHE_SIZE) {
+    GlyphCacheEntry *lru = NULL;
+    for (int i = 0; i < GLYPH_CACHE_ENTRIES; i++) {
+      GlyphCacheEntry *entry = &glyph_cache[i];
+      if (entry->bitmap != NULL &&
+          (lru == NULL || entry->last_used < lru->last_used)) {
+        lru = entry;
+      }
+    }
+    if (lru == NULL) {
+      break;
+    }
+    glyph_cache_evict(lru);
+    if (free_entry == NULL) {
+      free_entry = lru;
+    }
+  }
+
+  uint8_t *bitmap = heap_caps_malloc(size, GLYPH_CACHE_CAPS);
+  if (bitmap == NULL) {
+    return NULL;
+  }
+  if (uncompress(bitmap, size, &font->bitmap[glyph->data_offset],
+                 glyph->compressed_size) != 0) {
+    heap_caps_free(bitmap);
+    return NULL;
+  }
+
+  free_entry->font = font;
+  free_entry->code_point = cp;
+  free_entry->bitmap = bitmap;
+  free_entry->size = size;
+  free_entry->last_used = glyph_cache_clock;
+  glyph_cache_stats.bytes_used += size;
+  glyph_cache_stats.entries++;
+  return bitmap;
+}
+
+EpdGlyphCacheStats epd_glyph_cache_stats() {
+  glyph_cache_acquire();
+  EpdGlyphCacheStats stats = glyph_cache_stats;
+  glyph_cache_release();
+  stats.capacity = GLYPH_CACHE_SIZE;
+  return stats;
+}
+
+void epd_glyph_cache_clear() {
+  glyph_cache_acquire();
+  for (int i = 0; i < GLYPH_CACHE_ENTRIES; i++) {
+    if (glyph_cache[i].bitmap != NULL) {
+      glyph_cache_evict(&glyph_cache[i]);
+    }
+  }
+  glyph_cache_release();
+}
+
+/*
+ * Glyph row blitters for the unrotated case. `x` is the first framebuffer
+ * column and `bx` the first bitmap column to copy, both already clipped.
+ */
+static void IRAM_ATTR blit_row_opaque(uint8_t *fb_row, int x,
+                                      const uint8_t *bm_row, int bx, int count,
+                                      const uint8_t *color_lut) {
+  if ((x & 1) == (bx & 1)) {
+    // Same nibble alignment, translate whole bytes.
+    if ((x & 1) && count > 0) {
+      fb_row[x / 2] = (fb_row[x / 2] & 0x0F) | (color_lut[bm_row[bx / 2] >> 4] << 4);
+      x++;
+      bx++;
+      count--;
+    }
+    uint8_t *dst = &fb_row[x / 2];
+    const uint8_t *src = &bm_row[bx / 2];
+    for (; count >= 2; count -= 2) {
+      uint8_t bm = *src++;
+      *dst++ = color_lut[bm & 0x0F] | (color_lut[bm >> 4] << 4);
+    }
+    if (count) {
+      *dst = (*dst & 0xF0) | color_lut[*src & 0x0F];
+    }
+    return;
+  }
+
+  for (; count > 0; count--, x++, bx++) {
+    uint8_t bm = (bx & 1) ? (bm_row[bx / 2] >> 4) : (bm_row[bx / 2] & 0x0F);
+    uint8_t *dst = &fb_row[x / 2];
+    if (x & 1) {
+      *dst = (*dst & 0x0F) | (color_lut[bm] << 4);
+    } else {
+      *dst = (*dst & 0xF0) | color_lut[bm];
+    }
+  }
+}
+
+static void IRAM_ATTR blit_row_transparent(uint8_t *fb_row, int x,
+                                           const uint8_t *bm_row, int bx,
+                                           int count, const uint8_t *color_lut) {
+  for (; count > 0; count--, x++, bx++) {
+    uint8_t bm = (bx & 1) ? (bm_row[bx / 2] >> 4) : (bm_row[bx / 2] & 0x0F);
+    if (bm == 0) {
+      continue;
+    }
+    uint8_t *dst = &fb_row[x / 2];
+    if (x & 1) {
+      *dst = (*dst & 0x0F) | (color_lut[bm] << 4);
+    } else {
+      *dst = (*dst & 0xF0) | color_lut[bm];
+    }
+  }
+}
+
 /*!
    @brief   Draw a single character to a pre-allocated buffer.
 */
@@ -120,7 +320,8 @@ static enum EpdDrawError IRAM_ATTR draw_char(const EpdFont *font, uint8_t *buffe
 
   const EpdGlyph *glyph = epd_get_glyph(font, cp);
   if (!glyph) {
-    glyph = epd_get_glyph(font, props->fallback_glyph);
+    cp = props->fallback_glyph;
+    glyph = epd_get_glyph(font, cp);
   }
 
   if (!glyph) {
@@ -134,15 +335,24 @@ static enum EpdDrawError IRAM_ATTR draw_char(const EpdFont *font, uint8_t *buffe
   int byte_width = (width / 2 + width % 2);
   unsigned long bitmap_size = byte_width * height;
   const uint8_t *bitmap = NULL;
+  uint8_t *tmp_bitmap = NULL;
+  bool cache_locked = false;
   if (bitmap_size > 0 && font->compressed) {
-    uint8_t* tmp_bitmap = (uint8_t *)malloc(bitmap_size);
-    if (tmp_bitmap == NULL && bitmap_size) {
-      ESP_LOGE("font", "malloc failed.");
-      return EPD_DRAW_FAILED_ALLOC;
+    glyph_cache_acquire();
+    cache_locked = true;
+    bitmap = glyph_cache_get(font, cp, glyph, bitmap_size);
+    if (bitmap == NULL) {
+      // too large for the cache, or the cache allocation failed
+      tmp_bitmap = (uint8_t *)malloc(bitmap_size);
+      if (tmp_bitmap == NULL) {
+        glyph_cache_release();
+        ESP_LOGE("font", "malloc failed.");
+        return EPD_DRAW_FAILED_ALLOC;
+      }
+      uncompress(tmp_bitmap, bitmap_size, &font->bitmap[offset],
+                 glyph->compressed_size);
+      bitmap = tmp_bitmap;
     }
-    uncompress(tmp_bitmap, bitmap_size, &font->bitmap[offset],
-               glyph->compressed_size);
-    bitmap = tmp_bitmap;
   } else {
     bitmap = &font->bitmap[offset];
   }
@@ -154,31 +364,58 @@ static enum EpdDrawError IRAM_ATTR draw_char(const EpdFont *font, uint8_t *buffe
   }
   bool background_needed = props->flags & EPD_DRAW_BACKGROUND;
 
-  for (int y = 0; y < height; y++) {
-    int yy = cursor_y - glyph->top + y;
-    int start_pos = *cursor_x + left;
-    bool byte_complete = start_pos % 2;
-    int x = max(0, -start_pos);
-    int max_x = start_pos + width;
-    uint8_t color;
-
-    for (int xx = start_pos; xx < max_x; xx++) {
-      uint8_t bm = bitmap[y * byte_width + x / 2];
-      if ((x & 1) == 0) {
-        bm = bm & 0xF;
-      } else {
-        bm = bm >> 4;
+  if (epd_get_rotation() == EPD_ROT_LANDSCAPE) {
+    int start_x = *cursor_x + left;
+    int start_y = cursor_y - glyph->top;
+    int x0 = max(0, start_x);
+    int x1 = min(EPD_WIDTH, start_x + width);
+    int y0 = max(0, start_y);
+    int y1 = min(EPD_HEIGHT, start_y + height);
+
+    if (x0 < x1 && y0 < y1) {
+      void (*blit_row)(uint8_t *, int, const uint8_t *, int, int, const uint8_t *) =
+          background_needed ? blit_row_opaque : blit_row_transparent;
+      for (int yy = y0; yy < y1; yy++) {
+        blit_row(&buffer[yy * EPD_WIDTH / 2], x0,
+                 &bitmap[(yy - start_y) * byte_width], x0 - start_x, x1 - x0,
+                 color_lut);
       }
-      if (background_needed || bm) {
-          color = color_lut[bm] << 4;
-          epd_draw_pixel(xx, yy, color, buffer);
+
+      // Only after the pixels are in place, so an update that takes the
+      // damage never copies a half drawn glyph to its back buffer.
+      EpdRect area = {.x = x0, .y = y0, .width = x1 - x0, .height = y1 - y0};
+      epd_damage_add(buffer, area);
+    }
+  } else {
+    for (int y = 0; y < height; y++) {
+      int yy = cursor_y - glyph->top + y;
+      int start_pos = *cursor_x + left;
+      bool byte_complete = start_pos % 2;
+      int x = max(0, -start_pos);
+      int max_x = start_pos + width;
+      uint8_t color;
+
+      for (int xx = start_pos; xx < max_x; xx++) {
+        uint8_t bm = bitmap[y * byte_width + x / 2];
+        if ((x & 1) == 0) {
+          bm = bm & 0xF;
+        } else {
+          bm = bm >> 4;
+        }
+        if (background_needed || bm) {
+            color = color_lut[bm] << 4;
+            epd_write_pixel(xx, yy, color, buffer);
+        }
+        byte_complete = !byte_complete;
+        x++;
       }
-      byte_complete = !byte_complete;
-      x++;
     }
+    EpdRect area = {.x = *cursor_x + left, .y = cursor_y - glyph->top, .width = width, .height = height};
+    epd_damage_add_rotated(buffer, area);
   }
-  if (bitmap_size > 0 && font->compressed) {
-    free((uint8_t*)bitmap);
+  free(tmp_bitmap);
+  if (cache_locked) {
+    glyph_cache_release();
   }
   *cursor_x += glyph->advance_x;
   return EPD_DRAW_SUCCESS;
@@ -38,11 +38,19 @@ EpdiyHighlevelState epd_hl_init(const EpdWaveform* waveform) {
   assert(state.difference_fb != NULL);
   state.dirty_lines = malloc(EPD_HEIGHT * sizeof(bool));
   assert(state.dirty_lines != NULL);
+  state.damage = calloc(1, sizeof(EpdDamage));
+  assert(state.damage != NULL);
+  state.forced = calloc(1, sizeof(EpdDamage));
+  assert(state.forced != NULL);
   state.waveform = waveform;
 
   memset(state.front_fb, 0xFF, fb_size);
   memset(state.back_fb, 0xFF, fb_size);
 
+  state.damage->framebuffer = state.front_fb;
+  epd_damage_record(state.damage, epd_full_screen());
+  epd_set_damage_tracker(state.damage);
+
   already_initialized = true;
   return state;
 }
@@ -94,6 +102,47 @@ EpdRect _inverse_rotated_area(uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
   return rotated;
 }
 
+static EpdRect _union_area(EpdRect a, EpdRect b) {
+  if (a.width <= 0 || a.height <= 0) {
+    return b;
+  }
+  if (b.width <= 0 || b.height <= 0) {
+    return a;
+  }
+  int x0 = a.x < b.x ? a.x : b.x;
+  int y0 = a.y < b.y ? a.y : b.y;
+  int x1 = a.x + a.width > b.x + b.width ? a.x + a.width : b.x + b.width;
+  int y1 = a.y + a.height > b.y + b.height ? a.y + a.height : b.y + b.height;
+  EpdRect u = {.x = x0, .y = y0, .width = x1 - x0, .height = y1 - y0};
+  return u;
+}
+
+/*
+ * Make every pixel of `forced` transition, as if the screen showed its inverse.
+ * Lines that had no changes were not expanded by the difference calculation,
+ * so this is done here for the whole `crop`.
+ */
+static void _force_difference(EpdiyHighlevelState* state, EpdRect crop, EpdRect forced) {
+  for (int l = forced.y; l < forced.y + forced.height; l++) {
+    const uint8_t* lfb = state->front_fb + EPD_WIDTH / 2 * l;
+    const uint8_t* lbb = state->back_fb + EPD_WIDTH / 2 * l;
+    uint8_t* ldf = state->difference_fb + EPD_WIDTH * l;
+
+    if (!state->dirty_lines[l]) {
+      for (int x = crop.x; x < crop.x + crop.width; x++) {
+        uint8_t t = (x % 2) ? (lfb[x / 2] >> 4) : (lfb[x / 2] & 0x0F);
+        uint8_t f = (x % 2) ? (lbb[x / 2] >> 4) : (lbb[x / 2] & 0x0F);
+        ldf[x] = (t << 4) | f;
+      }
+      state->dirty_lines[l] = true;
+    }
+    for (int x = forced.x; x < forced.x + forced.width; x++) {
+      uint8_t t = (x % 2) ? (lfb[x / 2] >> 4) : (lfb[x / 2] & 0x0F);
+      ldf[x] = (t << 4) | (~t & 0x0F);
+    }
+  }
+}
+
 enum EpdDrawError epd_hl_update_area(EpdiyHighlevelState* state, enum EpdDrawMode mode, int temperature, EpdRect area) {
   assert(state != NULL);
   // Not right to rotate here since this copies part of buffer directly
@@ -107,17 +156,30 @@ enum EpdDrawError epd_hl_update_area(EpdiyHighlevelState* state, enum EpdDrawMod
   area.width = rotated_area.width;
   area.height = rotated_area.height;
 
-  //FIXME: use crop information here, if available
+  // Only compare what was drawn to or forced since the last update.
+  EpdRect forced = epd_damage_take(state->forced, area);
+  EpdRect crop = _union_area(epd_damage_take(state->damage, area), forced);
+  if (crop.width == 0 || crop.height == 0) {
+      return EPD_DRAW_SUCCESS;
+  }
+
   EpdRect diff_area = epd_difference_image_cropped(
 	  state->front_fb,
 	  state->back_fb,
-	  area,
+	  crop,
 	  state->difference_fb,
 	  state->dirty_lines,
       &previously_white,
       &previously_black
   );
 
+  if (forced.width > 0 && forced.height > 0) {
+      _force_difference(state, crop, forced);
+      diff_area = _union_area(diff_area, forced);
+      previously_white = false;
+      previously_black = false;
+  }
+
   if (diff_area.height == 0 || diff_area.width == 0) {
       return EPD_DRAW_SUCCESS;
   }
@@ -149,9 +211,16 @@ enum EpdDrawError epd_hl_update_area(EpdiyHighlevelState* state, enum EpdDrawMod
 }
 
 
+void epd_hl_force_refresh_area(EpdiyHighlevelState* state, EpdRect area) {
+  assert(state != NULL);
+  EpdRect rotated_area = _inverse_rotated_area(area.x, area.y, area.width, area.height);
+  epd_damage_record(state->forced, rotated_area);
+}
+
 void epd_hl_set_all_white(EpdiyHighlevelState* state) {
   assert(state != NULL);
   memset(state->front_fb, 0xFF, fb_size);
+  epd_damage_add(state->front_fb, epd_full_screen());
 }
 
 void epd_fullclear(EpdiyHighlevelState* state, int temperature) {
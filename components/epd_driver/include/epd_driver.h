@@ -37,6 +37,20 @@ typedef struct {
   int height;
 } EpdRect;
 
+/// Maximum number of separate areas kept by an `EpdDamage` tracker.
+/// Further areas are merged into the existing ones.
+#define EPD_MAX_DAMAGE_RECTS 8
+
+/// Areas of a framebuffer that were drawn to since they were last consumed.
+typedef struct {
+  /// The framebuffer whose changes are recorded.
+  const uint8_t* framebuffer;
+  /// Damaged areas, in framebuffer (unrotated) coordinates.
+  EpdRect rects[EPD_MAX_DAMAGE_RECTS];
+  /// Number of valid entries in `rects`.
+  int count;
+} EpdDamage;
+
 /// Possible failures when drawing.
 enum EpdDrawError {
   EPD_DRAW_SUCCESS = 0x0,
@@ -186,6 +200,22 @@ typedef struct {
   enum EpdFontFlags flags;
 } EpdFontProperties;
 
+/// Usage statistics of the glyph cache of compressed fonts.
+typedef struct {
+  /// Glyphs drawn from the cache.
+  uint32_t hits;
+  /// Glyphs that had to be decompressed.
+  uint32_t misses;
+  /// Glyphs dropped to make room for others.
+  uint32_t evictions;
+  /// Number of cached glyphs.
+  uint32_t entries;
+  /// Bytes used by cached glyph bitmaps.
+  uint32_t bytes_used;
+  /// Configured cache size in bytes.
+  uint32_t capacity;
+} EpdGlyphCacheStats;
+
 /** Initialize the ePaper display */
 void epd_init(enum EpdInitOptions options);
 
@@ -237,6 +267,45 @@ void epd_clear_area_cycles(EpdRect area, int cycles, int cycle_time);
  */
 EpdRect epd_full_screen();
 
+/**
+ * Set the damage tracker the drawing and font functions report to.
+ * Only drawing to `damage->framebuffer` is recorded.
+ *
+ * @param damage: The tracker to use, or NULL to disable tracking.
+ */
+void epd_set_damage_tracker(EpdDamage* damage);
+
+/**
+ * Add an area to a damage tracker, merging it with nearby areas.
+ * Trackers may be recorded into and taken from different tasks.
+ *
+ * @param damage: The tracker to add to.
+ * @param area: The area, in framebuffer (unrotated) coordinates.
+ */
+void epd_damage_record(EpdDamage* damage, EpdRect area);
+
+/**
+ * Record a changed area of a framebuffer.
+ * This is done by all drawing functions, use it when writing
+ * to a tracked framebuffer directly. Call it after the pixels
+ * were written, an update may take the damage at any time.
+ *
+ * @param framebuffer: The framebuffer that was changed.
+ * @param area: The changed area, in framebuffer (unrotated) coordinates.
+ */
+void epd_damage_add(const uint8_t* framebuffer, EpdRect area);
+
+/**
+ * Remove the damage inside an area from a tracker.
+ * Recorded areas only partially inside `area` are kept.
+ *
+ * @param damage: The tracker to consume from.
+ * @param area: The area of interest.
+ * @returns The bounding box of all recorded damage within `area`.
+ *      Its width and height are 0 if nothing was damaged.
+ */
+EpdRect epd_damage_take(EpdDamage* damage, EpdRect area);
+
 /**
  * Draw a picture to a given framebuffer.
  *
@@ -422,6 +491,16 @@ enum EpdDrawError epd_write_default(const EpdFont *font, const char *string, int
  */
 const EpdGlyph* epd_get_glyph(const EpdFont *font, uint32_t code_point);
 
+/**
+ * Get usage statistics of the cache for decompressed glyphs.
+ */
+EpdGlyphCacheStats epd_glyph_cache_stats();
+
+/**
+ * Drop all cached glyph bitmaps and free their memory.
+ */
+void epd_glyph_cache_clear();
+
 
 /**
  * Darken / lighten an area for a given time.
@@ -470,7 +549,8 @@ enum EpdDrawError epd_draw_base(EpdRect area,
  * @param to: The goal image as 4-bpp (`MODE_PACKING_2PPB`) framebuffer.
  * @param from: The previous image as 4-bpp (`MODE_PACKING_2PPB`) framebuffer.
  * @param crop_to: Only calculate the difference for a crop of the input framebuffers.
- *      The `interlaced` will not be modified outside the crop area.
+ *      The `interlaced` will not be modified outside the crop area,
+ *      and only lines marked in `dirty_lines` are written.
  * @param interlaced: The resulting difference image in `MODE_PACKING_1PPB_DIFFERENCE` format.
  * @param dirty_lines: An array of at least `EPD_HEIGHT`.
  *      The positions corresponding to lines where `to` and `from` differ
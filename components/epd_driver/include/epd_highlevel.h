@@ -76,6 +76,10 @@ typedef struct {
   uint8_t* difference_fb;
   /// Tainted lines based on the last difference calculation.
   bool* dirty_lines;
+  /// Areas of the front framebuffer drawn to since they were last updated.
+  EpdDamage* damage;
+  /// Areas to redraw completely on the next update, regardless of their content.
+  EpdDamage* forced;
   /// The waveform information to use.
   const EpdWaveform* waveform;
 } EpdiyHighlevelState;
@@ -114,7 +118,8 @@ enum EpdDrawError epd_hl_update_screen(EpdiyHighlevelState* state, enum EpdDrawM
 
 /**
  * Update an area of the screen to match the content of the front framebuffer.
- * Supplying a small area to update can speed up the update process.
+ * Only the parts of `area` drawn to since the last update are compared,
+ * supplying a small area to update can speed up the update process further.
  * Prior to this, power to the display must be enabled via `epd_poweron()`
  * and should be disabled afterwards if no immediate additional updates follow.
  *
@@ -126,6 +131,16 @@ enum EpdDrawError epd_hl_update_screen(EpdiyHighlevelState* state, enum EpdDrawM
  */
 enum EpdDrawError epd_hl_update_area(EpdiyHighlevelState* state, enum EpdDrawMode mode, int temperature, EpdRect area);
 
+/**
+ * Redraw an area completely on the next update covering it,
+ * even where the front framebuffer did not change.
+ * Use this to get rid of ghosting instead of clearing the area.
+ *
+ * @param state: A reference to the `EpdiyHighlevelState` object used.
+ * @param area: Area of the screen to redraw.
+ */
+void epd_hl_force_refresh_area(EpdiyHighlevelState* state, EpdRect area);
+
 /**
  * Reset the front framebuffer to a white state.
  *
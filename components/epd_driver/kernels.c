@@ -0,0 +1,226 @@
+#include "kernels.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+
+static inline int min(int x, int y) { return x < y ? x : y; }
+static inline int max(int x, int y) { return x > y ? x : y; }
+
+// Fold the eight 4bpp pixels of a framebuffer word into a single nibble.
+static inline uint8_t nibble_or(uint32_t w) {
+  w |= w >> 16;
+  w |= w >> 8;
+  w |= w >> 4;
+  return w & 0x0F;
+}
+
+static inline uint8_t nibble_and(uint32_t w) {
+  w &= w >> 16;
+  w &= w >> 8;
+  w &= w >> 4;
+  return w & 0x0F;
+}
+
+static inline bool word_aligned(const uint8_t* a, const uint8_t* b, int x) {
+  return (x % 2) == 0 && ((uintptr_t)a & 3) == 0 && ((uintptr_t)b & 3) == 0;
+}
+
+EpdRect epd_difference_image_base(
+    const uint8_t* to,
+    const uint8_t* from,
+    EpdRect crop_to,
+    int fb_width,
+    int fb_height,
+    uint8_t* interlaced,
+    bool* dirty_lines,
+    uint8_t* from_or,
+    uint8_t* from_and
+) {
+    assert(from_or != NULL);
+    assert(from_and != NULL);
+    // OR over all pixels of the "from"-image
+    uint8_t or_acc = 0x00;
+    // AND over all pixels of the "from"-image
+    uint8_t and_acc = 0x0F;
+    // Same, but accumulated over whole words and folded at the end.
+    uint32_t or_word = 0x00000000;
+    uint32_t and_word = 0xFFFFFFFF;
+
+    int x_end = min(fb_width, crop_to.x + crop_to.width);
+    int y_end = min(fb_height, crop_to.y + crop_to.height);
+    int min_x = x_end;
+    int max_x = crop_to.x - 1;
+
+    for (int y=crop_to.y; y < y_end; y++) {
+        const uint8_t* to_row = to + y * fb_width / 2;
+        const uint8_t* from_row = from + y * fb_width / 2;
+        bool dirty = false;
+        int x = crop_to.x;
+
+        // Compare pixel-wise until both rows are word aligned, then
+        // eight pixels at a time. Identical words only feed the OR / AND.
+        while (x < x_end && !word_aligned(to_row + x / 2, from_row + x / 2, x)) {
+            uint8_t t = to_row[x / 2];
+            t = (x % 2) ? (t >> 4) : (t & 0x0f);
+            uint8_t f = from_row[x / 2];
+            f = (x % 2) ? (f >> 4) : (f & 0x0f);
+            or_acc |= f;
+            and_acc &= f;
+            if (t != f) {
+                dirty = true;
+                min_x = min(min_x, x);
+                max_x = max(max_x, x);
+            }
+            x++;
+        }
+        for (; x + 8 <= x_end; x += 8) {
+            uint32_t tw = *(const uint32_t*)(to_row + x / 2);
+            uint32_t fw = *(const uint32_t*)(from_row + x / 2);
+            or_word |= fw;
+            and_word &= fw;
+            uint32_t diff = tw ^ fw;
+            if (diff) {
+                dirty = true;
+                // little endian: nibble k of the word is pixel x + k
+                min_x = min(min_x, x + __builtin_ctz(diff) / 4);
+                max_x = max(max_x, x + (31 - __builtin_clz(diff)) / 4);
+            }
+        }
+        for (; x < x_end; x++) {
+            uint8_t t = to_row[x / 2];
+            t = (x % 2) ? (t >> 4) : (t & 0x0f);
+            uint8_t f = from_row[x / 2];
+            f = (x % 2) ? (f >> 4) : (f & 0x0f);
+            or_acc |= f;
+            and_acc &= f;
+            if (t != f) {
+                dirty = true;
+                min_x = min(min_x, x);
+                max_x = max(max_x, x);
+            }
+        }
+
+        dirty_lines[y] = dirty;
+        if (!dirty) {
+            // Clean lines are skipped when drawing, so their
+            // interlaced data is never read.
+            continue;
+        }
+
+        uint8_t* out = interlaced + y * fb_width;
+        x = crop_to.x;
+        if (x < x_end && x % 2) {
+            out[x] = (to_row[x / 2] & 0xF0) | (from_row[x / 2] >> 4);
+            x++;
+        }
+        for (; x + 2 <= x_end; x += 2) {
+            uint8_t t = to_row[x / 2];
+            uint8_t f = from_row[x / 2];
+            out[x] = (t << 4) | (f & 0x0F);
+            out[x + 1] = (t & 0xF0) | (f >> 4);
+        }
+        if (x < x_end) {
+            out[x] = (to_row[x / 2] << 4) | (from_row[x / 2] & 0x0F);
+        }
+    }
+
+    *from_or = or_acc | nibble_or(or_word);
+    *from_and = and_acc & nibble_and(and_word);
+
+    int min_y, max_y;
+    for (min_y = crop_to.y; min_y < y_end; min_y++) {
+      if (dirty_lines[min_y] != 0) break;
+    }
+    for (max_y = y_end - 1; max_y >= crop_to.y; max_y--) {
+      if (dirty_lines[max_y] != 0) break;
+    }
+    EpdRect crop_rect = {
+      .x = min_x,
+      .y = min_y,
+      .width = max(max_x - min_x + 1, 0),
+      .height = max(max_y - min_y + 1, 0),
+    };
+    return crop_rect;
+}
+
+/*
+ * Copy `count` pixels (nibbles) starting at nibble `src_x` of `src`
+ * to nibble `dst_x` of `dst`.
+ */
+static void copy_nibbles(uint8_t *dst, int dst_x, const uint8_t *src, int src_x,
+                         int count) {
+  dst += dst_x / 2;
+  src += src_x / 2;
+
+  if (dst_x % 2 == src_x % 2) {
+    // Same alignment: fix up the half bytes at the edges, copy the rest.
+    if (dst_x % 2 && count > 0) {
+      *dst = (*dst & 0x0F) | (*src & 0xF0);
+      dst++;
+      src++;
+      count--;
+    }
+    memcpy(dst, src, count / 2);
+    if (count % 2) {
+      dst[count / 2] = (dst[count / 2] & 0xF0) | (src[count / 2] & 0x0F);
+    }
+    return;
+  }
+
+  // Alignment differs by one nibble, every output byte is made of two
+  // neighbouring source bytes.
+  if (dst_x % 2 && count > 0) {
+    // destination high nibble <- source low nibble
+    *dst = (*dst & 0x0F) | (*src << 4);
+    dst++;
+    count--;
+    // continue with the source high nibble, destination is aligned now.
+    for (; count >= 2; count -= 2) {
+      *dst++ = (src[0] >> 4) | (src[1] << 4);
+      src++;
+    }
+    if (count) {
+      *dst = (*dst & 0xF0) | (*src >> 4);
+    }
+    return;
+  }
+
+  // destination aligned, source starts at a high nibble
+  for (; count >= 2; count -= 2) {
+    *dst++ = (src[0] >> 4) | (src[1] << 4);
+    src++;
+  }
+  if (count) {
+    *dst = (*dst & 0xF0) | (*src >> 4);
+  }
+}
+
+void epd_copy_to_framebuffer_base(EpdRect image_area, const uint8_t *image_data,
+                                  uint8_t *framebuffer, int fb_width,
+                                  int fb_height) {
+  // Clip once against the framebuffer, then copy visible row segments.
+  int x_start = image_area.x < 0 ? 0 : image_area.x;
+  int y_start = image_area.y < 0 ? 0 : image_area.y;
+  int x_end = image_area.x + image_area.width;
+  int y_end = image_area.y + image_area.height;
+  if (x_end > fb_width) {
+    x_end = fb_width;
+  }
+  if (y_end > fb_height) {
+    y_end = fb_height;
+  }
+  if (x_start >= x_end || y_start >= y_end) {
+    return;
+  }
+
+  // for images of uneven width, rows are padded by a nibble.
+  int src_stride = (image_area.width + 1) / 2;
+  int src_x = x_start - image_area.x;
+
+  for (int yy = y_start; yy < y_end; yy++) {
+    const uint8_t *src_row = image_data + (yy - image_area.y) * src_stride;
+    uint8_t *dst_row = framebuffer + yy * fb_width / 2;
+    copy_nibbles(dst_row, x_start, src_row, src_x, x_end - x_start);
+  }
+}
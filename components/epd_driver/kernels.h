@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "epd_driver.h"
+
+///////////////////////////// Framebuffer kernels /////////////////////////////
+//
+// Pure pixel loops over 4bpp framebuffers. These don't touch hardware or RTOS
+// primitives, so they can also be built and checked on the host.
+
+/*
+ * Compare the `to` and `from` framebuffers of `fb_width` x `fb_height` within
+ * `crop_to`, and write the interlaced 1PPB (to << 4 | from) data of every
+ * changed line to `interlaced`. `dirty_lines` is set for every line of the
+ * crop area, and `from_or` / `from_and` receive the OR / AND over all pixels
+ * of `from`. Returns the bounding box of the changed pixels.
+ */
+EpdRect epd_difference_image_base(
+    const uint8_t* to,
+    const uint8_t* from,
+    EpdRect crop_to,
+    int fb_width,
+    int fb_height,
+    uint8_t* interlaced,
+    bool* dirty_lines,
+    uint8_t* from_or,
+    uint8_t* from_and
+);
+
+/*
+ * Copy a packed 4bpp image (rows of uneven width padded by a nibble) to
+ * `image_area` of a `fb_width` x `fb_height` framebuffer, clipping anything
+ * outside of it. Does not record damage, see epd_copy_to_framebuffer.
+ */
+void epd_copy_to_framebuffer_base(EpdRect image_area, const uint8_t *image_data,
+                                  uint8_t *framebuffer, int fb_width,
+                                  int fb_height);
@@ -1,9 +1,11 @@
 #include "epd_temperature.h"
 #include "display_ops.h"
+#include "draw_internal.h"
 #include "epd_driver.h"
 #include "include/epd_driver.h"
 #include "include/epd_internals.h"
 #include "include/epd_board.h"
+#include "kernels.h"
 #include "lut.h"
 
 #include "esp_types.h"
@@ -15,9 +17,6 @@
 #include "xtensa/core-macros.h"
 #include <string.h>
 
-inline int min(int x, int y) { return x < y ? x : y; }
-inline int max(int x, int y) { return x > y ? x : y; }
-
 const int clear_cycle_time = 12;
 
 const int DEFAULT_FRAME_TIME = 120;
@@ -251,6 +250,7 @@ void epd_init(enum EpdInitOptions options) {
 
   epd_hw_init(EPD_WIDTH);
   epd_temperature_init();
+  epd_font_init();
 
   size_t lut_size = 0;
   if (options & EPD_LUT_1K) {
@@ -299,65 +299,6 @@ void epd_init(enum EpdInitOptions options) {
 
 }
 
-EpdRect epd_difference_image_base(
-    const uint8_t* to,
-    const uint8_t* from,
-    EpdRect crop_to,
-    int fb_width,
-    int fb_height,
-    uint8_t* interlaced,
-    bool* dirty_lines,
-    uint8_t* from_or,
-    uint8_t* from_and
-) {
-    assert(from_or != NULL);
-    assert(from_and != NULL);
-    // OR over all pixels of the "from"-image
-    *from_or = 0x00;
-    // AND over all pixels of the "from"-image
-    *from_and = 0x0F;
-
-    uint8_t dirty_cols[EPD_WIDTH] = {0};
-    int x_end = min(fb_width, crop_to.x + crop_to.width);
-    int y_end = min(fb_height, crop_to.y + crop_to.height);
-
-    for (int y=crop_to.y; y < y_end; y++) {
-        uint8_t dirty = 0;
-        for (int x = crop_to.x; x < x_end; x++) {
-            uint8_t t = *(to + y*fb_width / 2 + x / 2);
-            t = (x % 2) ? (t >> 4) : (t & 0x0f);
-            uint8_t f = *(from + y*fb_width / 2+ x / 2);
-            f = (x % 2) ? (f >> 4) : (f & 0x0f);
-            *from_or |= f;
-            *from_and &= f;
-            dirty |= (t ^ f);
-            dirty_cols[x] |= (t ^ f);
-            interlaced[y * fb_width + x] = (t << 4) | f;
-        }
-        dirty_lines[y] = dirty > 0;
-    }
-    int min_x, min_y, max_x, max_y;
-    for (min_x = crop_to.x; min_x < x_end; min_x++) {
-      if (dirty_cols[min_x] != 0) break;
-    }
-    for (max_x = x_end - 1; max_x >= crop_to.x; max_x--) {
-      if (dirty_cols[max_x] != 0) break;
-    }
-    for (min_y = crop_to.y; min_y < y_end; min_y++) {
-      if (dirty_lines[min_y] != 0) break;
-    }
-    for (max_y = y_end - 1; max_y >= crop_to.y; max_y--) {
-      if (dirty_lines[max_y] != 0) break;
-    }
-    EpdRect crop_rect = {
-      .x = min_x,
-      .y = min_y,
-      .width = max(max_x - min_x + 1, 0),
-      .height = max(max_y - min_y + 1, 0),
-    };
-    return crop_rect;
-}
-
 EpdRect epd_difference_image(
     const uint8_t* to,
     const uint8_t* from,
@@ -150,7 +150,7 @@ def configure_weather_mode(current_config):
         assert 0
 
 
-    return {
+    body = {
         "spot_name": spot_name,
         "spot_lat": spot_lat,
         "spot_lon": spot_lon,
@@ -159,6 +159,20 @@ def configure_weather_mode(current_config):
         "active_chart_2": active_chart_2,
     }
 
+    # Older firmware doesn't have schedules, skip asking about them
+    schedule_keys = ["conditions_schedule", "tide_chart_schedule", "swell_chart_schedule", "wind_chart_schedule"]
+    if all(key in current_config for key in schedule_keys):
+        print()
+        y_n = input("Change how often conditions and charts update? (y/N): ")
+        if y_n == "y":
+            print("Schedules are '<minute> <hour>' like cron, e.g. '5 *' for five past every hour or '0 3,12,17' for three times a day")
+            for key in schedule_keys:
+                schedule = input(f"{key} (press enter to keep as '{current_config[key]}'): ")
+                if schedule:
+                    body[key] = schedule
+
+    return body
+
 
 def configure_custom_mode(current_config):
     custom_screen_url = ""
@@ -224,6 +238,11 @@ def configure():
         print(f"Spot name: {current_config['spot_name']}")
         print(f"Chart 1: {current_config['active_chart_1']}")
         print(f"Chart 2: {current_config['active_chart_2']}")
+        if "conditions_schedule" in current_config:
+            print(f"Conditions schedule: {current_config['conditions_schedule']}")
+            print(f"Tide chart schedule: {current_config['tide_chart_schedule']}")
+            print(f"Swell chart schedule: {current_config['swell_chart_schedule']}")
+            print(f"Wind chart schedule: {current_config['wind_chart_schedule']}")
     elif current_config['operating_mode'] == "custom":
         print(f"Custom external URL: {current_config['custom_screen_url']}")
         print(f"Screen update interval (seconds): {int(current_config['custom_update_interval_secs'])}")
@@ -0,0 +1,241 @@
+#include <string.h>
+
+#include "memfault/panics/assert.h"
+
+#include "batch_fetch.h"
+#include "conditions_bin.h"
+#include "constants.h"
+#include "http_client.h"
+#include "http_queue.h"
+#include "nvs.h"
+#include "screen_img_handler.h"
+#include "spot_check.h"
+
+// Must included below constants.h where we overwite the define of LOG_LOCAL_LEVEL
+#include "log.h"
+
+#define TAG SC_TAG_BATCH_FETCH
+
+// Demultiplexing state for a batch response, fed chunk by chunk as it's read
+typedef struct {
+    uint32_t                       requested;
+    uint8_t                        header_buf[sizeof(batch_part_header_t)];
+    size_t                         header_len;
+    batch_part_header_t            part;
+    size_t                         part_remaining;
+    bool                           parsing_conditions;
+    spot_check_conditions_parser_t conditions_parser;
+    screen_img_save_ctx_t          img;
+    conditions_t                  *conditions;
+    uint32_t                       saved;
+    uint32_t                       unchanged;
+} batch_fetch_ctx_t;
+
+static const char *resource_strs[BATCH_RESOURCE_COUNT] = {
+    [BATCH_RESOURCE_CONDITIONS]  = "conditions",
+    [BATCH_RESOURCE_TIDE_CHART]  = "tides_chart",
+    [BATCH_RESOURCE_SWELL_CHART] = "swell_chart",
+    [BATCH_RESOURCE_WIND_CHART]  = "wind_chart",
+};
+
+static const screen_img_t resource_screen_imgs[BATCH_RESOURCE_COUNT] = {
+    [BATCH_RESOURCE_CONDITIONS]  = SCREEN_IMG_COUNT,
+    [BATCH_RESOURCE_TIDE_CHART]  = SCREEN_IMG_TIDE_CHART,
+    [BATCH_RESOURCE_SWELL_CHART] = SCREEN_IMG_SWELL_CHART,
+    [BATCH_RESOURCE_WIND_CHART]  = SCREEN_IMG_WIND_CHART,
+};
+
+// Set once the server responds to a batch request with a status saying it doesn't have the endpoint, so older servers
+// only cost one extra request per boot
+static bool batch_unsupported = false;
+
+/*
+ * Set up the sink for the part whose header was just received. Parts that weren't requested, that the server failed
+ * to produce, or that can't be stored are skipped.
+ */
+static void batch_fetch_start_part(batch_fetch_ctx_t *ctx) {
+    memcpy(&ctx->part, ctx->header_buf, sizeof(batch_part_header_t));
+    ctx->part_remaining = ctx->part.length;
+
+    log_printf(LOG_LEVEL_DEBUG,
+               "Batch part for resource %u, status %u, %lu bytes",
+               ctx->part.resource,
+               ctx->part.status,
+               ctx->part.length);
+
+    if (ctx->part.resource >= BATCH_RESOURCE_COUNT || !(ctx->requested & BATCH_RESOURCE_BIT(ctx->part.resource))) {
+        log_printf(LOG_LEVEL_WARN, "Skipping unrequested batch resource %u", ctx->part.resource);
+        return;
+    }
+
+    if (ctx->part.status != 0) {
+        log_printf(LOG_LEVEL_WARN,
+                   "Server failed to produce batch resource '%s' (status %u)",
+                   resource_strs[ctx->part.resource],
+                   ctx->part.status);
+        return;
+    }
+
+    if (ctx->part.resource == BATCH_RESOURCE_CONDITIONS) {
+        spot_check_conditions_parser_init(&ctx->conditions_parser);
+        ctx->parsing_conditions = true;
+    } else {
+        screen_img_handler_save_start(resource_screen_imgs[ctx->part.resource], &ctx->img);
+    }
+}
+
+/*
+ * Hand off a completed part to wherever it's stored. If complete is false the response ended partway through the part,
+ * so it's thrown away and anything previously stored for the resource is kept.
+ */
+static void batch_fetch_end_part(batch_fetch_ctx_t *ctx, bool complete) {
+    batch_resource_t resource = ctx->part.resource;
+
+    if (ctx->parsing_conditions) {
+        if (complete && spot_check_conditions_parser_finish(&ctx->conditions_parser, ctx->conditions)) {
+            ctx->saved |= BATCH_RESOURCE_BIT(resource);
+        }
+        ctx->parsing_conditions = false;
+    } else if (ctx->img.started) {
+        bool unchanged = false;
+        if (screen_img_handler_save_finish(&ctx->img, complete, &unchanged)) {
+            ctx->saved |= BATCH_RESOURCE_BIT(resource);
+            if (unchanged) {
+                ctx->unchanged |= BATCH_RESOURCE_BIT(resource);
+            }
+        }
+    }
+
+    ctx->header_len     = 0;
+    ctx->part_remaining = 0;
+}
+
+/*
+ * http_client chunk callback, splits the response back up into its parts.
+ */
+static void batch_fetch_demux_chunk(const uint8_t *chunk, size_t chunk_size, size_t offset, void *arg) {
+    (void)offset;
+    batch_fetch_ctx_t *ctx = (batch_fetch_ctx_t *)arg;
+
+    while (chunk_size > 0) {
+        if (ctx->header_len < sizeof(batch_part_header_t)) {
+            size_t header_bytes = MIN(chunk_size, sizeof(batch_part_header_t) - ctx->header_len);
+            memcpy(ctx->header_buf + ctx->header_len, chunk, header_bytes);
+            ctx->header_len += header_bytes;
+            chunk += header_bytes;
+            chunk_size -= header_bytes;
+
+            if (ctx->header_len == sizeof(batch_part_header_t)) {
+                batch_fetch_start_part(ctx);
+                if (ctx->part_remaining == 0) {
+                    batch_fetch_end_part(ctx, true);
+                }
+            }
+            continue;
+        }
+
+        size_t part_bytes = MIN(chunk_size, ctx->part_remaining);
+        if (ctx->parsing_conditions) {
+            spot_check_conditions_parser_feed(&ctx->conditions_parser, (const char *)chunk, part_bytes);
+        } else if (ctx->img.started) {
+            screen_img_handler_save_write(&ctx->img, chunk, part_bytes);
+        }
+        chunk += part_bytes;
+        chunk_size -= part_bytes;
+        ctx->part_remaining -= part_bytes;
+
+        if (ctx->part_remaining == 0) {
+            batch_fetch_end_part(ctx, true);
+        }
+    }
+}
+
+/*
+ * Download every resource in the resources bitmask (BATCH_RESOURCE_BIT of each batch_resource_t) with one request.
+ * Conditions are parsed into new_conditions, images are saved to flash the same way as their own download would. Each
+ * resource is handled on its own: saved has a bit for every resource that was received and stored successfully, and
+ * unchanged for every image that was identical to the stored one. Anything not in saved should be fetched with its
+ * own request.
+ *
+ * Returns false if the request failed altogether or the server doesn't support batching, in which case nothing was
+ * touched.
+ */
+bool batch_fetch_download_and_save(uint32_t      resources,
+                                   conditions_t *new_conditions,
+                                   uint32_t     *saved,
+                                   uint32_t     *unchanged) {
+    MEMFAULT_ASSERT(new_conditions);
+    MEMFAULT_ASSERT(saved);
+    MEMFAULT_ASSERT(unchanged);
+
+    *saved     = 0;
+    *unchanged = 0;
+
+    if (batch_unsupported || resources == 0) {
+        return false;
+    }
+
+    char resources_str[64] = {0};
+    for (int i = 0; i < BATCH_RESOURCE_COUNT; i++) {
+        if (resources & BATCH_RESOURCE_BIT(i)) {
+            if (resources_str[0] != '\0') {
+                strcat(resources_str, ",");
+            }
+            strcat(resources_str, resource_strs[i]);
+        }
+    }
+
+    spot_check_config_t *config = nvs_get_config();
+    char                 url_buf[strlen(URL_BASE) + 80];
+    query_param          params[6];
+    http_request_t       request = http_client_build_get_request("batch", config, url_buf, params, 4);
+
+    // Build only fills in the params shared by every endpoint. Format is passed through to the conditions part.
+    params[4]                   = (query_param){.key = "resources", .value = resources_str};
+    params[5]                   = (query_param){.key = CONDITIONS_BIN_QUERY_KEY, .value = CONDITIONS_BIN_QUERY_VALUE};
+    request.get_args.num_params = 6;
+    request.get_args.optional   = true;
+
+    batch_fetch_ctx_t ctx = {
+        .requested  = resources,
+        .conditions = new_conditions,
+    };
+    http_queue_req_t queue_req = {
+        .request = &request,
+        .sink    = HTTP_QUEUE_SINK_CB,
+        .cb =
+            {
+                .chunk_cb     = batch_fetch_demux_chunk,
+                .chunk_cb_ctx = &ctx,
+            },
+    };
+    bool success = http_queue_run(&queue_req, HTTP_QUEUE_PRIORITY_HIGH);
+    if (!success && queue_req.bytes_received == 0) {
+        if (request.status == 404 || request.status == 501) {
+            log_printf(LOG_LEVEL_INFO, "Server doesn't support batch requests (%d), not trying again", request.status);
+            batch_unsupported = true;
+        } else {
+            log_printf(LOG_LEVEL_ERROR, "Error making batch request");
+        }
+        return false;
+    }
+
+    // Response cut off partway through a part
+    if (ctx.header_len > 0) {
+        log_printf(LOG_LEVEL_ERROR,
+                   "Batch response ended in the middle of a part after %zu bytes",
+                   queue_req.bytes_received);
+        batch_fetch_end_part(&ctx, false);
+    }
+
+    log_printf(LOG_LEVEL_INFO,
+               "Batch request %s, saved resources 0x%02lX of 0x%02lX (unchanged 0x%02lX)",
+               success ? "finished" : "failed",
+               ctx.saved,
+               resources,
+               ctx.unchanged);
+
+    *saved     = ctx.saved;
+    *unchanged = ctx.unchanged;
+    return true;
+}
@@ -0,0 +1,200 @@
+#include <stdio.h>
+#include <time.h>
+
+#include "memfault/panics/assert.h"
+
+#include "chart.h"
+#include "constants.h"
+#include "display.h"
+
+// Must included below constants.h where we overwite the define of LOG_LOCAL_LEVEL
+#include "log.h"
+
+#define TAG SC_TAG_CHART
+
+// Plot area inside the chart, the margins hold the title and axis labels
+#define PLOT_LEFT_PX (48)
+#define PLOT_RIGHT_PX (12)
+#define PLOT_TOP_PX (28)
+#define PLOT_BOTTOM_PX (26)
+#define PLOT_WIDTH_PX (CHART_WIDTH_PX - PLOT_LEFT_PX - PLOT_RIGHT_PX)
+#define PLOT_HEIGHT_PX (CHART_HEIGHT_PX - PLOT_TOP_PX - PLOT_BOTTOM_PX)
+
+#define CHART_X_LABEL_INTERVAL_HOURS (6)
+#define CHART_Y_LABEL_COUNT (3)
+#define CHART_MARKER_SIZE_PX (6)
+
+typedef struct {
+    const char *title;
+    uint16_t    divisor;    // Raw value units per displayed unit
+    uint8_t     decimals;   // For the axis labels
+    bool        from_zero;  // Axis always includes 0, anything that can't be negative
+    bool        filled;     // Area under the line filled in
+} chart_series_info_t;
+
+static const chart_series_info_t series_infos[CHART_SERIES_COUNT] = {
+    [CHART_SERIES_TIDE] =
+        {
+            .title     = "Tide (ft.)",
+            .divisor   = 100,
+            .decimals  = 1,
+            .from_zero = false,
+            .filled    = true,
+        },
+    [CHART_SERIES_SWELL] =
+        {
+            .title     = "Swell (ft.)",
+            .divisor   = 10,
+            .decimals  = 1,
+            .from_zero = true,
+            .filled    = true,
+        },
+    [CHART_SERIES_WIND] =
+        {
+            .title     = "Wind (kt.)",
+            .divisor   = 1,
+            .decimals  = 0,
+            .from_zero = true,
+            .filled    = false,
+        },
+};
+
+static int32_t chart_get_value(chart_series_t series, const forecast_entry_t *entry) {
+    switch (series) {
+        case CHART_SERIES_TIDE:
+            return entry->tide_height_cft;
+        case CHART_SERIES_SWELL:
+            return entry->swell_height_dft;
+        case CHART_SERIES_WIND:
+            return entry->wind_speed;
+        default:
+            MEMFAULT_ASSERT(0);
+    }
+}
+
+static inline uint32_t chart_x_for_time(uint32_t plot_x, time_t start_epoch_secs, time_t epoch_secs) {
+    time_t offset = MIN(epoch_secs - start_epoch_secs, (time_t)CHART_HOURS * FORECAST_INTERVAL_SECS);
+    return plot_x + (uint32_t)(offset * PLOT_WIDTH_PX / ((time_t)CHART_HOURS * FORECAST_INTERVAL_SECS));
+}
+
+static inline uint32_t chart_y_for_value(uint32_t plot_y, int32_t min, int32_t max, int32_t value) {
+    return plot_y + PLOT_HEIGHT_PX - (uint32_t)((int64_t)(value - min) * PLOT_HEIGHT_PX / (max - min));
+}
+
+/*
+ * Whether the cached series has enough hours ahead to draw a chart from it instead of downloading one
+ */
+bool chart_can_draw(const forecast_t *forecast) {
+    return forecast != NULL && forecast_get_count(forecast) >= CHART_MIN_HOURS;
+}
+
+/*
+ * Draw a CHART_WIDTH_PX x CHART_HEIGHT_PX chart of the next CHART_HOURS of series into the framebuffer with its top
+ * left corner at x, y, with a marker at the current time. Caller clears the area first. Expired entries must already be
+ * dropped from forecast, the chart starts at its first entry.
+ */
+void chart_draw(chart_series_t series, const forecast_t *forecast, time_t now_epoch_secs, uint32_t x, uint32_t y) {
+    MEMFAULT_ASSERT(series < CHART_SERIES_COUNT);
+    MEMFAULT_ASSERT(forecast);
+
+    const chart_series_info_t *info       = &series_infos[series];
+    const uint32_t             plot_x     = x + PLOT_LEFT_PX;
+    const uint32_t             plot_y     = y + PLOT_TOP_PX;
+    const uint32_t             plot_y_end = plot_y + PLOT_HEIGHT_PX;
+    const uint8_t              num_points = MIN(forecast_get_count(forecast), CHART_HOURS + 1);
+    if (num_points < 2) {
+        log_printf(LOG_LEVEL_WARN, "Not enough forecast entries to draw %s chart", info->title);
+        return;
+    }
+
+    time_t start_epoch_secs = 0;
+    forecast_get_entry(forecast, 0, &start_epoch_secs);
+
+    // Y axis range over everything that's shown, padded so the line never sits on the top edge
+    int32_t min = INT32_MAX;
+    int32_t max = INT32_MIN;
+    for (uint8_t i = 0; i < num_points; i++) {
+        int32_t value = chart_get_value(series, forecast_get_entry(forecast, i, NULL));
+        min           = MIN(min, value);
+        max           = MAX(max, value);
+    }
+    if (info->from_zero) {
+        min = MIN(min, 0);
+    }
+    max += MAX((max - min) / 10, (int32_t)info->divisor);
+
+    // Grid lines and y labels
+    char label[12];
+    for (uint8_t i = 0; i < CHART_Y_LABEL_COUNT; i++) {
+        int32_t  value   = min + (max - min) * i / (CHART_Y_LABEL_COUNT - 1);
+        uint32_t value_y = chart_y_for_value(plot_y, min, max, value);
+        if (i > 0) {
+            display_draw_hline(plot_x, value_y, PLOT_WIDTH_PX, DISPLAY_COLOR_LIGHT_GRAY);
+        }
+
+        snprintf(label, sizeof(label), "%.*f", info->decimals, (double)value / info->divisor);
+        display_draw_text(label, plot_x - 6, value_y + 5, DISPLAY_FONT_SIZE_SMALL, DISPLAY_FONT_ALIGN_RIGHT);
+    }
+
+    // Series, filled area first so the line is drawn over it. Line is doubled up to be readable on the panel.
+    for (uint8_t i = 0; i + 1 < num_points; i++) {
+        time_t                  epoch_secs = 0;
+        const forecast_entry_t *entry      = forecast_get_entry(forecast, i, &epoch_secs);
+        uint32_t                x0         = chart_x_for_time(plot_x, start_epoch_secs, epoch_secs);
+        uint32_t                y0         = chart_y_for_value(plot_y, min, max, chart_get_value(series, entry));
+
+        entry       = forecast_get_entry(forecast, i + 1, &epoch_secs);
+        uint32_t x1 = chart_x_for_time(plot_x, start_epoch_secs, epoch_secs);
+        uint32_t y1 = chart_y_for_value(plot_y, min, max, chart_get_value(series, entry));
+
+        if (info->filled) {
+            display_fill_triangle(x0, y0, x1, y1, x0, plot_y_end, DISPLAY_COLOR_LIGHT_GRAY);
+            display_fill_triangle(x1, y1, x1, plot_y_end, x0, plot_y_end, DISPLAY_COLOR_LIGHT_GRAY);
+        }
+        display_draw_line(x0, y0, x1, y1, DISPLAY_COLOR_BLACK);
+        display_draw_line(x0, y0 - 1, x1, y1 - 1, DISPLAY_COLOR_BLACK);
+    }
+
+    // Axes, with x labels on local hours that are a multiple of the label interval
+    display_draw_hline(plot_x, plot_y_end, PLOT_WIDTH_PX, DISPLAY_COLOR_BLACK);
+    display_draw_vline(plot_x, plot_y, PLOT_HEIGHT_PX, DISPLAY_COLOR_BLACK);
+    for (uint8_t i = 0; i < num_points; i++) {
+        time_t    epoch_secs = 0;
+        struct tm local      = {0};
+        forecast_get_entry(forecast, i, &epoch_secs);
+        localtime_r(&epoch_secs, &local);
+        if (local.tm_hour % CHART_X_LABEL_INTERVAL_HOURS != 0) {
+            continue;
+        }
+
+        uint32_t tick_x = chart_x_for_time(plot_x, start_epoch_secs, epoch_secs);
+        display_draw_vline(tick_x, plot_y_end, 4, DISPLAY_COLOR_BLACK);
+        strftime(label, sizeof(label), "%H:00", &local);
+        display_draw_text(label, tick_x, plot_y_end + 20, DISPLAY_FONT_SIZE_SMALL, DISPLAY_FONT_ALIGN_CENTER);
+    }
+
+    display_draw_text((char *)info->title, x, y + 16, DISPLAY_FONT_SIZE_SMALL, DISPLAY_FONT_ALIGN_LEFT);
+
+    // Current time marker, a line down the plot with an arrow above it
+    if (now_epoch_secs >= start_epoch_secs &&
+        now_epoch_secs <= start_epoch_secs + (time_t)CHART_HOURS * FORECAST_INTERVAL_SECS) {
+        uint32_t marker_x = chart_x_for_time(plot_x, start_epoch_secs, now_epoch_secs);
+        display_draw_vline(marker_x, plot_y, PLOT_HEIGHT_PX, DISPLAY_COLOR_DARK_GRAY);
+        display_fill_triangle(marker_x - CHART_MARKER_SIZE_PX,
+                              plot_y - CHART_MARKER_SIZE_PX - 2,
+                              marker_x + CHART_MARKER_SIZE_PX,
+                              plot_y - CHART_MARKER_SIZE_PX - 2,
+                              marker_x,
+                              plot_y - 2,
+                              DISPLAY_COLOR_BLACK);
+    }
+
+    log_printf(LOG_LEVEL_DEBUG,
+               "Drew %s chart from %u forecast entries at (%lu, %lu), range %ld to %ld",
+               info->title,
+               num_points,
+               x,
+               y,
+               min,
+               max);
+}
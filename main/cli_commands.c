@@ -18,6 +18,7 @@
 #include "cli_commands.h"
 #include "cli_task.h"
 #include "constants.h"
+#include "cron.h"
 #include "display.h"
 #include "flash_partition.h"
 #include "http_client.h"
@@ -300,6 +301,11 @@ static BaseType_t cli_command_api(char *write_buffer, size_t write_buffer_size,
         uint16_t post_failures = 0;
         http_client_get_failures(&get_failures, &post_failures);
         sprintf(write_buffer, "GET failures: %u -- POST failures: %u", get_failures, post_failures);
+    } else if (endpoint_len == 4 && strncmp(endpoint, "pool", endpoint_len) == 0) {
+        uint32_t hits   = 0;
+        uint32_t misses = 0;
+        http_client_get_pool_stats(&hits, &misses);
+        sprintf(write_buffer, "Connection pool hits: %lu -- misses: %lu", hits, misses);
     } else {
         strcpy(write_buffer, "Unsupported api endpoint");
     }
@@ -472,6 +478,15 @@ static BaseType_t cli_command_display(char *write_buffer, size_t write_buffer_si
         if (!success) {
             strcpy(write_buffer, "CLI command to render screen_img failed");
         }
+    } else if (action_len == 6 && strncmp(action, "glyphs", action_len) == 0) {
+        uint32_t hits, misses, bytes_used, capacity;
+        display_get_glyph_cache_stats(&hits, &misses, &bytes_used, &capacity);
+        sprintf(write_buffer,
+                "Glyph cache: %lu hits, %lu misses, %lu / %lu bytes used",
+                hits,
+                misses,
+                bytes_used,
+                capacity);
     } else {
         strcpy(write_buffer, "Unknown display command");
     }
@@ -596,6 +611,9 @@ static BaseType_t cli_command_scheduler(char *write_buffer, size_t write_buffer_
         strcpy(write_buffer, "Triggered both charts update");
     } else if (type_len == 6 && strncmp(type, "custom", type_len) == 0) {
         scheduler_schedule_custom_screen_update();
+    } else if (type_len == 8 && strncmp(type, "forecast", type_len) == 0) {
+        scheduler_schedule_forecast_update();
+        strcpy(write_buffer, "Triggered forecast update");
     } else {
         strcpy(write_buffer, "Invalid scheduler update type, must be 'time|conditions|tide|swell|both'");
     }
@@ -605,6 +623,59 @@ static BaseType_t cli_command_scheduler(char *write_buffer, size_t write_buffer_
     return pdFALSE;
 }
 
+static BaseType_t cli_command_schedule(char *write_buffer, size_t write_buffer_size, const char *cmd_str) {
+    spot_check_config_t *current_config = nvs_get_config();
+
+    BaseType_t  job_len;
+    const char *job = FreeRTOS_CLIGetParameter(cmd_str, 1, &job_len);
+    if (job == NULL) {
+        snprintf(write_buffer,
+                 write_buffer_size,
+                 "conditions: '%s'\ntide: '%s'\nswell: '%s'\nwind: '%s'",
+                 current_config->conditions_schedule,
+                 current_config->tide_chart_schedule,
+                 current_config->swell_chart_schedule,
+                 current_config->wind_chart_schedule);
+        return pdFALSE;
+    }
+
+    // Expression is the rest of the line, its fields are space separated
+    BaseType_t  expr_len;
+    const char *expr = FreeRTOS_CLIGetParameter(cmd_str, 2, &expr_len);
+    if (expr == NULL) {
+        strcpy(write_buffer, "Error: usage is 'schedule <conditions|tide|swell|wind> <minute> <hour>'");
+        return pdFALSE;
+    }
+
+    cron_schedule_t schedule;
+    if (!cron_parse(expr, &schedule)) {
+        sprintf(write_buffer, "Invalid schedule '%s', must be '<minute> <hour>' (see cron.h)", expr);
+        return pdFALSE;
+    }
+
+    // Copy so the schedule string can point at the CLI buffer until it's saved, save reloads and reschedules
+    spot_check_config_t config = *current_config;
+    char                expr_copy[CRON_MAX_EXPR_LEN + 1];
+    strcpy(expr_copy, expr);
+    if (job_len == 10 && strncmp(job, "conditions", job_len) == 0) {
+        config.conditions_schedule = expr_copy;
+    } else if (job_len == 4 && strncmp(job, "tide", job_len) == 0) {
+        config.tide_chart_schedule = expr_copy;
+    } else if (job_len == 5 && strncmp(job, "swell", job_len) == 0) {
+        config.swell_chart_schedule = expr_copy;
+    } else if (job_len == 4 && strncmp(job, "wind", job_len) == 0) {
+        config.wind_chart_schedule = expr_copy;
+    } else {
+        strcpy(write_buffer, "Invalid schedule job, must be 'conditions|tide|swell|wind'");
+        return pdFALSE;
+    }
+
+    nvs_save_config(&config);
+    sprintf(write_buffer, "Set %.*s schedule to '%s'", (int)job_len, job, expr_copy);
+
+    return pdFALSE;
+}
+
 BaseType_t cli_command_sntp(char *write_buffer, size_t write_buffer_size, const char *cmd_str) {
     BaseType_t  action_len;
     const char *action = FreeRTOS_CLIGetParameter(cmd_str, 1, &action_len);
@@ -917,7 +988,7 @@ void cli_command_register_all() {
             "api:\n\timg <tide|swell>: download and save image to flash\n\t<endpoint>: send request "
             "to API endpoint with base URL set in menuconfig\n\tdebug: perform debugging actions\n\tfailures: "
             "print "
-            "failure count for get/post reqs",
+            "failure count for get/post reqs\n\tpool: print connection pool hit/miss count",
         .pxCommandInterpreter        = cli_command_api,
         .cExpectedNumberOfParameters = -1,
     };
@@ -935,7 +1006,7 @@ void cli_command_register_all() {
         .pcCommand = "display",
         .pcHelpString =
             "display:\n\tclear: clear full display\n\timg <tide|swell> [<x> <y>]: render an image "
-            "currently in flash at the specified coordinates",
+            "currently in flash at the specified coordinates\n\tglyphs: print font glyph cache statistics",
         .pxCommandInterpreter        = cli_command_display,
         .cExpectedNumberOfParameters = -1,
     };
@@ -960,6 +1031,15 @@ void cli_command_register_all() {
         .cExpectedNumberOfParameters = 1,
     };
 
+    static const CLI_Command_Definition_t schedule_cmd = {
+        .pcCommand = "schedule",
+        .pcHelpString =
+            "schedule:\n\t(none): print the update schedules\n\t<conditions|tide|swell|wind> <minute> <hour>: set "
+            "an update's schedule, cron-like fields (see cron.h)",
+        .pxCommandInterpreter        = cli_command_schedule,
+        .cExpectedNumberOfParameters = -1,
+    };
+
     static const CLI_Command_Definition_t sntp_cmd = {
         .pcCommand                   = "sntp",
         .pcHelpString                = "sntp:\n\tsync: Force sntp re-sync\n\tstatus: print the sntp current status",
@@ -1020,6 +1100,7 @@ void cli_command_register_all() {
     FreeRTOS_CLIRegisterCommand(&display_cmd);
     FreeRTOS_CLIRegisterCommand(&nvs_cmd);
     FreeRTOS_CLIRegisterCommand(&scheduler_cmd);
+    FreeRTOS_CLIRegisterCommand(&schedule_cmd);
     FreeRTOS_CLIRegisterCommand(&sntp_cmd);
     FreeRTOS_CLIRegisterCommand(&log_cmd);
     FreeRTOS_CLIRegisterCommand(&sleep_cmd);
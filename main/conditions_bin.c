@@ -0,0 +1,87 @@
+#include <ctype.h>
+#include <string.h>
+
+#include "conditions_bin.h"
+
+/*
+ * Copy a null padded fixed width field into a terminated string. Fails on anything that can't be drawn, which would
+ * mean the payload isn't what it claims to be.
+ */
+static bool conditions_bin_copy_str(char *dst, size_t dst_size, const char *src, size_t src_len) {
+    if (src_len >= dst_size) {
+        return false;
+    }
+
+    size_t len = 0;
+    while (len < src_len && src[len] != '\0') {
+        if (!isprint((unsigned char)src[len])) {
+            return false;
+        }
+        len++;
+    }
+
+    memcpy(dst, src, len);
+    dst[len] = '\0';
+    return true;
+}
+
+/*
+ * Whether a response starting with first_byte is a binary conditions payload rather than JSON.
+ */
+bool conditions_bin_is_magic_start(uint8_t first_byte) {
+    return first_byte == (uint8_t)CONDITIONS_BIN_MAGIC[0];
+}
+
+void conditions_bin_decoder_init(conditions_bin_decoder_t *decoder) {
+    memset(decoder, 0, sizeof(conditions_bin_decoder_t));
+}
+
+/*
+ * Only the bytes of the struct are kept, anything past that is for newer firmware.
+ */
+void conditions_bin_decoder_feed(conditions_bin_decoder_t *decoder, const uint8_t *data, size_t size) {
+    if (decoder->len < sizeof(decoder->buf)) {
+        size_t copy = sizeof(decoder->buf) - decoder->len;
+        if (copy > size) {
+            copy = size;
+        }
+        memcpy(decoder->buf + decoder->len, data, copy);
+    }
+
+    decoder->len += size;
+}
+
+bool conditions_bin_decoder_finish(conditions_bin_decoder_t *decoder, conditions_t *conditions) {
+    return conditions_bin_decode(decoder->buf, decoder->len, conditions);
+}
+
+/*
+ * Decode a complete binary payload of size bytes. conditions is only written on success.
+ */
+bool conditions_bin_decode(const uint8_t *data, size_t size, conditions_t *conditions) {
+    conditions_bin_t bin;
+    if (size < sizeof(conditions_bin_t)) {
+        return false;
+    }
+
+    memcpy(&bin, data, sizeof(conditions_bin_t));
+    if (memcmp(bin.magic, CONDITIONS_BIN_MAGIC, CONDITIONS_BIN_MAGIC_LEN) != 0 || bin.version != CONDITIONS_BIN_VERSION) {
+        return false;
+    }
+
+    conditions_t decoded = {
+        .temperature    = bin.temperature,
+        .wind_speed     = bin.wind_speed,
+        .is_tide_rising = (bin.flags & CONDITIONS_BIN_FLAG_TIDE_RISING) != 0,
+    };
+    if (!conditions_bin_copy_str(decoded.wind_dir, sizeof(decoded.wind_dir), bin.wind_dir, sizeof(bin.wind_dir)) ||
+        !conditions_bin_copy_str(decoded.tide_height,
+                                 sizeof(decoded.tide_height),
+                                 bin.tide_height,
+                                 sizeof(bin.tide_height))) {
+        return false;
+    }
+
+    memcpy(conditions, &decoded, sizeof(conditions_t));
+    return true;
+}
@@ -0,0 +1,163 @@
+#include <ctype.h>
+#include <string.h>
+
+#include "constants.h"
+#include "cron.h"
+
+static void cron_skip_spaces(const char **str) {
+    while (**str == ' ') {
+        (*str)++;
+    }
+}
+
+static bool cron_parse_value(const char **str, uint8_t max, uint8_t *value_out) {
+    if (!isdigit((unsigned char)**str)) {
+        return false;
+    }
+
+    unsigned int value = 0;
+    while (isdigit((unsigned char)**str)) {
+        value = value * 10 + (**str - '0');
+        if (value > max) {
+            return false;
+        }
+        (*str)++;
+    }
+
+    *value_out = (uint8_t)value;
+    return true;
+}
+
+/*
+ * Parse one field of values 0 to max into a bitmask, leaving str on the first character after it
+ */
+static bool cron_parse_field(const char **str, uint8_t max, uint64_t *mask_out) {
+    uint64_t mask = 0;
+    while (1) {
+        uint8_t start = 0;
+        uint8_t end   = max;
+        uint8_t step  = 1;
+        bool    range = true;
+        if (**str == '*') {
+            (*str)++;
+        } else {
+            if (!cron_parse_value(str, max, &start)) {
+                return false;
+            }
+            end   = start;
+            range = false;
+            if (**str == '-') {
+                (*str)++;
+                if (!cron_parse_value(str, max, &end) || end < start) {
+                    return false;
+                }
+                range = true;
+            }
+        }
+
+        if (**str == '/') {
+            (*str)++;
+            if (!cron_parse_value(str, max, &step) || step == 0) {
+                return false;
+            }
+            if (!range) {
+                end = max;
+            }
+        }
+
+        for (unsigned int value = start; value <= end; value += step) {
+            mask |= 1ULL << value;
+        }
+
+        if (**str != ',') {
+            break;
+        }
+        (*str)++;
+    }
+
+    *mask_out = mask;
+    return true;
+}
+
+/*
+ * Parse a '<minute> <hour>' expression. schedule_out is only written if the whole expression is valid.
+ */
+bool cron_parse(const char *expr, cron_schedule_t *schedule_out) {
+    if (expr == NULL || strlen(expr) > CRON_MAX_EXPR_LEN) {
+        return false;
+    }
+
+    const char *str     = expr;
+    uint64_t    minutes = 0;
+    uint64_t    hours   = 0;
+    cron_skip_spaces(&str);
+    if (!cron_parse_field(&str, MINS_PER_HOUR - 1, &minutes) || *str != ' ') {
+        return false;
+    }
+
+    cron_skip_spaces(&str);
+    if (!cron_parse_field(&str, HOURS_PER_DAY - 1, &hours)) {
+        return false;
+    }
+
+    cron_skip_spaces(&str);
+    if (*str != '\0') {
+        return false;
+    }
+
+    schedule_out->minutes = minutes;
+    schedule_out->hours   = (uint32_t)hours;
+    return true;
+}
+
+/*
+ * Whether the schedule never matches anything. A zeroed schedule is never, for updates that only run when forced.
+ */
+bool cron_is_never(const cron_schedule_t *schedule) {
+    return schedule->minutes == 0 || schedule->hours == 0;
+}
+
+/*
+ * Start of the first matching local minute at or after from_epoch_secs. The rest of the current hour and the next hour
+ * are found by offsetting from_epoch_secs directly so an hour repeated when DST ends is run through like any other.
+ * Anything after that goes through mktime, where a matching hour skipped by DST starting lands an hour late. Schedule
+ * must not be never.
+ */
+time_t cron_next(const cron_schedule_t *schedule, time_t from_epoch_secs) {
+    from_epoch_secs -= from_epoch_secs % SECS_PER_MIN;
+    struct tm local;
+    localtime_r(&from_epoch_secs, &local);
+
+    if (schedule->hours & (1UL << local.tm_hour)) {
+        uint64_t minutes_left = schedule->minutes & (UINT64_MAX << local.tm_min);
+        if (minutes_left) {
+            return from_epoch_secs + (time_t)(__builtin_ctzll(minutes_left) - local.tm_min) * SECS_PER_MIN;
+        }
+    }
+
+    const int first_minute    = __builtin_ctzll(schedule->minutes);
+    time_t    hour_epoch_secs = from_epoch_secs + (time_t)(MINS_PER_HOUR - local.tm_min) * SECS_PER_MIN;
+    localtime_r(&hour_epoch_secs, &local);
+    if (schedule->hours & (1UL << local.tm_hour)) {
+        return hour_epoch_secs + (time_t)first_minute * SECS_PER_MIN;
+    }
+
+    // Later today if there's a matching hour left, otherwise the first one tomorrow
+    uint32_t hours_left = schedule->hours & (UINT32_MAX << (local.tm_hour + 1));
+    local.tm_min        = first_minute;
+    local.tm_sec        = 0;
+    local.tm_isdst      = -1;
+    if (hours_left) {
+        local.tm_hour = __builtin_ctz(hours_left);
+    } else {
+        local.tm_mday++;
+        local.tm_hour = __builtin_ctz(schedule->hours);
+    }
+
+    time_t next_epoch_secs = mktime(&local);
+    if (next_epoch_secs < hour_epoch_secs) {
+        // An hour repeated when DST ends resolved to its first occurrence, which already passed
+        next_epoch_secs += MINS_PER_HOUR * SECS_PER_MIN;
+    }
+    return next_epoch_secs;
+}
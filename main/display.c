@@ -1,3 +1,5 @@
+#include <math.h>
+
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 
@@ -12,6 +14,7 @@
 #include "firasans_20.h"
 #include "firasans_40.h"
 #include "flash_partition.h"
+#include "hash.h"
 #include "log.h"
 
 #define TAG SC_TAG_DISPLAY
@@ -24,11 +27,60 @@
 #define ED060SC4_WIDTH_PX 800
 #define ED060SC4_HEIGHT_PX 600
 
+// Direct update, only drives pixels to black or white but takes 4 phases where GC16 takes 30. Good enough for black
+// text, its antialiased edges are left a bit rough until the next GC16 pass over them.
+#define DISPLAY_FAST_MODE MODE_DU
+
+// What every update used before there was a reading, and until the first one is taken
+#define DEFAULT_TEMPERATURE_C (25)
+// The panel's temperature drifts over tens of minutes, not between one update and the next
+#define TEMPERATURE_SAMPLE_INTERVAL_MS (10 * SECS_PER_MIN * MS_PER_SEC)
+// Anything outside this (or NaN) is a disconnected or failed sensor rather than the weather
+#define TEMPERATURE_MIN_VALID_C (-30)
+#define TEMPERATURE_MAX_VALID_C (70)
+
+#define TEXT_BOUNDS_CACHE_ENTRIES 16
+#define TEXT_BOUNDS_CACHE_MAX_TEXT_LEN 40
+
+/*
+ * Measured text size only depends on the text, font and alignment, not the position, so the same UI strings measured
+ * every clear/draw cycle only need to go through the glyph metrics once.
+ */
+typedef struct {
+    uint32_t             hash;
+    display_font_size_t  size;
+    display_font_align_t alignment;
+    uint32_t             width;
+    uint32_t             height;
+    char                 text[TEXT_BOUNDS_CACHE_MAX_TEXT_LEN];
+} text_bounds_cache_entry_t;
+
 static EpdiyHighlevelState hl;
 static uint32_t            display_height;
 static uint32_t            display_width;
+// Held for every framebuffer write as well as every render, since the scheduler's fetch stage draws streamed images
+// while its render stage draws and renders. A write landing between a render diffing an area and copying it to the back
+// buffer would never reach the panel, and one landing in a full clear would be wiped out.
 static SemaphoreHandle_t   render_lock;
 
+// Areas cleared since the last render, merged like the highlevel damage tracker merges drawn areas. Cleared areas are
+// only whited out in the framebuffer and composited into the next render, so a pass that clears and redraws the time,
+// date, conditions and charts powers the panel once instead of once per clear. Guarded by the render lock.
+static EpdDamage pending_clears;
+// Areas holding only monochrome text (the clock, the date) that the next render refreshes with DISPLAY_FAST_MODE,
+// unless the whole screen was marked dirty for a GC16 pass since
+static EpdDamage pending_fast;
+static bool      pending_full_refresh;
+
+// Last ambient reading, the driver picks the waveform temperature range from it. Guarded by the render lock.
+static int        temperature_c = DEFAULT_TEMPERATURE_C;
+static bool       temperature_sampled;
+static TickType_t temperature_sampled_ticks;
+
+static text_bounds_cache_entry_t text_bounds_cache[TEXT_BOUNDS_CACHE_ENTRIES];
+static uint8_t                   text_bounds_cache_next_idx;
+static SemaphoreHandle_t         text_bounds_cache_lock;
+
 static enum EpdFontFlags display_get_epd_font_flags_enum(display_font_align_t alignment) {
     MEMFAULT_ASSERT(alignment < DISPLAY_FONT_ALIGN_COUNT);
 
@@ -110,18 +162,118 @@ static void render_release_lock() {
     log_printf(LOG_LEVEL_DEBUG, "released lock");
 }
 
+/*
+ * Framebuffer writes wait out a render in progress rather than give up after a timeout like renders do, a dropped draw
+ * would leave stale content on screen until that area is next redrawn. Writes themselves are short.
+ */
+static void display_lock_framebuffer() {
+    xSemaphoreTake(render_lock, portMAX_DELAY);
+}
+
+static void display_unlock_framebuffer() {
+    xSemaphoreGive(render_lock);
+}
+
+/*
+ * Temperature to pick the waveform's temperature range with, from a reading at most TEMPERATURE_SAMPLE_INTERVAL_MS old.
+ * Must be called with the render lock held and the panel powered on, some boards read it from the power IC.
+ */
+static int display_get_temperature() {
+    TickType_t now_ticks = xTaskGetTickCount();
+    if (temperature_sampled && now_ticks - temperature_sampled_ticks < pdMS_TO_TICKS(TEMPERATURE_SAMPLE_INTERVAL_MS)) {
+        return temperature_c;
+    }
+
+    temperature_sampled       = true;
+    temperature_sampled_ticks = now_ticks;
+    float reading             = epd_ambient_temperature();
+    if (isnan(reading) || reading < TEMPERATURE_MIN_VALID_C || reading > TEMPERATURE_MAX_VALID_C) {
+        log_printf(LOG_LEVEL_WARN, "Ignoring invalid ambient temperature %.1fC, keeping %dC", reading, temperature_c);
+        return temperature_c;
+    }
+
+    int rounded_c = (int)(reading + (reading < 0 ? -0.5f : 0.5f));
+    if (rounded_c != temperature_c) {
+        log_printf(LOG_LEVEL_DEBUG, "Ambient temperature %dC, was %dC", rounded_c, temperature_c);
+        temperature_c = rounded_c;
+    }
+
+    return temperature_c;
+}
+
+/*
+ * Grow a rect by a pixel on every side that isn't at the edge of the screen
+ */
+static EpdRect display_pad_rect(EpdRect rect) {
+    EpdRect padded = rect;
+    if (rect.x > 0) {
+        padded.x -= 1;
+        padded.width += 1;
+    }
+    if (rect.y > 0) {
+        padded.y -= 1;
+        padded.height += 1;
+    }
+    if (rect.x + rect.width < ED060SC4_WIDTH_PX) {
+        padded.width += 1;
+    }
+    if (rect.y + rect.height < ED060SC4_HEIGHT_PX) {
+        padded.height += 1;
+    }
+
+    return padded;
+}
+
+static bool display_damage_contains(const EpdDamage *damage, EpdRect rect) {
+    for (int i = 0; i < damage->count; i++) {
+        const EpdRect *r = &damage->rects[i];
+        if (rect.x >= r->x && rect.y >= r->y && rect.x + rect.width <= r->x + r->width &&
+            rect.y + rect.height <= r->y + r->height) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 static void display_render_mode(enum EpdDrawMode mode) {
     if (!render_acquire_lock(__func__, __LINE__)) {
         return;
     }
 
+    // Anything cleared or marked after this is left for the next render
+    EpdDamage clears = pending_clears;
+    EpdDamage fast   = pending_fast;
+    if (pending_full_refresh) {
+        fast.count = 0;
+    }
+    pending_clears.count = 0;
+    pending_fast.count   = 0;
+    pending_full_refresh = false;
+
     epd_poweron();
     vTaskDelay(pdMS_TO_TICKS(20));
-    enum EpdDrawError err = epd_hl_update_screen(&hl, mode, 25);
+    int temperature = display_get_temperature();
+
+    // One pass per merged cleared region, driven as if the panel showed the inverse of the new content so whatever was
+    // there is wiped out by the same pass that draws over it. The rest of the screen only changes where it was drawn.
+    for (int i = 0; i < clears.count; i++) {
+        enum EpdDrawMode clear_mode = display_damage_contains(&fast, clears.rects[i]) ? DISPLAY_FAST_MODE : MODE_GC16;
+        epd_hl_force_refresh_area(&hl, clears.rects[i]);
+        epd_hl_update_area(&hl, clear_mode, temperature, clears.rects[i]);
+    }
+    for (int i = 0; i < fast.count; i++) {
+        epd_hl_update_area(&hl, DISPLAY_FAST_MODE, temperature, fast.rects[i]);
+    }
+    enum EpdDrawError err = epd_hl_update_screen(&hl, mode, temperature);
     (void)err;
     // TODO :: error check
     epd_poweroff();
 
+    if (clears.count > 0) {
+        log_printf(LOG_LEVEL_DEBUG, "Rendered %d cleared regions in one power cycle", clears.count);
+    }
+
     render_release_lock();
 }
 
@@ -130,8 +282,10 @@ void display_init() {
     hl          = epd_hl_init(EPD_BUILTIN_WAVEFORM);
     uint8_t *fb = epd_hl_get_framebuffer(&hl);
     memset(fb, 0x00, EPD_WIDTH / 2 * EPD_HEIGHT);
+    epd_damage_add(fb, epd_full_screen());
 
-    render_lock = xSemaphoreCreateMutex();
+    render_lock            = xSemaphoreCreateMutex();
+    text_bounds_cache_lock = xSemaphoreCreateMutex();
 
     display_width  = epd_rotated_display_width();
     display_height = epd_rotated_display_height();
@@ -155,9 +309,13 @@ void display_full_clear_cycles(uint8_t cycles) {
         return;
     }
 
+    // Whole screen is being wiped, nothing cleared before this needs its own pass anymore
+    pending_clears.count = 0;
+    pending_fast.count   = 0;
+
     epd_poweron();
     epd_hl_set_all_white(&hl);
-    enum EpdDrawError err = epd_hl_update_screen(&hl, MODE_GC16, 25);
+    enum EpdDrawError err = epd_hl_update_screen(&hl, MODE_GC16, display_get_temperature());
     (void)err;
     vTaskDelay(pdMS_TO_TICKS(20));
     epd_clear_area_cycles(epd_full_screen(), cycles, 12);
@@ -173,11 +331,11 @@ void display_full_clear() {
     display_full_clear_cycles(3);
 }
 
+/*
+ * White out an area of the framebuffer and queue it to be wiped on the panel by the next render. Overlapping and nearby
+ * cleared areas are merged so each one only costs a single pass, and nothing touches the panel until then.
+ */
 void display_clear_area(uint32_t x, uint32_t y, uint32_t width, uint32_t height) {
-    if (!render_acquire_lock(__func__, __LINE__)) {
-        return;
-    }
-
     // Limit these bounds to be w/in the framebuffer, epdiy will happily buffer overflow it
     MEMFAULT_ASSERT(x + width <= ED060SC4_WIDTH_PX);
     MEMFAULT_ASSERT(y + height <= ED060SC4_HEIGHT_PX);
@@ -189,34 +347,46 @@ void display_clear_area(uint32_t x, uint32_t y, uint32_t width, uint32_t height)
         .height = height,
     };
 
-    // Fill framebuffer with white to ovewrite any drawn data in epd_hl_update_area
+    display_lock_framebuffer();
+
+    // Fill framebuffer with white to ovewrite any drawn data, whatever's drawn here before the render goes over it
     uint8_t *fb = epd_hl_get_framebuffer(&hl);
     epd_fill_rect(rect, 0xFF, fb);
 
     // Add in 1-pixel padding to erase area to make sure a gray outline isn't left from bleedover
-    if (rect.x > 0) {
-        rect.x -= 1;
-    }
-    if (rect.y > 0) {
-        rect.y -= 1;
-    }
-    if (rect.x + width < ED060SC4_WIDTH_PX) {
-        rect.width += 2;
-    }
-    if (rect.y + height < ED060SC4_HEIGHT_PX) {
-        rect.height += 2;
-    }
+    rect = display_pad_rect(rect);
+    epd_damage_record(&pending_clears, rect);
+    int pending = pending_clears.count;
 
-    epd_poweron();
-    epd_hl_update_area(&hl, MODE_GC16, 18, rect);
-    vTaskDelay(pdMS_TO_TICKS(40));
-    epd_clear_area_cycles(rect, 1, 12);
-    vTaskDelay(pdMS_TO_TICKS(40));
-    epd_poweroff();
+    display_unlock_framebuffer();
 
-    render_release_lock();
+    log_printf(LOG_LEVEL_DEBUG,
+               "Cleared %uw %uh rect at (%u, %u), %d regions pending render",
+               width,
+               height,
+               x,
+               y,
+               pending);
+}
+
+/*
+ * White out an area of the framebuffer without queueing it to be wiped. For redrawing content that mostly comes out the
+ * same, the next render then only drives the pixels that actually differ from what the panel shows.
+ */
+void display_erase_area(uint32_t x, uint32_t y, uint32_t width, uint32_t height) {
+    MEMFAULT_ASSERT(x + width <= ED060SC4_WIDTH_PX);
+    MEMFAULT_ASSERT(y + height <= ED060SC4_HEIGHT_PX);
+
+    EpdRect rect = {
+        .x      = x,
+        .y      = y,
+        .width  = width,
+        .height = height,
+    };
 
-    log_printf(LOG_LEVEL_DEBUG, "Cleared %uw %uh rect at (%u, %u)", width, height, x, y);
+    display_lock_framebuffer();
+    epd_fill_rect(rect, 0xFF, epd_hl_get_framebuffer(&hl));
+    display_unlock_framebuffer();
 }
 
 void display_render_splash_screen(char *fw_version, char *hw_version) {
@@ -276,7 +446,9 @@ void display_draw_text(char                *text,
                y,
                text);
 
+    display_lock_framebuffer();
     epd_write_string(font, text, &x, &y, fb, &font_props);
+    display_unlock_framebuffer();
 }
 
 void display_invert_text(char                *text,
@@ -304,7 +476,9 @@ void display_invert_text(char                *text,
                y,
                text);
 
+    display_lock_framebuffer();
     epd_write_string(font, text, &x, &y, fb, &font_props);
+    display_unlock_framebuffer();
 }
 
 /*
@@ -331,7 +505,49 @@ void display_draw_image(uint8_t *image_buffer,
     };
 
     // Data MUST be 2 pixels per byte, aka 1 pixel per 4-bit nibble.
+    display_lock_framebuffer();
     epd_copy_to_framebuffer(rect, image_buffer, fb);
+    display_unlock_framebuffer();
+}
+
+/*
+ * Draw part of a 2-pixels-per-byte image as it's received, without needing the full image in memory. chunk_offset is
+ * the byte offset of the chunk into the full image data. Rows of uneven width images are padded by a nibble, same as
+ * display_draw_image.
+ */
+void display_draw_image_chunk(const uint8_t *chunk,
+                              size_t         chunk_size,
+                              size_t         chunk_offset,
+                              size_t         width_px,
+                              size_t         height_px,
+                              uint32_t       screen_x,
+                              uint32_t       screen_y) {
+    // Limit these bounds to be w/in the framebuffer, epdiy will happily buffer overflow it
+    MEMFAULT_ASSERT(screen_x + width_px <= ED060SC4_WIDTH_PX);
+    MEMFAULT_ASSERT(screen_y + height_px <= ED060SC4_HEIGHT_PX);
+
+    uint8_t     *fb          = epd_hl_get_framebuffer(&hl);
+    const size_t row_bytes   = (width_px + 1) / 2;
+    size_t       consumed    = 0;
+    size_t       image_bytes = row_bytes * height_px;
+
+    display_lock_framebuffer();
+    while (consumed < chunk_size && chunk_offset + consumed < image_bytes) {
+        size_t row           = (chunk_offset + consumed) / row_bytes;
+        size_t byte_in_row   = (chunk_offset + consumed) % row_bytes;
+        size_t bytes_to_copy = MIN(row_bytes - byte_in_row, chunk_size - consumed);
+
+        // Segments always start on an even pixel, only the segment ending a row can have an odd width
+        EpdRect rect = {
+            .x      = screen_x + byte_in_row * 2,
+            .y      = screen_y + row,
+            .width  = MIN(bytes_to_copy * 2, width_px - byte_in_row * 2),
+            .height = 1,
+        };
+        epd_copy_to_framebuffer(rect, chunk + consumed, fb);
+        consumed += bytes_to_copy;
+    }
+    display_unlock_framebuffer();
 }
 
 void display_draw_rect(uint32_t x, uint32_t y, uint32_t width_px, uint32_t height_px) {
@@ -347,11 +563,55 @@ void display_draw_rect(uint32_t x, uint32_t y, uint32_t width_px, uint32_t heigh
     };
 
     uint8_t *fb = epd_hl_get_framebuffer(&hl);
+    display_lock_framebuffer();
     epd_fill_rect(rect, 0x0, fb);
+    display_unlock_framebuffer();
 
     log_printf(LOG_LEVEL_DEBUG, "Rendering %uw %uh rect at (%u, %u)", width_px, height_px, x, y);
 }
 
+void display_draw_hline(uint32_t x, uint32_t y, uint32_t length_px, uint8_t color) {
+    MEMFAULT_ASSERT(x + length_px <= ED060SC4_WIDTH_PX);
+    MEMFAULT_ASSERT(y < ED060SC4_HEIGHT_PX);
+
+    display_lock_framebuffer();
+    epd_draw_hline(x, y, length_px, color, epd_hl_get_framebuffer(&hl));
+    display_unlock_framebuffer();
+}
+
+void display_draw_vline(uint32_t x, uint32_t y, uint32_t length_px, uint8_t color) {
+    MEMFAULT_ASSERT(x < ED060SC4_WIDTH_PX);
+    MEMFAULT_ASSERT(y + length_px <= ED060SC4_HEIGHT_PX);
+
+    display_lock_framebuffer();
+    epd_draw_vline(x, y, length_px, color, epd_hl_get_framebuffer(&hl));
+    display_unlock_framebuffer();
+}
+
+void display_draw_line(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, uint8_t color) {
+    MEMFAULT_ASSERT(x0 < ED060SC4_WIDTH_PX && x1 < ED060SC4_WIDTH_PX);
+    MEMFAULT_ASSERT(y0 < ED060SC4_HEIGHT_PX && y1 < ED060SC4_HEIGHT_PX);
+
+    display_lock_framebuffer();
+    epd_draw_line(x0, y0, x1, y1, color, epd_hl_get_framebuffer(&hl));
+    display_unlock_framebuffer();
+}
+
+void display_fill_triangle(uint32_t x0,
+                           uint32_t y0,
+                           uint32_t x1,
+                           uint32_t y1,
+                           uint32_t x2,
+                           uint32_t y2,
+                           uint8_t  color) {
+    MEMFAULT_ASSERT(x0 < ED060SC4_WIDTH_PX && x1 < ED060SC4_WIDTH_PX && x2 < ED060SC4_WIDTH_PX);
+    MEMFAULT_ASSERT(y0 < ED060SC4_HEIGHT_PX && y1 < ED060SC4_HEIGHT_PX && y2 < ED060SC4_HEIGHT_PX);
+
+    display_lock_framebuffer();
+    epd_fill_triangle(x0, y0, x1, y1, x2, y2, color, epd_hl_get_framebuffer(&hl));
+    display_unlock_framebuffer();
+}
+
 /*
  * Assumes array holds enough data for full screen, cannot check bounds and will crash if not. See display_render_image
  * for internals.
@@ -360,6 +620,21 @@ void display_draw_image_fullscreen(uint8_t *image_buffer, uint8_t bytes_per_px)
     display_draw_image(image_buffer, ED060SC4_WIDTH_PX, ED060SC4_HEIGHT_PX, bytes_per_px, 0, 0);
 }
 
+static text_bounds_cache_entry_t *display_text_bounds_cache_find(const char          *text,
+                                                                 uint32_t             hash,
+                                                                 display_font_size_t  size,
+                                                                 display_font_align_t alignment) {
+    for (int i = 0; i < TEXT_BOUNDS_CACHE_ENTRIES; i++) {
+        text_bounds_cache_entry_t *entry = &text_bounds_cache[i];
+        if (entry->hash == hash && entry->size == size && entry->alignment == alignment &&
+            strcmp(entry->text, text) == 0) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
 void display_get_text_bounds(char                *text,
                              uint32_t             x,
                              uint32_t             y,
@@ -367,6 +642,25 @@ void display_get_text_bounds(char                *text,
                              display_font_align_t alignment,
                              uint32_t            *width,
                              uint32_t            *height) {
+    const bool cacheable = strlen(text) < TEXT_BOUNDS_CACHE_MAX_TEXT_LEN;
+    uint32_t   hash      = 0;
+    if (cacheable) {
+        // Only used to quickly reject cache entries before comparing the full string
+        hash = hash_fnv1a(text);
+
+        xSemaphoreTake(text_bounds_cache_lock, portMAX_DELAY);
+        text_bounds_cache_entry_t *entry = display_text_bounds_cache_find(text, hash, size, alignment);
+        if (entry) {
+            *width  = entry->width;
+            *height = entry->height;
+        }
+        xSemaphoreGive(text_bounds_cache_lock);
+
+        if (entry) {
+            return;
+        }
+    }
+
     EpdFontProperties font_props = {
         .flags = display_get_epd_font_flags_enum(alignment),
     };
@@ -384,24 +678,66 @@ void display_get_text_bounds(char                *text,
                y1,
                *width,
                *height);
+
+    if (cacheable) {
+        xSemaphoreTake(text_bounds_cache_lock, portMAX_DELAY);
+        text_bounds_cache_entry_t *entry = &text_bounds_cache[text_bounds_cache_next_idx];
+        text_bounds_cache_next_idx       = (text_bounds_cache_next_idx + 1) % TEXT_BOUNDS_CACHE_ENTRIES;
+        entry->hash                      = hash;
+        entry->size                      = size;
+        entry->alignment                 = alignment;
+        entry->width                     = *width;
+        entry->height                    = *height;
+        strcpy(entry->text, text);
+        xSemaphoreGive(text_bounds_cache_lock);
+    }
 }
 
+/*
+ * Whole screen goes through GC16 on the next render, fast areas included. This is what cleans up after the fast mode.
+ */
 void display_mark_all_lines_dirty() {
-    for (int i = 0; i < (EPD_WIDTH / 2 * EPD_HEIGHT); i++) {
-        hl.back_fb[i] = ~hl.front_fb[i];
-    }
+    display_lock_framebuffer();
+    pending_full_refresh = true;
+    epd_hl_force_refresh_area(&hl, epd_full_screen());
+    display_unlock_framebuffer();
+}
+
+/*
+ * Refresh an area holding only monochrome text with the fast waveform on the next render instead of GC16. Anything
+ * cleared inside it is refreshed fast too.
+ */
+void display_mark_rect_fast(uint32_t x_coord, uint32_t y_coord, uint32_t width, uint32_t height) {
+    EpdRect rect = {
+        .x      = x_coord,
+        .y      = y_coord,
+        .width  = MIN(width, EPD_WIDTH - x_coord),
+        .height = MIN(height, EPD_HEIGHT - y_coord),
+    };
+
+    // Padded the same as a cleared area, so clearing the same area lands inside it
+    display_lock_framebuffer();
+    epd_damage_record(&pending_fast, display_pad_rect(rect));
+    display_unlock_framebuffer();
 }
 
 void display_mark_rect_dirty(uint32_t x_coord, uint32_t y_coord, uint32_t width, uint32_t height) {
-    uint32_t row_start_index   = 0;
-    uint32_t dirty_rect_height = MIN(height, EPD_HEIGHT - y_coord);
-    uint32_t dirty_rect_width  = MIN(width, EPD_WIDTH - x_coord);
+    EpdRect rect = {
+        .x      = x_coord,
+        .y      = y_coord,
+        .width  = MIN(width, EPD_WIDTH - x_coord),
+        .height = MIN(height, EPD_HEIGHT - y_coord),
+    };
 
-    for (int i = y_coord; i < (y_coord + dirty_rect_height); i++) {
-        row_start_index = i * (EPD_WIDTH / 2);
+    display_lock_framebuffer();
+    epd_hl_force_refresh_area(&hl, rect);
+    display_unlock_framebuffer();
+}
 
-        for (int j = (x_coord / 2); j < ((x_coord + dirty_rect_width) / 2); j++) {
-            hl.back_fb[row_start_index + j] = ~hl.front_fb[row_start_index + j];
-        }
-    }
+void display_get_glyph_cache_stats(uint32_t *hits, uint32_t *misses, uint32_t *bytes_used, uint32_t *capacity) {
+    EpdGlyphCacheStats stats = epd_glyph_cache_stats();
+    *hits                    = stats.hits;
+    *misses                  = stats.misses;
+    *bytes_used              = stats.bytes_used;
+    *capacity                = stats.capacity;
 }
@@ -1,10 +1,175 @@
+#include <string.h>
+
+#include "freertos/task.h"
 #include "memfault/panics/assert.h"
 
 #include "constants.h"
 #include "flash_partition.h"
 #include "screen_img_handler.h"
 
-#define TAG SC_TAG_PART
+// Must included below constants.h where we overwite the define of LOG_LOCAL_LEVEL
+#include "log.h"
+
+#define TAG SC_TAG_PARTITION
+
+// Higher than the http queue task that feeds it with downloads, so flash ops start as soon as a sector is filled
+#define FLASH_WRITER_TASK_PRIORITY (tskIDLE_PRIORITY + 1)
+
+// Stack buffer size for comparing against / copying from the reference range
+#define FLASH_WRITER_SCRATCH_SIZE (256)
+
+typedef struct {
+    uint8_t *buffer;  // NULL tells the worker to exit
+    size_t   len;
+    uint32_t address;
+} flash_write_job_t;
+
+static bool flash_partition_writer_job_matches_reference(flash_partition_writer_t *writer, flash_write_job_t *job) {
+    uint32_t relative_offset = job->address - writer->start_offset;
+    if (relative_offset + job->len > writer->reference_size) {
+        return false;
+    }
+
+    uint8_t scratch[FLASH_WRITER_SCRATCH_SIZE];
+    for (size_t i = 0; i < job->len; i += FLASH_WRITER_SCRATCH_SIZE) {
+        size_t len = MIN(FLASH_WRITER_SCRATCH_SIZE, job->len - i);
+        if (esp_partition_read(writer->partition, writer->reference_offset + relative_offset + i, scratch, len) !=
+                ESP_OK ||
+            memcmp(scratch, job->buffer + i, len) != 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Once the data diverges from the reference, the sectors skipped so far still have to land in the destination. They
+ * were identical to the reference, so copy them from there.
+ */
+static esp_err_t flash_partition_writer_copy_skipped(flash_partition_writer_t *writer) {
+    uint8_t   scratch[FLASH_WRITER_SCRATCH_SIZE];
+    esp_err_t err = ESP_OK;
+
+    for (size_t sector = 0; sector < writer->skipped_bytes && err == ESP_OK; sector += FLASH_PARTITION_SECTOR_SIZE) {
+        err = esp_partition_erase_range(writer->partition,
+                                        writer->start_offset + sector,
+                                        FLASH_PARTITION_SECTOR_SIZE);
+        for (size_t i = 0; i < FLASH_PARTITION_SECTOR_SIZE && err == ESP_OK; i += FLASH_WRITER_SCRATCH_SIZE) {
+            err = esp_partition_read(writer->partition,
+                                     writer->reference_offset + sector + i,
+                                     scratch,
+                                     FLASH_WRITER_SCRATCH_SIZE);
+            if (err == ESP_OK) {
+                err = esp_partition_write(writer->partition,
+                                          writer->start_offset + sector + i,
+                                          scratch,
+                                          FLASH_WRITER_SCRATCH_SIZE);
+            }
+        }
+    }
+
+    if (err != ESP_OK) {
+        log_printf(LOG_LEVEL_ERROR,
+                   "Error copying %u skipped bytes from reference: %s",
+                   writer->skipped_bytes,
+                   esp_err_to_name(err));
+    }
+
+    writer->matches_reference = false;
+    writer->skipped_bytes     = 0;
+    return err;
+}
+
+static esp_err_t flash_partition_writer_process_job(flash_partition_writer_t *writer, flash_write_job_t *job) {
+    if (writer->matches_reference) {
+        if (flash_partition_writer_job_matches_reference(writer, job)) {
+            writer->skipped_bytes += job->len;
+            return ESP_OK;
+        }
+
+        esp_err_t err = flash_partition_writer_copy_skipped(writer);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    esp_err_t err = esp_partition_erase_range(writer->partition, job->address, FLASH_PARTITION_SECTOR_SIZE);
+    if (err == ESP_OK) {
+        err = esp_partition_write(writer->partition, job->address, job->buffer, job->len);
+    }
+
+    if (err != ESP_OK) {
+        log_printf(LOG_LEVEL_ERROR,
+                   "Error erasing/writing %u bytes at partition offset 0x%X: %s",
+                   job->len,
+                   job->address,
+                   esp_err_to_name(err));
+    }
+
+    return err;
+}
+
+/*
+ * Worker owns erasing and programming. Jobs always start on a sector boundary since the writer only submits full
+ * sectors until the final one, so each job erases exactly the sector it's about to program.
+ */
+static void flash_partition_writer_task(void *args) {
+    flash_partition_writer_t *writer = (flash_partition_writer_t *)args;
+    flash_write_job_t         job;
+
+    while (1) {
+        xQueueReceive(writer->write_queue, &job, portMAX_DELAY);
+        if (!job.buffer) {
+            break;
+        }
+
+        // Drain remaining jobs without touching flash once something failed so the caller never blocks on a buffer
+        if (writer->err == ESP_OK) {
+            writer->err = flash_partition_writer_process_job(writer, &job);
+        }
+
+        xQueueSend(writer->free_queue, &job.buffer, portMAX_DELAY);
+    }
+
+    // Everything matched but the new data is shorter than the reference, so it's not the same data after all
+    if (writer->err == ESP_OK && writer->matches_reference && writer->bytes_queued != writer->reference_size) {
+        writer->err = flash_partition_writer_copy_skipped(writer);
+    }
+
+    xSemaphoreGive(writer->done);
+    vTaskDelete(NULL);
+}
+
+static void flash_partition_writer_submit(flash_partition_writer_t *writer) {
+    flash_write_job_t job = {
+        .buffer  = writer->fill_buffer,
+        .len     = writer->fill_len,
+        .address = writer->start_offset + writer->bytes_queued - writer->fill_len,
+    };
+    xQueueSend(writer->write_queue, &job, portMAX_DELAY);
+
+    writer->fill_buffer = NULL;
+    writer->fill_len    = 0;
+}
+
+static void flash_partition_writer_free(flash_partition_writer_t *writer) {
+    for (int i = 0; i < 2; i++) {
+        if (writer->buffers[i]) {
+            free(writer->buffers[i]);
+        }
+    }
+    if (writer->write_queue) {
+        vQueueDelete(writer->write_queue);
+    }
+    if (writer->free_queue) {
+        vQueueDelete(writer->free_queue);
+    }
+    if (writer->done) {
+        vSemaphoreDelete(writer->done);
+    }
+    memset(writer, 0, sizeof(flash_partition_writer_t));
+}
 
 const esp_partition_t *flash_partition_get_screen_img_partition() {
     const esp_partition_t *screen_img_partition =
@@ -12,3 +177,128 @@ const esp_partition_t *flash_partition_get_screen_img_partition() {
     MEMFAULT_ASSERT(screen_img_partition);
     return screen_img_partition;
 }
+
+/*
+ * Start a streamed write of up to max_size bytes at a sector aligned offset. Nothing is erased up front, only the
+ * sectors actually written. Every successful start must be followed by a call to flash_partition_writer_finish.
+ */
+esp_err_t flash_partition_writer_start(flash_partition_writer_t *writer,
+                                       const esp_partition_t    *partition,
+                                       uint32_t                  offset_into_partition,
+                                       size_t                    max_size) {
+    MEMFAULT_ASSERT(writer);
+    MEMFAULT_ASSERT(partition);
+    MEMFAULT_ASSERT(offset_into_partition % FLASH_PARTITION_SECTOR_SIZE == 0);
+
+    memset(writer, 0, sizeof(flash_partition_writer_t));
+    writer->partition    = partition;
+    writer->start_offset = offset_into_partition;
+    writer->max_size     = MIN(max_size, partition->size - offset_into_partition);
+    writer->err          = ESP_OK;
+
+    writer->buffers[0]  = malloc(FLASH_PARTITION_SECTOR_SIZE);
+    writer->buffers[1]  = malloc(FLASH_PARTITION_SECTOR_SIZE);
+    writer->write_queue = xQueueCreate(2, sizeof(flash_write_job_t));
+    writer->free_queue  = xQueueCreate(2, sizeof(uint8_t *));
+    writer->done        = xSemaphoreCreateBinary();
+    if (!writer->buffers[0] || !writer->buffers[1] || !writer->write_queue || !writer->free_queue || !writer->done) {
+        log_printf(LOG_LEVEL_ERROR, "Failed to allocate flash writer buffers/queues");
+        flash_partition_writer_free(writer);
+        return ESP_ERR_NO_MEM;
+    }
+
+    xQueueSend(writer->free_queue, &writer->buffers[0], 0);
+    xQueueSend(writer->free_queue, &writer->buffers[1], 0);
+
+    BaseType_t rval = xTaskCreate(flash_partition_writer_task,
+                                  "flash writer",
+                                  SPOT_CHECK_MINIMAL_STACK_SIZE_BYTES * 3,
+                                  writer,
+                                  FLASH_WRITER_TASK_PRIORITY,
+                                  NULL);
+    if (rval != pdPASS) {
+        log_printf(LOG_LEVEL_ERROR, "Failed to create flash writer task");
+        flash_partition_writer_free(writer);
+        return ESP_ERR_NO_MEM;
+    }
+
+    return ESP_OK;
+}
+
+/*
+ * Compare written data against reference_size bytes at the sector aligned reference_offset, skipping flash ops while
+ * they match. Must be called before the first write.
+ */
+void flash_partition_writer_set_reference(flash_partition_writer_t *writer,
+                                          uint32_t                  reference_offset,
+                                          size_t                    reference_size) {
+    MEMFAULT_ASSERT(writer->bytes_queued == 0);
+    MEMFAULT_ASSERT(reference_offset % FLASH_PARTITION_SECTOR_SIZE == 0);
+
+    writer->reference_offset  = reference_offset;
+    writer->reference_size    = reference_size;
+    writer->matches_reference = reference_size > 0;
+}
+
+/*
+ * Queue data to be written after everything previously written. Only blocks when both sector buffers are waiting on
+ * flash. Returns the first error hit by the worker, if any.
+ */
+esp_err_t flash_partition_writer_write(flash_partition_writer_t *writer, const uint8_t *data, size_t size) {
+    if (writer->bytes_queued + size > writer->max_size) {
+        log_printf(LOG_LEVEL_ERROR,
+                   "Attempting to write 0x%02X bytes to partition at offset 0x%02X which would overflow the boundary "
+                   "of 0x%02X bytes, aborting",
+                   size,
+                   writer->start_offset + writer->bytes_queued,
+                   writer->max_size);
+        writer->err = ESP_ERR_INVALID_SIZE;
+        return writer->err;
+    }
+
+    while (size > 0 && writer->err == ESP_OK) {
+        if (!writer->fill_buffer) {
+            xQueueReceive(writer->free_queue, &writer->fill_buffer, portMAX_DELAY);
+        }
+
+        size_t copy_len = MIN(size, FLASH_PARTITION_SECTOR_SIZE - writer->fill_len);
+        memcpy(writer->fill_buffer + writer->fill_len, data, copy_len);
+        writer->fill_len += copy_len;
+        writer->bytes_queued += copy_len;
+        data += copy_len;
+        size -= copy_len;
+
+        if (writer->fill_len == FLASH_PARTITION_SECTOR_SIZE) {
+            flash_partition_writer_submit(writer);
+        }
+    }
+
+    return writer->err;
+}
+
+/*
+ * Flush the partially filled last sector, wait for the worker to finish, and free everything. Must be called after a
+ * successful start even if a write failed. Returns the number of bytes queued in bytes_written, which were all
+ * persisted if the return is ESP_OK. If unchanged is set, nothing was written because the data was identical to the
+ * reference, and the destination range was left untouched.
+ */
+esp_err_t flash_partition_writer_finish(flash_partition_writer_t *writer, size_t *bytes_written, bool *unchanged) {
+    if (writer->fill_buffer && writer->fill_len > 0) {
+        flash_partition_writer_submit(writer);
+    }
+
+    flash_write_job_t exit_job = {0};
+    xQueueSend(writer->write_queue, &exit_job, portMAX_DELAY);
+    xSemaphoreTake(writer->done, portMAX_DELAY);
+
+    esp_err_t err = writer->err;
+    if (bytes_written) {
+        *bytes_written = writer->bytes_queued;
+    }
+    if (unchanged) {
+        *unchanged = err == ESP_OK && writer->matches_reference && writer->bytes_queued > 0;
+    }
+
+    flash_partition_writer_free(writer);
+    return err;
+}
@@ -0,0 +1,213 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "forecast.h"
+
+static const char *compass_strs[] = {
+    "N", "NNE", "NE", "ENE", "E", "ESE", "SE", "SSE", "S", "SSW", "SW", "WSW", "W", "WNW", "NW", "NNW",
+};
+
+static inline uint8_t forecast_slot(const forecast_t *forecast, uint8_t index) {
+    return (forecast->head + index) % FORECAST_MAX_ENTRIES;
+}
+
+/*
+ * Append the entry for the hour after the last one. A full buffer drops its oldest entry to make room.
+ */
+static void forecast_push(forecast_t *forecast, const forecast_entry_t *entry) {
+    if (forecast->count == FORECAST_MAX_ENTRIES) {
+        forecast->head = forecast_slot(forecast, 1);
+        forecast->head_epoch_secs += FORECAST_INTERVAL_SECS;
+        forecast->count--;
+    }
+
+    memcpy(&forecast->entries[forecast_slot(forecast, forecast->count)], entry, sizeof(forecast_entry_t));
+    forecast->count++;
+}
+
+void forecast_init(forecast_t *forecast) {
+    memset(forecast, 0, sizeof(forecast_t));
+}
+
+/*
+ * Drop every entry for an hour that's completely over, so the head is the current hour.
+ */
+void forecast_drop_expired(forecast_t *forecast, time_t now_epoch_secs) {
+    while (forecast->count > 0 && now_epoch_secs >= forecast->head_epoch_secs + FORECAST_INTERVAL_SECS) {
+        forecast->head = forecast_slot(forecast, 1);
+        forecast->head_epoch_secs += FORECAST_INTERVAL_SECS;
+        forecast->count--;
+    }
+}
+
+/*
+ * Merge a newer series in. Hours it covers are replaced and it's appended after the hours before it. If it doesn't
+ * connect to the cached series (starts before it or after a gap) it replaces it entirely.
+ */
+void forecast_merge(forecast_t *forecast, const forecast_t *newer) {
+    if (newer->count == 0) {
+        return;
+    }
+
+    time_t cached_end_epoch_secs = forecast->head_epoch_secs + (time_t)forecast->count * FORECAST_INTERVAL_SECS;
+    if (forecast->count == 0 || newer->head_epoch_secs < forecast->head_epoch_secs ||
+        newer->head_epoch_secs > cached_end_epoch_secs ||
+        (newer->head_epoch_secs - forecast->head_epoch_secs) % FORECAST_INTERVAL_SECS != 0) {
+        forecast_init(forecast);
+        forecast->head_epoch_secs = newer->head_epoch_secs;
+    } else {
+        forecast->count = (newer->head_epoch_secs - forecast->head_epoch_secs) / FORECAST_INTERVAL_SECS;
+    }
+
+    for (uint8_t i = 0; i < newer->count; i++) {
+        forecast_push(forecast, forecast_get_entry(newer, i, NULL));
+    }
+}
+
+/*
+ * Entry index hours after the head, NULL if there isn't one. epoch_secs optionally gets the start of its hour.
+ */
+const forecast_entry_t *forecast_get_entry(const forecast_t *forecast, uint8_t index, time_t *epoch_secs) {
+    if (index >= forecast->count) {
+        return NULL;
+    }
+
+    if (epoch_secs) {
+        *epoch_secs = forecast->head_epoch_secs + (time_t)index * FORECAST_INTERVAL_SECS;
+    }
+    return &forecast->entries[forecast_slot(forecast, index)];
+}
+
+/*
+ * Entry for the hour containing epoch_secs, NULL if the series doesn't cover it. index optionally gets its index.
+ */
+const forecast_entry_t *forecast_find_entry(const forecast_t *forecast, time_t epoch_secs, uint8_t *index) {
+    if (forecast->count == 0 || epoch_secs < forecast->head_epoch_secs) {
+        return NULL;
+    }
+
+    time_t offset = (epoch_secs - forecast->head_epoch_secs) / FORECAST_INTERVAL_SECS;
+    if (offset >= forecast->count) {
+        return NULL;
+    }
+
+    if (index) {
+        *index = (uint8_t)offset;
+    }
+    return forecast_get_entry(forecast, (uint8_t)offset, NULL);
+}
+
+uint8_t forecast_get_count(const forecast_t *forecast) {
+    return forecast->count;
+}
+
+/*
+ * Fill out conditions the same way a conditions response would for the hour containing epoch_secs. Whether the tide is
+ * rising comes from the neighboring hour. Returns false and leaves conditions untouched if the hour isn't covered.
+ */
+bool forecast_get_conditions(const forecast_t *forecast, time_t epoch_secs, conditions_t *conditions) {
+    uint8_t                 index = 0;
+    const forecast_entry_t *entry = forecast_find_entry(forecast, epoch_secs, &index);
+    if (entry == NULL) {
+        return false;
+    }
+
+    const forecast_entry_t *next     = forecast_get_entry(forecast, index + 1, NULL);
+    const forecast_entry_t *previous = index > 0 ? forecast_get_entry(forecast, index - 1, NULL) : NULL;
+    bool                    rising   = true;
+    if (next) {
+        rising = next->tide_height_cft > entry->tide_height_cft;
+    } else if (previous) {
+        rising = entry->tide_height_cft > previous->tide_height_cft;
+    }
+
+    // tide_height only fits two digits before the decimal point
+    unsigned int tide_abs = abs(entry->tide_height_cft);
+    if (tide_abs > 9999) {
+        tide_abs = 9999;
+    }
+    memset(conditions, 0, sizeof(conditions_t));
+    conditions->temperature    = entry->temperature;
+    conditions->wind_speed     = entry->wind_speed;
+    conditions->is_tide_rising = rising;
+    snprintf(conditions->wind_dir,
+             sizeof(conditions->wind_dir),
+             "%s",
+             compass_strs[((entry->wind_dir_deg % 360) * 16 + 180) / 360 % 16]);
+    snprintf(conditions->tide_height,
+             sizeof(conditions->tide_height),
+             "%s%u.%02u",
+             entry->tide_height_cft < 0 ? "-" : "",
+             tide_abs / 100,
+             tide_abs % 100);
+    return true;
+}
+
+void forecast_decoder_init(forecast_decoder_t *decoder) {
+    memset(decoder, 0, sizeof(forecast_decoder_t));
+}
+
+static bool forecast_decoder_header_valid(const forecast_header_t *header) {
+    return memcmp(header->magic, FORECAST_MAGIC, FORECAST_MAGIC_LEN) == 0 && header->version == FORECAST_VERSION &&
+           header->entry_size >= sizeof(forecast_entry_t);
+}
+
+void forecast_decoder_feed(forecast_decoder_t *decoder, const uint8_t *data, size_t size) {
+    while (size > 0 && !decoder->failed) {
+        if (decoder->header_len < sizeof(forecast_header_t)) {
+            size_t header_bytes = sizeof(forecast_header_t) - decoder->header_len;
+            if (header_bytes > size) {
+                header_bytes = size;
+            }
+            memcpy((uint8_t *)&decoder->header + decoder->header_len, data, header_bytes);
+            decoder->header_len += header_bytes;
+            data += header_bytes;
+            size -= header_bytes;
+
+            if (decoder->header_len == sizeof(forecast_header_t)) {
+                decoder->failed                 = !forecast_decoder_header_valid(&decoder->header);
+                decoder->series.head_epoch_secs = (time_t)decoder->header.start_epoch_secs;
+            }
+            continue;
+        }
+
+        if (decoder->entries_received == decoder->header.num_entries) {
+            // More than the header said there'd be
+            decoder->failed = true;
+            break;
+        }
+
+        // Only the fields this firmware knows are kept, the rest of the entry is skipped
+        size_t entry_bytes = decoder->header.entry_size - decoder->entry_pos;
+        if (entry_bytes > size) {
+            entry_bytes = size;
+        }
+        if (decoder->entry_pos < sizeof(forecast_entry_t)) {
+            size_t keep = sizeof(forecast_entry_t) - decoder->entry_pos;
+            memcpy(decoder->entry_buf + decoder->entry_pos, data, keep < entry_bytes ? keep : entry_bytes);
+        }
+        decoder->entry_pos += entry_bytes;
+        data += entry_bytes;
+        size -= entry_bytes;
+
+        if (decoder->entry_pos == decoder->header.entry_size) {
+            forecast_push(&decoder->series, (const forecast_entry_t *)decoder->entry_buf);
+            decoder->entries_received++;
+            decoder->entry_pos = 0;
+        }
+    }
+}
+
+/*
+ * Merge the decoded series into forecast if the response was complete and valid, otherwise forecast is untouched.
+ */
+bool forecast_decoder_finish(forecast_decoder_t *decoder, forecast_t *forecast) {
+    if (decoder->failed || decoder->header_len < sizeof(forecast_header_t) ||
+        decoder->entries_received != decoder->header.num_entries || decoder->entry_pos != 0) {
+        return false;
+    }
+
+    forecast_merge(forecast, &decoder->series);
+    return true;
+}
@@ -0,0 +1,15 @@
+#include "hash.h"
+
+/*
+ * 32 bit FNV-1a of a null terminated string. Cheap and well distributed for short keys like urls and display text, not
+ * meant to resist collisions on purpose.
+ */
+uint32_t hash_fnv1a(const char *str) {
+    uint32_t hash = 2166136261u;
+    while (*str) {
+        hash ^= (uint8_t)*str++;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
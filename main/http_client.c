@@ -1,4 +1,5 @@
 #include <string.h>
+#include <strings.h>
 
 #include "esp_crt_bundle.h"
 #include "esp_mac.h"
@@ -8,7 +9,10 @@
 #include "memfault/panics/assert.h"
 
 #include "constants.h"
+#include "flash_partition.h"
+#include "hash.h"
 #include "http_client.h"
+#include "http_queue.h"
 #include "scheduler_task.h"
 #include "spot_check.h"
 #include "wifi.h"
@@ -21,9 +25,47 @@
 #define MAX_QUERY_PARAM_LENGTH 15
 #define MAX_READ_BUFFER_SIZE 1024
 
-static SemaphoreHandle_t request_lock;
-static uint16_t          failed_http_perform_reqs;
-static uint16_t          failed_http_perform_posts;
+// Clients are kept open between requests so a burst of requests to the same server (conditions and all the charts)
+// only pays for one TLS handshake. Requests only ever run one at a time on the http queue task, two keeps both our
+// server and a custom screen url warm, any other origin evicts the least recently used.
+#define HTTP_CLIENT_POOL_SIZE (2)
+#define HTTP_CLIENT_POOL_ORIGIN_MAX_LEN (64)
+// Close connections idle longer than this instead of reusing them, most servers drop idle keep-alive connections
+// somewhere between 5s and 60s and a write into a dead connection costs more than reconnecting
+#define HTTP_CLIENT_POOL_IDLE_TIMEOUT_MS (15 * MS_PER_SEC)
+
+typedef struct {
+    esp_http_client_handle_t handle;
+    char                     origin[HTTP_CLIENT_POOL_ORIGIN_MAX_LEN];  // scheme://host[:port] the handle is set up for
+    bool                     in_use;
+    bool                     connected;  // connection left open by the last request, reusable
+    bool                     reused;     // current request was sent over an already open connection
+    TickType_t               last_used_ticks;
+} http_client_pool_entry_t;
+
+static SemaphoreHandle_t        pool_lock;
+static http_client_pool_entry_t pool[HTTP_CLIENT_POOL_SIZE];
+static uint32_t                 pool_hits;
+static uint32_t                 pool_misses;
+static uint16_t                 failed_http_perform_reqs;
+static uint16_t                 failed_http_perform_posts;
+
+// Chunked reads go through this instead of a malloc per response, which fragmented the heap on a device that runs for
+// months. Only one request is ever in flight (they all run on the http queue task) so one buffer is enough.
+static uint8_t read_buffer[MAX_READ_BUFFER_SIZE];
+
+/*
+ * Copy a response header value into a validator field, leaving it empty if it doesn't fit since a truncated validator
+ * would never match
+ */
+static void http_client_save_validator_header(char *dest, size_t dest_size, const char *value) {
+    if (strlen(value) < dest_size) {
+        strcpy(dest, value);
+    } else {
+        log_printf(LOG_LEVEL_WARN, "Validator header value '%s' too long to store, ignoring", value);
+        dest[0] = '\0';
+    }
+}
 
 /* Technically unnecessary, should be stubbed out for non-debug build */
 esp_err_t http_event_handler(esp_http_client_event_t *event) {
@@ -42,6 +84,16 @@ esp_err_t http_event_handler(esp_http_client_event_t *event) {
                        "HTTP_EVENT_ON_HEADER, key=%s, value=%s",
                        event->header_key,
                        event->header_value);
+
+            // user_data is only set for GETs, pointing at the request's response_validator
+            http_validator_t *validator = (http_validator_t *)event->user_data;
+            if (validator && strcasecmp(event->header_key, "ETag") == 0) {
+                http_client_save_validator_header(validator->etag, sizeof(validator->etag), event->header_value);
+            } else if (validator && strcasecmp(event->header_key, "Last-Modified") == 0) {
+                http_client_save_validator_header(validator->last_modified,
+                                                  sizeof(validator->last_modified),
+                                                  event->header_value);
+            }
             break;
         case HTTP_EVENT_ON_DATA:
             log_printf(LOG_LEVEL_DEBUG, "HTTP_EVENT_ON_DATA, len=%d", event->data_len);
@@ -59,6 +111,155 @@ esp_err_t http_event_handler(esp_http_client_event_t *event) {
     return ESP_OK;
 }
 
+/*
+ * Copy the scheme://host[:port] part of url into origin. Requests to the same origin can share a connection.
+ */
+static void http_client_get_origin(const char *url, char *origin, size_t origin_size) {
+    const char *host = strstr(url, "://");
+    host             = host ? host + 3 : url;
+    size_t len       = MIN((size_t)(host - url) + strcspn(host, "/?#"), origin_size - 1);
+    memcpy(origin, url, len);
+    origin[len] = '\0';
+}
+
+/*
+ * Returns the pool entry a client handle belongs to, NULL for unpooled clients. Must be called with pool_lock held.
+ */
+static http_client_pool_entry_t *http_client_pool_find(esp_http_client_handle_t client) {
+    for (int i = 0; i < HTTP_CLIENT_POOL_SIZE; i++) {
+        if (pool[i].in_use && pool[i].handle == client) {
+            return &pool[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Get a client for config->url, reusing the open connection of an idle pooled client for the same origin if there is
+ * one. A pooled client for another origin is only evicted if there's no empty slot left. If every pooled client is
+ * busy a fresh unpooled one is inited. Must be given back with http_client_release. Returns NULL if init failed.
+ */
+static esp_http_client_handle_t http_client_acquire(esp_http_client_config_t *config) {
+    char origin[HTTP_CLIENT_POOL_ORIGIN_MAX_LEN];
+    http_client_get_origin(config->url, origin, sizeof(origin));
+
+    xSemaphoreTake(pool_lock, portMAX_DELAY);
+
+    http_client_pool_entry_t *entry = NULL;
+    for (int i = 0; i < HTTP_CLIENT_POOL_SIZE && !entry; i++) {
+        if (!pool[i].in_use && pool[i].handle && strcmp(pool[i].origin, origin) == 0) {
+            entry = &pool[i];
+        }
+    }
+    for (int i = 0; i < HTTP_CLIENT_POOL_SIZE && !entry; i++) {
+        if (!pool[i].in_use && !pool[i].handle) {
+            entry = &pool[i];
+        }
+    }
+    for (int i = 0; i < HTTP_CLIENT_POOL_SIZE && !entry; i++) {
+        if (!pool[i].in_use) {
+            log_printf(LOG_LEVEL_DEBUG, "Evicting pooled http client for %s", pool[i].origin);
+            esp_http_client_cleanup(pool[i].handle);
+            pool[i].handle    = NULL;
+            pool[i].connected = false;
+            entry             = &pool[i];
+        }
+    }
+
+    if (!entry) {
+        pool_misses++;
+        xSemaphoreGive(pool_lock);
+        memfault_metrics_heartbeat_add(MEMFAULT_METRICS_KEY(http_pool_misses), 1);
+        log_printf(LOG_LEVEL_WARN, "All %u pooled http clients busy, using unpooled client", HTTP_CLIENT_POOL_SIZE);
+        return esp_http_client_init(config);
+    }
+
+    TickType_t idle_ticks = xTaskGetTickCount() - entry->last_used_ticks;
+    if (entry->connected && idle_ticks > pdMS_TO_TICKS(HTTP_CLIENT_POOL_IDLE_TIMEOUT_MS)) {
+        log_printf(LOG_LEVEL_DEBUG, "Pooled connection to %s idle too long, reconnecting", origin);
+        esp_http_client_close(entry->handle);
+        entry->connected = false;
+    }
+
+    if (entry->handle) {
+        // Everything but the method and url sticks to a handle between requests, reset what the last request set
+        esp_http_client_set_url(entry->handle, config->url);
+        esp_http_client_set_user_data(entry->handle, config->user_data);
+        esp_http_client_set_post_field(entry->handle, NULL, 0);
+        esp_http_client_delete_header(entry->handle, "If-None-Match");
+        esp_http_client_delete_header(entry->handle, "If-Modified-Since");
+    } else {
+        entry->handle    = esp_http_client_init(config);
+        entry->connected = false;
+        strcpy(entry->origin, origin);
+    }
+
+    esp_http_client_handle_t client = entry->handle;
+    if (client) {
+        entry->in_use = true;
+        entry->reused = entry->connected;
+        if (entry->reused) {
+            pool_hits++;
+        } else {
+            pool_misses++;
+        }
+    }
+
+    xSemaphoreGive(pool_lock);
+
+    if (client) {
+        memfault_metrics_heartbeat_add(entry->reused ? MEMFAULT_METRICS_KEY(http_pool_hits)
+                                                     : MEMFAULT_METRICS_KEY(http_pool_misses),
+                                       1);
+        log_printf(LOG_LEVEL_DEBUG,
+                   "Using pooled http client for %s, %s",
+                   origin,
+                   entry->reused ? "reusing open connection" : "connecting");
+    }
+
+    return client;
+}
+
+/*
+ * Give back a client from http_client_acquire. keep_alive must only be set if the full response has been read, the
+ * connection is then left open for the next request to the same origin. Otherwise it's closed, but a pooled handle is
+ * kept around so its saved TLS session can be resumed on the next connect.
+ */
+static esp_err_t http_client_release(esp_http_client_handle_t client, bool keep_alive) {
+    esp_err_t err = ESP_OK;
+
+    xSemaphoreTake(pool_lock, portMAX_DELAY);
+    http_client_pool_entry_t *entry = http_client_pool_find(client);
+    if (!entry) {
+        err = esp_http_client_cleanup(client);
+    } else {
+        if (!keep_alive) {
+            err = esp_http_client_close(client);
+        }
+        entry->connected       = keep_alive;
+        entry->reused          = false;
+        entry->last_used_ticks = xTaskGetTickCount();
+        entry->in_use          = false;
+    }
+    xSemaphoreGive(pool_lock);
+
+    return err;
+}
+
+/*
+ * Returns whether the request currently in flight on client was sent over a connection left open by an earlier one.
+ * If so and the request fails without any response, the server most likely closed the connection while it was idle.
+ */
+static bool http_client_is_reused(esp_http_client_handle_t client) {
+    xSemaphoreTake(pool_lock, portMAX_DELAY);
+    http_client_pool_entry_t *entry  = http_client_pool_find(client);
+    bool                      reused = entry && entry->reused;
+    xSemaphoreGive(pool_lock);
+
+    return reused;
+}
+
 /*
  * Request-type-agnostic function for initiating the actual http contact with server.
  * NOTE: only performs the HTTP request (and in the case of a POST, writes the post data to the socket). Does not read
@@ -70,6 +271,8 @@ static bool http_client_perform(http_request_t *request_obj, esp_http_client_han
     MEMFAULT_ASSERT(client);
     MEMFAULT_ASSERT(request_obj);
 
+    request_obj->status = 0;
+
     // Build out most shared variables here to minimize number of checks to req_type later in function.
     // TODO :: really all of this stuff should be added to the request_obj_t struct in the build_request functions, so
     // this func can be fully (or at least moreso) request-type-agnostic and just blindly populate stuff
@@ -128,82 +331,107 @@ static bool http_client_perform(http_request_t *request_obj, esp_http_client_han
         .buffer_size       = MAX_READ_BUFFER_SIZE,
         .transport_type    = HTTP_TRANSPORT_OVER_SSL,
         .crt_bundle_attach = esp_crt_bundle_attach,
+        .keep_alive_enable = true,
+#ifdef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+        // Reconnects of a pooled client (after an idle timeout or the server closing) resume the TLS session instead
+        // of a full handshake
+        .save_client_session = true,
+#endif
     };
 
-    BaseType_t lock_success = xSemaphoreTake(request_lock, pdMS_TO_TICKS(5000));
-    if (lock_success == pdFALSE) {
-        log_printf(LOG_LEVEL_ERROR,
-                   "Failed to take http req lock in timeout, returning failure for the request status but http client "
-                   "never opened so no cleanup needed");
+    if (request_obj->req_type == HTTP_REQ_TYPE_GET) {
+        // Hash of the full url including query params, so a validator is only ever sent back for the exact request it
+        // came from. A Last-Modified from one spot's data says nothing about another spot's.
+        uint32_t url_hash = hash_fnv1a(req_url);
+        memset(&request_obj->get_args.response_validator, 0, sizeof(http_validator_t));
+        request_obj->get_args.response_validator.url_hash = url_hash;
+        request_obj->get_args.not_modified                = false;
+        http_config.user_data                             = &request_obj->get_args.response_validator;
+
+        if (request_obj->get_args.validator && request_obj->get_args.validator->url_hash != url_hash) {
+            log_printf(LOG_LEVEL_DEBUG, "Stored validator is for a different url, sending unconditional request");
+            request_obj->get_args.validator = NULL;
+        }
     }
 
     bool req_start_success = true;
-    if (lock_success) {
-        do {
-            log_printf(LOG_LEVEL_INFO,
-                       "Initing http client for %s request with url '%s:%d'...",
-                       req_type_str,
-                       http_config.url,
-                       http_config.port);
-            *client = esp_http_client_init(&http_config);
-            if (!(*client)) {
-                log_printf(LOG_LEVEL_INFO, "Error initing http client, returning without sending request");
-                (*failed_error_ptr)++;
-                req_start_success = false;
-                break;
-            }
+    do {
+        log_printf(LOG_LEVEL_INFO,
+                   "Initing http client for %s request with url '%s:%d'...",
+                   req_type_str,
+                   http_config.url,
+                   http_config.port);
+        *client = http_client_acquire(&http_config);
+        if (!(*client)) {
+            log_printf(LOG_LEVEL_INFO, "Error initing http client, returning without sending request");
+            (*failed_error_ptr)++;
+            req_start_success = false;
+            break;
+        }
 
-            size_t open_data_size = 0;
-            ESP_ERROR_CHECK(esp_http_client_set_method(*client, method));
-            ESP_ERROR_CHECK(esp_http_client_set_header(*client, "Content-Type", content_type));
-            if (request_obj->req_type == HTTP_REQ_TYPE_POST) {
-                ESP_ERROR_CHECK(esp_http_client_set_post_field(*client,
-                                                               request_obj->post_args.post_data,
-                                                               request_obj->post_args.post_data_size));
-                open_data_size = request_obj->post_args.post_data_size;
+        size_t open_data_size = 0;
+        ESP_ERROR_CHECK(esp_http_client_set_method(*client, method));
+        ESP_ERROR_CHECK(esp_http_client_set_header(*client, "Content-Type", content_type));
+        if (request_obj->req_type == HTTP_REQ_TYPE_GET && request_obj->get_args.validator) {
+            const http_validator_t *validator = request_obj->get_args.validator;
+            if (validator->etag[0] != '\0') {
+                ESP_ERROR_CHECK(esp_http_client_set_header(*client, "If-None-Match", validator->etag));
             }
+            if (validator->last_modified[0] != '\0') {
+                ESP_ERROR_CHECK(esp_http_client_set_header(*client, "If-Modified-Since", validator->last_modified));
+            }
+        }
+        if (request_obj->req_type == HTTP_REQ_TYPE_POST) {
+            ESP_ERROR_CHECK(esp_http_client_set_post_field(*client,
+                                                           request_obj->post_args.post_data,
+                                                           request_obj->post_args.post_data_size));
+            open_data_size = request_obj->post_args.post_data_size;
+        }
 
-            esp_err_t err = esp_http_client_open(*client, open_data_size);
+        esp_err_t err = esp_http_client_open(*client, open_data_size);
+        if (err != ESP_OK && http_client_is_reused(*client)) {
+            // Server most likely closed the kept-alive connection, reconnect (resuming the TLS session) and retry
+            log_printf(LOG_LEVEL_DEBUG, "Reused connection failed to open (%s), reconnecting", esp_err_to_name(err));
+            esp_http_client_close(*client);
+            err = esp_http_client_open(*client, open_data_size);
+        }
 
-            if (err != ESP_OK) {
-                log_printf(LOG_LEVEL_ERROR, "Error opening http client, error: %s", esp_err_to_name(err));
-                (*failed_error_ptr)++;
+        if (err != ESP_OK) {
+            log_printf(LOG_LEVEL_ERROR, "Error opening http client, error: %s", esp_err_to_name(err));
+            (*failed_error_ptr)++;
 
-                err = esp_http_client_cleanup(*client);
-                if (err != ESP_OK) {
-                    log_printf(LOG_LEVEL_ERROR, "Error cleaning up http client connection after failure to open!!!");
-                }
+            err = http_client_release(*client, false);
+            if (err != ESP_OK) {
+                log_printf(LOG_LEVEL_ERROR, "Error cleaning up http client connection after failure to open!!!");
+            }
 
+            *client           = NULL;
+            req_start_success = false;
+            break;
+        } else if (request_obj->req_type == HTTP_REQ_TYPE_POST) {
+            // POSTs have an extra step after opening to actually write the data, but we only want to perform it if
+            // the open was successful. GETs are fine with just the open.
+            int write_err = esp_http_client_write(*client,
+                                                  request_obj->post_args.post_data,
+                                                  request_obj->post_args.post_data_size);
+            if (write_err < 0) {
+                log_printf(LOG_LEVEL_ERROR, "Error performing POST in call to esp_http_client_write");
                 req_start_success = false;
                 break;
-            } else if (request_obj->req_type == HTTP_REQ_TYPE_POST) {
-                // POSTs have an extra step after opening to actually write the data, but we only want to perform it if
-                // the open was successful. GETs are fine with just the open.
-                int write_err = esp_http_client_write(*client,
-                                                      request_obj->post_args.post_data,
-                                                      request_obj->post_args.post_data_size);
-                if (write_err < 0) {
-                    log_printf(LOG_LEVEL_ERROR, "Error performing POST in call to esp_http_client_write");
-                    req_start_success = false;
-                    break;
-                }
-
-                // Preemptively check status here even though it's also checked inthe http_client_check-response
-                // function called after this
-                uint16_t status   = esp_http_client_get_status_code(*client);
-                req_start_success = status <= 200 || status > 299;
             }
 
-        } while (0);
-    }
+            // Preemptively check status here even though it's also checked inthe http_client_check-response
+            // function called after this
+            uint16_t status   = esp_http_client_get_status_code(*client);
+            req_start_success = status <= 200 || status > 299;
+        }
 
-    // Always give back no matter what happened with the req
-    xSemaphoreGive(request_lock);
+    } while (0);
 
     // Any false value for req_start_success means the http client needs to be cleaned up
     if (!req_start_success) {
-        if (!(*client)) {
-            esp_err_t cleanup_err = esp_http_client_cleanup(*client);
+        if (*client) {
+            esp_err_t cleanup_err = http_client_release(*client, false);
             if (cleanup_err != ESP_OK) {
                 log_printf(
                     LOG_LEVEL_ERROR,
@@ -223,21 +451,45 @@ static bool http_client_perform(http_request_t *request_obj, esp_http_client_han
  * Check headers and status code to make sure request was successful. Should only be used internally by http request
  * functions before they read out data in different manners.
  *
- * * Returns success, content length returned through last arg.
+ * * Returns success, content length returned through last arg. A 304 to a conditional GET is a success with
+ * not_modified set in the request's get_args, in which case there's nothing to read and the client is already cleaned
+ * up. stale_connection is set if there was no response at all over a reused keep-alive connection, so the request is
+ * worth resending right away on a new one.
  */
-static bool http_client_check_response(esp_http_client_handle_t *client, int *content_length) {
+static bool http_client_check_response(http_request_t           *request_obj,
+                                       esp_http_client_handle_t *client,
+                                       int                      *content_length,
+                                       bool                     *stale_connection) {
     MEMFAULT_ASSERT(client);
     MEMFAULT_ASSERT(content_length);
+    MEMFAULT_ASSERT(stale_connection);
 
-    bool success = false;
+    bool success      = false;
+    bool reused       = http_client_is_reused(*client);
+    *stale_connection = false;
 
     // Kicks off and blocks until all headers downloaded. Can get remainder of headers (like status_code) from their
     // helper functions, content_length is returned directly
     *content_length = esp_http_client_fetch_headers(*client);
 
     // Check status to make sure we have actual good data to read out
-    int status = esp_http_client_get_status_code(*client);
-    if (status >= 200 && status <= 299) {
+    int status          = esp_http_client_get_status_code(*client);
+    request_obj->status = status;
+    if (status == 304 && request_obj->req_type == HTTP_REQ_TYPE_GET && request_obj->get_args.validator) {
+        log_printf(LOG_LEVEL_INFO, "Request success, not modified since last download (304)");
+        request_obj->get_args.not_modified = true;
+        *content_length                    = 0;
+
+        // Read out any body so the connection is clean for the next request
+        bool      keep_alive  = esp_http_client_flush_response(*client, NULL) == ESP_OK;
+        esp_err_t cleanup_err = http_client_release(*client, keep_alive);
+        if (cleanup_err != ESP_OK) {
+            log_printf(LOG_LEVEL_ERROR,
+                       "Call to esp_http_client_cleanup after 304 response failed with err: %s",
+                       esp_err_to_name(cleanup_err));
+        }
+        return true;
+    } else if (status >= 200 && status <= 299) {
         if (*content_length < 0) {
             log_printf(LOG_LEVEL_WARN,
                        "Status code successful (%d), but error fetching headers with negative content-length, bailing",
@@ -249,6 +501,9 @@ static bool http_client_check_response(esp_http_client_handle_t *client, int *co
             success = true;
             log_printf(LOG_LEVEL_INFO, "Request success! Status=%d, Content-length=%d", status, *content_length);
         }
+    } else if (status == 0 && reused) {
+        log_printf(LOG_LEVEL_INFO, "No response over reused connection, server likely closed it while idle");
+        *stale_connection = true;
     } else {
         log_printf(LOG_LEVEL_INFO,
                    "Request failed: status=%d, "
@@ -260,7 +515,7 @@ static bool http_client_check_response(esp_http_client_handle_t *client, int *co
     // If something failed, even on the server side (aka everything reads success but status code is 5XX), clean up but
     // DON'T kick to offline because the perform_with_retries func will handle that when it's finished with all retries
     if (!success) {
-        esp_err_t cleanup_err = esp_http_client_cleanup(*client);
+        esp_err_t cleanup_err = http_client_release(*client, false);
         if (cleanup_err != ESP_OK) {
             log_printf(
                 LOG_LEVEL_ERROR,
@@ -278,15 +533,25 @@ static bool http_client_check_response(esp_http_client_handle_t *client, int *co
  * period) and in comms with the server (receiving a 502 or other error status code). NOTE: That means this is blocking
  * until full headers are received!
  *
- * Returns content length header value through content_length pointer arg.
+ * Must be called from the http queue task, anything else should submit a http_queue_req_t instead.
+ *
+ * Returns content length header value through content_length pointer arg. For a conditional GET (get_args.validator
+ * set) check get_args.not_modified on success. If set, the server data hasn't changed, there's no response body, and
+ * the client has already been cleaned up so none of the http_client_read_response_to_* functions should be called.
  */
 bool http_client_perform_with_retries(http_request_t           *request_obj,
                                       uint8_t                   additional_retries,
                                       esp_http_client_handle_t *client,
                                       int                      *content_length) {
-    uint8_t attempts = 0;
-    bool    success  = false;
+    // Everything goes through the queue so only one request is ever in flight
+    MEMFAULT_ASSERT(http_queue_in_queue_task());
+
+    uint8_t attempts         = 0;
+    bool    success          = false;
+    bool    stale_retry_used = false;
     while ((attempts <= additional_retries) && !success) {
+        bool stale_connection = false;
+
         // This typically succeeds even with no internet connection, I think it only fails if there's no network
         // connection period
         success = http_client_perform(request_obj, client);
@@ -294,19 +559,27 @@ bool http_client_perform_with_retries(http_request_t           *request_obj,
         if (success) {
             // This is the main failure when no access to server, as this is the blocking call that actually waits for
             // full HTTP response w/ headers
-            success = http_client_check_response(client, content_length);
+            success = http_client_check_response(request_obj, client, content_length, &stale_connection);
         } else {
             *content_length = 0;
         }
 
-        attempts++;
+        // A dead keep-alive connection isn't a real failure, the stale connection is closed now so the resend gets a
+        // fresh one. Only once per request, anything after that counts against the retries.
+        if (stale_connection && !stale_retry_used) {
+            stale_retry_used = true;
+        } else {
+            attempts++;
+        }
     }
 
     // Only Kick into offline mode if this is not a network request associated with boot (so for now just healthcheck).
     // This allows init logic in main.c to render the proper info screens based on logic surrounding different possible
     // states with or without prov info, network connection, and internet connection
     // TODO :: scheduler shouldn't be a dependency in here, so theoretically this logic should be somewhere else
-    if (!success && scheduler_get_mode() != SCHEDULER_MODE_INIT) {
+    bool server_responded = request_obj->status != 0;
+    bool optional         = request_obj->req_type == HTTP_REQ_TYPE_GET && request_obj->get_args.optional;
+    if (!success && scheduler_get_mode() != SCHEDULER_MODE_INIT && !(optional && server_responded)) {
         spot_check_set_offline_mode();
     }
 
@@ -331,7 +604,8 @@ http_request_t http_client_build_get_request(char                *endpoint,
         query_param temp_params[num_params];
         if (strcmp(endpoint, "conditions") == 0 || strcmp(endpoint, "screen_update") == 0 ||
             strcmp(endpoint, "swell_chart") == 0 || strcmp(endpoint, "tides_chart") == 0 ||
-            strcmp(endpoint, "wind_chart") == 0) {
+            strcmp(endpoint, "wind_chart") == 0 || strcmp(endpoint, "batch") == 0 ||
+            strcmp(endpoint, "forecast") == 0) {
             MEMFAULT_ASSERT(num_params == 4);
 
             temp_params[0] = (query_param){.key = "device_id", .value = spot_check_get_serial()};
@@ -458,7 +732,8 @@ esp_err_t http_client_read_response_to_buffer(esp_http_client_handle_t *client,
     // Intentionally not setting offline mode here as it seems unlikely we're actually offline if we performed request,
     // got a successfully status, and then failed reading out all data. If network really is gone, then offline mode
     // will get set next request
-    esp_err_t cleanup_err = esp_http_client_cleanup(*client);
+    bool      keep_alive  = err == ESP_OK && esp_http_client_is_complete_data_received(*client);
+    esp_err_t cleanup_err = http_client_release(*client, keep_alive);
     if (cleanup_err != ESP_OK) {
         err = cleanup_err;
         log_printf(LOG_LEVEL_ERROR,
@@ -472,17 +747,21 @@ esp_err_t http_client_read_response_to_buffer(esp_http_client_handle_t *client,
 }
 
 /*
- * Read response from http request in chunks into flash partition. Request must have been sent through client using
- * http_client_perform_with_retries. Caller must erase desired location in flash first.
- * Returns ESP_OK on success, ESP_FAIL for failure. Returns total bytes saved to NVS in pointer arg.
+ * Read response from http request in chunks into flash partition through a writer the caller has started with
+ * flash_partition_writer_start. Caller is responsible for finishing the writer after this returns, which is when the
+ * data is guaranteed to be in flash. Request must have been sent through client using
+ * http_client_perform_with_retries. If chunk_cb is not NULL, it's called with each chunk after it has been queued for
+ * flash so the caller can consume the data without reading it back. Returns ESP_OK on success, ESP_FAIL for failure.
+ * Returns total bytes received in pointer arg.
  */
 esp_err_t http_client_read_response_to_flash(esp_http_client_handle_t *client,
                                              int                       content_length,
-                                             esp_partition_t          *partition,
-                                             uint32_t                  offset_into_partition,
-                                             size_t                   *bytes_saved_size) {
+                                             flash_partition_writer_t *writer,
+                                             size_t                   *bytes_saved_size,
+                                             http_client_chunk_cb_t    chunk_cb,
+                                             void                     *chunk_cb_ctx) {
     MEMFAULT_ASSERT(client);
-    MEMFAULT_ASSERT(partition);
+    MEMFAULT_ASSERT(writer);
 
     esp_err_t err            = ESP_FAIL;
     size_t    bytes_received = 0;
@@ -498,47 +777,38 @@ esp_err_t http_client_read_response_to_flash(esp_http_client_handle_t *client,
                    content_length,
                    MAX_READ_BUFFER_SIZE);
 
-        uint32_t moving_screen_img_addr = offset_into_partition;
-        int      length_received        = 0;
-        uint8_t *response_data          = malloc(MAX_READ_BUFFER_SIZE);
-        if (!response_data) {
-            log_printf(LOG_LEVEL_ERROR, "Malloc of %u bytes failed for http response!", content_length + 1);
-            break;
-        }
-
+        int      length_received = 0;
+        uint8_t *response_data   = read_buffer;
+        bool     write_failed    = false;
         do {
-            // Pull in chunk and immediately write to flash
+            // Pull in chunk and hand it to the writer, which programs flash while we wait on the next chunk
             length_received = esp_http_client_read(*client, (char *)response_data, MAX_READ_BUFFER_SIZE);
             if (length_received > 0) {
-                if (moving_screen_img_addr + length_received > partition->size) {
-                    log_printf(LOG_LEVEL_ERROR,
-                               "Attempting to write 0x%02X bytes to partition at offset 0x%02X which would "
-                               "overflow the boundary of 0x%02X bytes, aborting",
-                               length_received,
-                               moving_screen_img_addr,
-                               partition->size);
+                if (flash_partition_writer_write(writer, response_data, length_received) != ESP_OK) {
+                    write_failed = true;
                     break;
                 }
-                esp_partition_write(partition, moving_screen_img_addr, response_data, length_received);
-                log_printf(LOG_LEVEL_DEBUG,
-                           "Wrote %d bytes to screen image partition at offset %d",
-                           length_received,
-                           moving_screen_img_addr);
-                moving_screen_img_addr += length_received;
+                if (chunk_cb) {
+                    chunk_cb(response_data, length_received, bytes_received, chunk_cb_ctx);
+                }
                 bytes_received += length_received;
             }
         } while (length_received > 0);
 
-        if (response_data) {
-            free(response_data);
+        if (write_failed) {
+            log_printf(LOG_LEVEL_ERROR,
+                       "Error writing response to flash after %zu bytes: %s",
+                       bytes_received,
+                       esp_err_to_name(writer->err));
+            break;
         }
 
         if (length_received < 0) {
-            // NVS has already been marked as invalid at time of flash erase, so just return error
+            // NVS has already been marked as invalid before the download started, so just return error
             log_printf(LOG_LEVEL_ERROR, "Error reading response after successful http client request");
             break;
         } else {
-            log_printf(LOG_LEVEL_DEBUG, "Rcvd %zu bytes total of response data and saved to flash", bytes_received);
+            log_printf(LOG_LEVEL_DEBUG, "Rcvd %zu bytes total of response data and queued to flash", bytes_received);
             err = ESP_OK;
         }
     } while (0);
@@ -546,12 +816,13 @@ esp_err_t http_client_read_response_to_flash(esp_http_client_handle_t *client,
     // Intentionally not setting offline mode here as it seems unlikely we're actually offline if we performed request,
     // got a successfully status, and then failed reading out all data. If network really is gone, then offline mode
     // will get set next request
-    esp_err_t cleanup_err = esp_http_client_cleanup(*client);
+    bool      keep_alive  = err == ESP_OK && esp_http_client_is_complete_data_received(*client);
+    esp_err_t cleanup_err = http_client_release(*client, keep_alive);
     if (cleanup_err != ESP_OK) {
         err = cleanup_err;
         log_printf(LOG_LEVEL_ERROR,
-                   "Call to esp_http_client_cleanup after reading response to flash failed with err: %s. Malloced buff "
-                   "already freed so not altering bytes_received returned to caller",
+                   "Call to esp_http_client_cleanup after reading response to flash failed with err: %s. Not altering "
+                   "bytes_received returned to caller",
                    esp_err_to_name(cleanup_err));
     }
 
@@ -559,34 +830,77 @@ esp_err_t http_client_read_response_to_flash(esp_http_client_handle_t *client,
     return err;
 }
 
+/*
+ * Read response from http request in chunks, handing each to chunk_cb as it arrives. For responses that are neither
+ * a single buffer nor a single flash image, like a batch of resources. Request must have been sent through client
+ * using http_client_perform_with_retries. Returns ESP_OK on success, ESP_FAIL for failure. Returns total bytes
+ * received in pointer arg.
+ */
+esp_err_t http_client_read_response_to_cb(esp_http_client_handle_t *client,
+                                          int                       content_length,
+                                          http_client_chunk_cb_t    chunk_cb,
+                                          void                     *chunk_cb_ctx,
+                                          size_t                   *bytes_received_size) {
+    MEMFAULT_ASSERT(client);
+    MEMFAULT_ASSERT(chunk_cb);
+
+    esp_err_t err            = ESP_FAIL;
+    size_t    bytes_received = 0;
+    log_printf(LOG_LEVEL_INFO, "Reading %d payload bytes in chunks of size %u", content_length, MAX_READ_BUFFER_SIZE);
+
+    int length_received = 0;
+    do {
+        length_received = esp_http_client_read(*client, (char *)read_buffer, MAX_READ_BUFFER_SIZE);
+        if (length_received > 0) {
+            chunk_cb(read_buffer, length_received, bytes_received, chunk_cb_ctx);
+            bytes_received += length_received;
+        }
+    } while (length_received > 0);
+
+    if (length_received < 0) {
+        log_printf(LOG_LEVEL_ERROR, "Error reading response after successful http client request");
+    } else {
+        log_printf(LOG_LEVEL_DEBUG, "Rcvd %zu bytes total of response data", bytes_received);
+        err = ESP_OK;
+    }
+
+    bool      keep_alive  = err == ESP_OK && esp_http_client_is_complete_data_received(*client);
+    esp_err_t cleanup_err = http_client_release(*client, keep_alive);
+    if (cleanup_err != ESP_OK) {
+        err = cleanup_err;
+        log_printf(LOG_LEVEL_ERROR,
+                   "Call to esp_http_client_cleanup after reading response to callback failed with err: %s",
+                   esp_err_to_name(cleanup_err));
+    }
+
+    *bytes_received_size = bytes_received;
+    return err;
+}
+
 /*
  * Perform a test query to make sure we actually have an active internet connection. NOTE: blocking, so make sure
  * whatever is calling can wait
  */
 bool http_client_check_internet() {
-    char   url[80];
-    char  *res           = NULL;
-    size_t bytes_alloced = 0;
-
+    char           url[80];
     http_request_t req = http_client_build_get_request((char *)"health", NULL, url, NULL, 0);
 
-    esp_http_client_handle_t client;
-    int                      content_length = 0;
-    bool                     success        = http_client_perform_with_retries(&req, 0, &client, &content_length);
-    if (success) {
-        esp_err_t http_err = http_client_read_response_to_buffer(&client, content_length, &res, &bytes_alloced);
-        if (http_err == ESP_OK && res && bytes_alloced > 0) {
-            // Don't care about response, just want to check network connection
-            log_printf(LOG_LEVEL_DEBUG, "http client API healthcheck successful");
-            free(res);
-            return true;
-        } else {
-            log_printf(LOG_LEVEL_DEBUG, "http client API healthcheck failed at http_client_read_response_to_buffer");
-        }
-    } else {
-        log_printf(LOG_LEVEL_DEBUG, "http client API healthcheck failed at http_client_perform_with_retries");
+    http_queue_req_t queue_req = {
+        .request = &req,
+        .sink    = HTTP_QUEUE_SINK_BUFFER,
+    };
+    bool success = http_queue_run(&queue_req, HTTP_QUEUE_PRIORITY_NORMAL);
+    if (success && queue_req.buffer.data && queue_req.buffer.size > 0) {
+        // Don't care about response, just want to check network connection
+        log_printf(LOG_LEVEL_DEBUG, "http client API healthcheck successful");
+        free(queue_req.buffer.data);
+        return true;
     }
 
+    log_printf(LOG_LEVEL_DEBUG, "http client API healthcheck failed");
+    if (queue_req.buffer.data) {
+        free(queue_req.buffer.data);
+    }
     return false;
 }
 
@@ -595,9 +909,21 @@ void http_client_get_failures(uint16_t *get_failures, uint16_t *post_failures) {
     *post_failures = failed_http_perform_posts;
 }
 
+/*
+ * Hits are requests sent over a connection kept open from an earlier one, misses had to connect first
+ */
+void http_client_get_pool_stats(uint32_t *hits, uint32_t *misses) {
+    *hits   = pool_hits;
+    *misses = pool_misses;
+}
+
 void http_client_init() {
-    request_lock = xSemaphoreCreateMutex();
-    MEMFAULT_ASSERT(request_lock);
+    pool_lock = xSemaphoreCreateMutex();
+    MEMFAULT_ASSERT(pool_lock);
+
+    memset(pool, 0, sizeof(pool));
+    pool_hits   = 0;
+    pool_misses = 0;
 
     failed_http_perform_reqs  = 0;
     failed_http_perform_posts = 0;
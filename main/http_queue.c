@@ -0,0 +1,250 @@
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "memfault/panics/assert.h"
+
+#include "constants.h"
+#include "http_client.h"
+#include "http_queue.h"
+#include "sleep_handler.h"
+
+// Must included below constants.h where we overwite the define of LOG_LOCAL_LEVEL
+#include "log.h"
+
+#define TAG SC_TAG_HTTP_QUEUE
+
+// Below the flash writer task, so flash ops for a download still start as soon as a sector is filled
+#define HTTP_QUEUE_TASK_PRIORITY (tskIDLE_PRIORITY)
+// Jobs run OTA (esp_https_ota and rendering its start text) and chunk callbacks decode streamed images, so this needs
+// at least the larger of the OTA and scheduler task stacks
+#define HTTP_QUEUE_TASK_STACK_SIZE (SPOT_CHECK_MINIMAL_STACK_SIZE_BYTES * 6)
+// Per priority. Callers await their own request, so there's rarely more than a couple waiting at once
+#define HTTP_QUEUE_DEPTH (4)
+
+static QueueHandle_t queues[HTTP_QUEUE_PRIORITY_COUNT];
+static TaskHandle_t  http_queue_task_handle = NULL;
+
+static const char *sink_strs[HTTP_QUEUE_SINK_COUNT] = {
+    [HTTP_QUEUE_SINK_BUFFER] = "buffer",
+    [HTTP_QUEUE_SINK_FLASH]  = "flash",
+    [HTTP_QUEUE_SINK_CB]     = "callback",
+    [HTTP_QUEUE_SINK_JOB]    = "job",
+};
+
+/*
+ * Send a request and read its response out into the sink it asked for. Must only be run on the queue task.
+ */
+static void http_queue_execute(http_queue_req_t *req) {
+    req->success        = false;
+    req->bytes_received = 0;
+
+    if (req->sink == HTTP_QUEUE_SINK_JOB) {
+        req->success = req->job.fn(req->job.arg);
+        return;
+    }
+
+    if (req->sink == HTTP_QUEUE_SINK_BUFFER) {
+        req->buffer.data = NULL;
+        req->buffer.size = 0;
+    }
+
+    esp_http_client_handle_t client;
+    int                      content_length = 0;
+    if (!http_client_perform_with_retries(req->request, req->additional_retries, &client, &content_length)) {
+        return;
+    }
+
+    // Client already cleaned up, nothing to read
+    if (req->request->req_type == HTTP_REQ_TYPE_GET && req->request->get_args.not_modified) {
+        req->success = true;
+        return;
+    }
+
+    esp_err_t err = ESP_FAIL;
+    switch (req->sink) {
+        case HTTP_QUEUE_SINK_BUFFER:
+            err = http_client_read_response_to_buffer(&client, content_length, &req->buffer.data, &req->buffer.size);
+            if (err != ESP_OK) {
+                // Already freed on failure
+                req->buffer.data = NULL;
+                req->buffer.size = 0;
+            }
+            req->bytes_received = req->buffer.size;
+            break;
+        case HTTP_QUEUE_SINK_FLASH:
+            err = http_client_read_response_to_flash(&client,
+                                                     content_length,
+                                                     req->flash.writer,
+                                                     &req->bytes_received,
+                                                     req->flash.chunk_cb,
+                                                     req->flash.chunk_cb_ctx);
+            break;
+        case HTTP_QUEUE_SINK_CB:
+            err = http_client_read_response_to_cb(&client,
+                                                  content_length,
+                                                  req->cb.chunk_cb,
+                                                  req->cb.chunk_cb_ctx,
+                                                  &req->bytes_received);
+            break;
+        default:
+            MEMFAULT_ASSERT(0);
+    }
+
+    req->success = err == ESP_OK;
+}
+
+/*
+ * Hand a finished request back. Nothing can be touched after the give, an awaiting caller may free req right away, and
+ * an async submitter may reuse it as soon as http_queue_is_pending sees the give. That's also why pending is left to
+ * the submitter's side to clear.
+ */
+static void http_queue_complete(http_queue_req_t *req) {
+    xSemaphoreGive(req->done);
+}
+
+/*
+ * Returns the next request to run, highest priority first, NULL if everything is empty.
+ */
+static http_queue_req_t *http_queue_next() {
+    http_queue_req_t *req = NULL;
+    for (int i = 0; i < HTTP_QUEUE_PRIORITY_COUNT; i++) {
+        if (xQueueReceive(queues[i], &req, 0) == pdTRUE) {
+            return req;
+        }
+    }
+
+    return NULL;
+}
+
+static void http_queue_task(void *args) {
+    (void)args;
+
+    while (1) {
+        // Woken once per submit, but drains everything queued each time so a missed wake can't strand a request
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        http_queue_req_t *req = NULL;
+        while ((req = http_queue_next()) != NULL) {
+            // Async requests (memfault uploads) have nobody waiting on them to keep the device awake
+            sleep_handler_set_busy(SYSTEM_IDLE_HTTP_QUEUE_BIT);
+
+            uint32_t start_ticks = xTaskGetTickCount();
+            http_queue_execute(req);
+            log_printf(LOG_LEVEL_DEBUG,
+                       "Finished %s request (%s) in %lu ms",
+                       sink_strs[req->sink],
+                       req->success ? "success" : "failure",
+                       (xTaskGetTickCount() - start_ticks) * portTICK_PERIOD_MS);
+
+            http_queue_complete(req);
+            sleep_handler_set_idle(SYSTEM_IDLE_HTTP_QUEUE_BIT);
+        }
+    }
+}
+
+/*
+ * Queue a request and return immediately. req must stay valid (not a stack variable of a function that returns) until
+ * it's complete, http_queue_await or http_queue_is_pending tell when that is. Returns false if it couldn't be queued,
+ * in which case it's not pending.
+ */
+bool http_queue_submit(http_queue_req_t *req, http_queue_priority_t priority) {
+    MEMFAULT_ASSERT(req);
+    MEMFAULT_ASSERT(priority < HTTP_QUEUE_PRIORITY_COUNT);
+    MEMFAULT_ASSERT(req->sink < HTTP_QUEUE_SINK_COUNT);
+    MEMFAULT_ASSERT(req->sink == HTTP_QUEUE_SINK_JOB ? req->job.fn != NULL : req->request != NULL);
+    MEMFAULT_ASSERT(req->sink != HTTP_QUEUE_SINK_FLASH || req->flash.writer != NULL);
+    MEMFAULT_ASSERT(req->sink != HTTP_QUEUE_SINK_CB || req->cb.chunk_cb != NULL);
+    MEMFAULT_ASSERT(!req->pending);
+
+    // The task only ever runs one request at a time, it would wait on itself forever
+    MEMFAULT_ASSERT(!http_queue_in_queue_task());
+
+    req->success        = false;
+    req->bytes_received = 0;
+    req->done           = xSemaphoreCreateBinaryStatic(&req->done_buf);
+    req->pending        = true;
+
+    if (xQueueSend(queues[priority], &req, 0) != pdTRUE) {
+        log_printf(LOG_LEVEL_ERROR,
+                   "Http queue for priority %d full, dropping %s request",
+                   priority,
+                   sink_strs[req->sink]);
+        req->pending = false;
+        return false;
+    }
+
+    xTaskNotifyGive(http_queue_task_handle);
+    return true;
+}
+
+/*
+ * Block until a submitted request is complete and return its success. Must be called at most once per successful
+ * submit. There's no timeout since the queue task still owns req until then, how long it takes is bounded by the http
+ * client timeouts of the requests ahead of it.
+ */
+bool http_queue_await(http_queue_req_t *req) {
+    MEMFAULT_ASSERT(req);
+    MEMFAULT_ASSERT(!http_queue_in_queue_task());
+
+    // The queue task is done with req only once it's been given
+    xSemaphoreTake(req->done, portMAX_DELAY);
+    req->pending = false;
+    return req->success;
+}
+
+/*
+ * Submit and await. If called from the queue task itself (from a job) the request runs right away instead, since it's
+ * already the only thing using the network.
+ */
+bool http_queue_run(http_queue_req_t *req, http_queue_priority_t priority) {
+    if (http_queue_in_queue_task()) {
+        http_queue_execute(req);
+        return req->success;
+    }
+
+    if (!http_queue_submit(req, priority)) {
+        return false;
+    }
+
+    return http_queue_await(req);
+}
+
+/*
+ * Non-blocking check whether a submitted request is still owned by the queue task, for requests nobody awaits. Once
+ * this returns false req can be reused or resubmitted. Must be called from the submitting side only, and not mixed with
+ * http_queue_await for the same submit.
+ */
+bool http_queue_is_pending(http_queue_req_t *req) {
+    if (req->pending && xSemaphoreTake(req->done, 0) == pdTRUE) {
+        req->pending = false;
+    }
+
+    return req->pending;
+}
+
+bool http_queue_in_queue_task() {
+    return http_queue_task_handle != NULL && xTaskGetCurrentTaskHandle() == http_queue_task_handle;
+}
+
+UBaseType_t http_queue_get_stack_high_water() {
+    return http_queue_task_handle == NULL ? 0 : uxTaskGetStackHighWaterMark(http_queue_task_handle);
+}
+
+void http_queue_init() {
+    for (int i = 0; i < HTTP_QUEUE_PRIORITY_COUNT; i++) {
+        queues[i] = xQueueCreate(HTTP_QUEUE_DEPTH, sizeof(http_queue_req_t *));
+        MEMFAULT_ASSERT(queues[i]);
+    }
+}
+
+void http_queue_start() {
+    BaseType_t rval = xTaskCreate(http_queue_task,
+                                  "http-queue",
+                                  HTTP_QUEUE_TASK_STACK_SIZE,
+                                  NULL,
+                                  HTTP_QUEUE_TASK_PRIORITY,
+                                  &http_queue_task_handle);
+    MEMFAULT_ASSERT(rval == pdPASS);
+}
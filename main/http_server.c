@@ -8,6 +8,7 @@
 #include "memfault/panics/assert.h"
 
 #include "constants.h"
+#include "cron.h"
 #include "http_client.h"
 #include "http_server.h"
 #include "json.h"
@@ -129,6 +130,19 @@ static void http_server_parse_json_string(cJSON *payload,
     }
 }
 
+/*
+ * Same as http_server_parse_json_string for a schedule expression, except an invalid expression also gets the fallback
+ */
+static void http_server_parse_json_schedule(cJSON *payload, char *json_key, char **field_to_set, char *fallback) {
+    http_server_parse_json_string(payload, json_key, field_to_set, MAX_LENGTH_SCHEDULE_PARAM, fallback);
+
+    cron_schedule_t schedule;
+    if (!cron_parse(*field_to_set, &schedule)) {
+        log_printf(LOG_LEVEL_WARN, "Received invalid schedule '%s', defaulting to '%s'", *field_to_set, fallback);
+        *field_to_set = fallback;
+    }
+}
+
 static esp_err_t health_get_handler(httpd_req_t *req) {
     httpd_resp_send(req, "Surviving not thriving", HTTPD_RESP_USE_STRLEN);
     return ESP_OK;
@@ -204,6 +218,25 @@ static esp_err_t configure_post_handler(httpd_req_t *req) {
                                           MAX_LENGTH_ACTIVE_CHART_PARAM,
                                           default_active_chart);
             MEMFAULT_ASSERT(nvs_chart_string_to_enum(temp_active_chart, &config.active_chart_2));
+
+            // Schedules are optional, anything left out keeps what's currently set
+            spot_check_config_t *current_config = nvs_get_config();
+            http_server_parse_json_schedule(payload,
+                                            "conditions_schedule",
+                                            &config.conditions_schedule,
+                                            current_config->conditions_schedule);
+            http_server_parse_json_schedule(payload,
+                                            "tide_chart_schedule",
+                                            &config.tide_chart_schedule,
+                                            current_config->tide_chart_schedule);
+            http_server_parse_json_schedule(payload,
+                                            "swell_chart_schedule",
+                                            &config.swell_chart_schedule,
+                                            current_config->swell_chart_schedule);
+            http_server_parse_json_schedule(payload,
+                                            "wind_chart_schedule",
+                                            &config.wind_chart_schedule,
+                                            current_config->wind_chart_schedule);
             break;
         }
         case SPOT_CHECK_MODE_CUSTOM: {
@@ -281,6 +314,11 @@ static esp_err_t current_config_get_handler(httpd_req_t *req) {
     nvs_chart_enum_to_string(current_config->active_chart_2, temp_chart_str);
     cJSON *active_chart_2 = cJSON_CreateString(temp_chart_str);
 
+    cJSON *conditions_schedule  = cJSON_CreateString(current_config->conditions_schedule);
+    cJSON *tide_chart_schedule  = cJSON_CreateString(current_config->tide_chart_schedule);
+    cJSON *swell_chart_schedule = cJSON_CreateString(current_config->swell_chart_schedule);
+    cJSON *wind_chart_schedule  = cJSON_CreateString(current_config->wind_chart_schedule);
+
     cJSON_AddItemToObject(root, "spot_name", spot_name_json);
     cJSON_AddItemToObject(root, "spot_lat", spot_lat_json);
     cJSON_AddItemToObject(root, "spot_lon", spot_lon_json);
@@ -292,6 +330,10 @@ static esp_err_t current_config_get_handler(httpd_req_t *req) {
     cJSON_AddItemToObject(root, "custom_update_interval_secs", custom_update_interval_secs);
     cJSON_AddItemToObject(root, "active_chart_1", active_chart_1);
     cJSON_AddItemToObject(root, "active_chart_2", active_chart_2);
+    cJSON_AddItemToObject(root, "conditions_schedule", conditions_schedule);
+    cJSON_AddItemToObject(root, "tide_chart_schedule", tide_chart_schedule);
+    cJSON_AddItemToObject(root, "swell_chart_schedule", swell_chart_schedule);
+    cJSON_AddItemToObject(root, "wind_chart_schedule", wind_chart_schedule);
 
     char *response_json = cJSON_Print(root);
     httpd_resp_send(req, response_json, HTTPD_RESP_USE_STRLEN);
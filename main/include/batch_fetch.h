@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "spot_check.h"
+
+/*
+ * The batch endpoint returns several resources in a single response, so a full refresh is one request instead of one
+ * per resource. Requested resources are listed in the 'resources' query param by their regular endpoint names. The body
+ * is a sequence of parts, each a batch_part_header_t followed by length bytes of the resource exactly as its own
+ * endpoint returns it. Like every other response it must have a Content-Length.
+ */
+typedef enum {
+    BATCH_RESOURCE_CONDITIONS  = 0,
+    BATCH_RESOURCE_TIDE_CHART  = 1,
+    BATCH_RESOURCE_SWELL_CHART = 2,
+    BATCH_RESOURCE_WIND_CHART  = 3,
+
+    BATCH_RESOURCE_COUNT,
+} batch_resource_t;
+
+#define BATCH_RESOURCE_BIT(resource) (1 << (resource))
+
+typedef struct __attribute__((packed)) {
+    uint8_t  resource;  // batch_resource_t
+    uint8_t  status;    // 0 if the server produced the resource, otherwise length is 0 and the resource is skipped
+    uint16_t reserved;
+    uint32_t length;  // little endian
+} batch_part_header_t;
+
+bool batch_fetch_download_and_save(uint32_t      resources,
+                                   conditions_t *new_conditions,
+                                   uint32_t     *saved,
+                                   uint32_t     *unchanged);
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "forecast.h"
+
+#define CHART_WIDTH_PX (700)
+#define CHART_HEIGHT_PX (200)
+// Hours shown, starting at the current one
+#define CHART_HOURS (24)
+// Fewer cached hours than this and the chart would be mostly empty, it's downloaded instead
+#define CHART_MIN_HOURS (12)
+
+typedef enum {
+    CHART_SERIES_TIDE,
+    CHART_SERIES_SWELL,
+    CHART_SERIES_WIND,
+
+    CHART_SERIES_COUNT,
+} chart_series_t;
+
+bool chart_can_draw(const forecast_t *forecast);
+void chart_draw(chart_series_t series, const forecast_t *forecast, time_t now_epoch_secs, uint32_t x, uint32_t y);
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Current conditions as drawn on screen. Filled from the JSON or binary conditions response, or from the forecast.
+ * Kept apart from spot_check.h so the decoders that fill it don't depend on the rest of the firmware.
+ */
+typedef struct conditions {
+    int8_t  temperature;
+    uint8_t wind_speed;
+    char    wind_dir[4];     // 3 characters for dir (SSW, etc) plus null
+    char    tide_height[7];  // minus sign, two digits, decimal point, two digits, null
+    bool    is_tide_rising;
+} conditions_t;
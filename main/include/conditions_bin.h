@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "conditions.h"
+
+/*
+ * Compact binary alternative to the JSON conditions response, asked for with the 'format=bin' query param. It's a
+ * single fixed layout conditions_bin_t instead of ~150 bytes of JSON, and decoding it is a copy and some range checks.
+ * Servers that don't know the param ignore it and send JSON, so responses are told apart by the magic (no JSON
+ * document starts with 'S') and either one is accepted from any server.
+ *
+ * Bytes after the struct are ignored so fields can be appended later without bumping the version. The version only
+ * changes if the existing layout does.
+ */
+#define CONDITIONS_BIN_QUERY_KEY "format"
+#define CONDITIONS_BIN_QUERY_VALUE "bin"
+#define CONDITIONS_BIN_MAGIC "SCCD"
+#define CONDITIONS_BIN_MAGIC_LEN (4)
+#define CONDITIONS_BIN_VERSION (1)
+
+#define CONDITIONS_BIN_FLAG_TIDE_RISING (1 << 0)
+
+typedef struct __attribute__((packed)) {
+    char    magic[CONDITIONS_BIN_MAGIC_LEN];
+    uint8_t version;
+    uint8_t flags;  // CONDITIONS_BIN_FLAG_*
+    int8_t  temperature;
+    uint8_t wind_speed;
+    char    wind_dir[3];     // Null padded, not terminated if all 3 are used
+    char    tide_height[6];  // Already formatted for display, null padded like wind_dir
+    uint8_t reserved;
+} conditions_bin_t;
+
+/*
+ * Accumulates a binary response fed in chunks. Doesn't depend on anything but conditions.h, so it's built and tested on
+ * the host too (test/host/test_conditions_bin.c).
+ */
+typedef struct {
+    uint8_t buf[sizeof(conditions_bin_t)];
+    size_t  len;
+} conditions_bin_decoder_t;
+
+bool conditions_bin_is_magic_start(uint8_t first_byte);
+void conditions_bin_decoder_init(conditions_bin_decoder_t *decoder);
+void conditions_bin_decoder_feed(conditions_bin_decoder_t *decoder, const uint8_t *data, size_t size);
+bool conditions_bin_decoder_finish(conditions_bin_decoder_t *decoder, conditions_t *conditions);
+bool conditions_bin_decode(const uint8_t *data, size_t size, conditions_t *conditions);
@@ -14,6 +14,7 @@
 #define MS_PER_SEC (1000)
 #define SECS_PER_MIN (60)
 #define MINS_PER_HOUR (60)
+#define HOURS_PER_DAY (24)
 
 typedef enum {
     SC_TAG_BQ24196 = 0x00,
@@ -42,6 +43,9 @@ typedef enum {
     SC_TAG_SPOT_CHECK,
     SC_TAG_MFLT_INTRFC,
     SC_TAG_MFLT_PORT,
+    SC_TAG_BATCH_FETCH,
+    SC_TAG_HTTP_QUEUE,
+    SC_TAG_CHART,
     SC_TAG_COUNT,
     // Canot go above 32 elements, used as a bitmask in log.c for faster lookup in blacklist
 } sc_tag_t;
@@ -73,6 +77,9 @@ static const char* const tag_strs[SC_TAG_COUNT] = {
     [SC_TAG_SPOT_CHECK]         = "[sc-spot-check]",
     [SC_TAG_MFLT_INTRFC]        = "[sc-mflt-intrfc]",
     [SC_TAG_MFLT_PORT]          = "[sc-mflt-port]",
+    [SC_TAG_BATCH_FETCH]        = "[sc-batch-fetch]",
+    [SC_TAG_HTTP_QUEUE]         = "[sc-http-queue]",
+    [SC_TAG_CHART]              = "[sc-chart]",
 };
 
 #endif
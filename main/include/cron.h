@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * Cron-like schedule of '<minute> <hour>' in local time, e.g. '5 *' for five past every hour or '0 3,12,17' for three
+ * times a day. Each field is '*', a value, a range 'a-b', or a list of those separated by commas, and any of them can
+ * take a step after a slash, like '0-30/10', or '/15' after a '*' for every 15th. A value with a step runs from it to
+ * the end of the field, like cron.
+ *
+ * Parsed once into bitmasks so finding the next matching minute is a couple of bit scans instead of walking the clock.
+ * Doesn't depend on anything but libc, so it can be built and tested on a host.
+ */
+#define CRON_MAX_EXPR_LEN (32)
+
+typedef struct {
+    uint64_t minutes;  // Bit n set to run at minute n
+    uint32_t hours;    // Bit n set to run during hour n
+} cron_schedule_t;
+
+bool   cron_parse(const char *expr, cron_schedule_t *schedule_out);
+bool   cron_is_never(const cron_schedule_t *schedule);
+time_t cron_next(const cron_schedule_t *schedule, time_t from_epoch_secs);
@@ -5,6 +5,12 @@
 
 #include "constants.h"
 
+// Gray values for the line/shape primitives, only the upper nibble is used
+#define DISPLAY_COLOR_BLACK (0x00)
+#define DISPLAY_COLOR_DARK_GRAY (0x55)
+#define DISPLAY_COLOR_LIGHT_GRAY (0xBB)
+#define DISPLAY_COLOR_WHITE (0xFF)
+
 typedef enum {
     DISPLAY_FONT_ALIGN_LEFT,
     DISPLAY_FONT_ALIGN_CENTER,
@@ -28,6 +34,7 @@ void display_render();
 void display_full_clear_cycles(uint8_t cycles);
 void display_full_clear();
 void display_clear_area(uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+void display_erase_area(uint32_t x, uint32_t y, uint32_t width, uint32_t height);
 void display_render_splash_screen(char *fw_version, char *hw_version);
 void display_draw_text(char                *text,
                        uint32_t             x_coord,
@@ -45,7 +52,24 @@ void display_draw_image(uint8_t *image_buffer,
                         uint8_t  bytes_per_px,
                         uint32_t screen_x,
                         uint32_t screen_y);
+void display_draw_image_chunk(const uint8_t *chunk,
+                              size_t         chunk_size,
+                              size_t         chunk_offset,
+                              size_t         width_px,
+                              size_t         height_px,
+                              uint32_t       screen_x,
+                              uint32_t       screen_y);
 void display_draw_rect(uint32_t x, uint32_t y, uint32_t width_px, uint32_t height_px);
+void display_draw_hline(uint32_t x, uint32_t y, uint32_t length_px, uint8_t color);
+void display_draw_vline(uint32_t x, uint32_t y, uint32_t length_px, uint8_t color);
+void display_draw_line(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, uint8_t color);
+void display_fill_triangle(uint32_t x0,
+                           uint32_t y0,
+                           uint32_t x1,
+                           uint32_t y1,
+                           uint32_t x2,
+                           uint32_t y2,
+                           uint8_t  color);
 void display_draw_image_fullscreen(uint8_t *image_buffer, uint8_t bytes_per_px);
 void display_get_text_bounds(char                *text,
                              uint32_t             x,
@@ -56,3 +80,5 @@ void display_get_text_bounds(char                *text,
                              uint32_t            *height);
 void display_mark_rect_dirty(uint32_t x_coord, uint32_t y_coord, uint32_t width, uint32_t height);
 void display_mark_all_lines_dirty();
+void display_mark_rect_fast(uint32_t x_coord, uint32_t y_coord, uint32_t width, uint32_t height);
+void display_get_glyph_cache_stats(uint32_t *hits, uint32_t *misses, uint32_t *bytes_used, uint32_t *capacity);
@@ -1,7 +1,50 @@
 #pragma once
 
+#include <stdbool.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
 #include "constants.h"
 #include "esp_http_client.h"
 #include "esp_partition.h"
 
+#define FLASH_PARTITION_SECTOR_SIZE (4096)
+
+/*
+ * Streams data into a partition, erasing each 4k sector just before it's written and coalescing writes into whole
+ * sectors. Sector erase/program happens in a worker task on one buffer while the caller fills the other, so whatever
+ * produces the data (network) overlaps with flash ops.
+ *
+ * Optionally a reference range (the currently stored copy of the same data) can be set. Sectors are compared against it
+ * and nothing is erased or written while they match, so rewriting identical data costs no erase cycles.
+ */
+typedef struct {
+    const esp_partition_t *partition;
+    uint32_t               start_offset;
+    size_t                 max_size;
+    size_t                 bytes_queued;
+    uint32_t               reference_offset;
+    size_t                 reference_size;
+    size_t                 skipped_bytes;
+    bool                   matches_reference;
+    uint8_t               *buffers[2];
+    uint8_t               *fill_buffer;
+    size_t                 fill_len;
+    QueueHandle_t          write_queue;
+    QueueHandle_t          free_queue;
+    SemaphoreHandle_t      done;
+    volatile esp_err_t     err;
+} flash_partition_writer_t;
+
 const esp_partition_t *flash_partition_get_screen_img_partition();
+esp_err_t              flash_partition_writer_start(flash_partition_writer_t *writer,
+                                                    const esp_partition_t    *partition,
+                                                    uint32_t                  offset_into_partition,
+                                                    size_t                    max_size);
+void      flash_partition_writer_set_reference(flash_partition_writer_t *writer,
+                                               uint32_t                  reference_offset,
+                                               size_t                    reference_size);
+esp_err_t flash_partition_writer_write(flash_partition_writer_t *writer, const uint8_t *data, size_t size);
+esp_err_t flash_partition_writer_finish(flash_partition_writer_t *writer, size_t *bytes_written, bool *unchanged);
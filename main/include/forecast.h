@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "conditions.h"
+
+/*
+ * Hourly forecast series from the forecast endpoint, a forecast_header_t followed by num_entries entries of
+ * entry_size bytes each, one per hour starting at start_epoch_secs. Entries may grow in later versions: fields are
+ * only ever appended and anything past what this firmware knows is skipped, so entry_size only has to be at least
+ * sizeof(forecast_entry_t). The version only changes if the existing layout does.
+ */
+#define FORECAST_MAGIC "SCFC"
+#define FORECAST_MAGIC_LEN (4)
+#define FORECAST_VERSION (1)
+#define FORECAST_INTERVAL_SECS (60 * 60)
+// Two days of hourly entries
+#define FORECAST_MAX_ENTRIES (48)
+
+typedef struct __attribute__((packed)) {
+    char     magic[FORECAST_MAGIC_LEN];
+    uint8_t  version;
+    uint8_t  num_entries;
+    uint8_t  entry_size;
+    uint8_t  reserved;
+    uint32_t start_epoch_secs;  // UTC, little endian
+} forecast_header_t;
+
+typedef struct __attribute__((packed)) {
+    int8_t   temperature;        // ºF
+    uint8_t  wind_speed;         // kt
+    uint16_t wind_dir_deg;       // Direction the wind is coming from, 0 is north
+    int16_t  tide_height_cft;    // Hundredths of a foot
+    uint16_t swell_height_dft;   // Tenths of a foot
+    uint8_t  swell_period_secs;  // 0 if unknown
+    uint8_t  reserved;
+} forecast_entry_t;
+
+/*
+ * Ring buffer of consecutive hourly entries, entries[head] covering the hour starting at head_epoch_secs. Expired hours
+ * drop off the front as time passes and newer series overwrite the hours they overlap, so the current hour is always
+ * at the head. Not locked, only ever touched from the scheduler task.
+ */
+typedef struct {
+    forecast_entry_t entries[FORECAST_MAX_ENTRIES];
+    uint8_t          head;
+    uint8_t          count;
+    time_t           head_epoch_secs;
+} forecast_t;
+
+/*
+ * Decodes a forecast response fed in chunks into its own series, which is only merged into the cached one once the
+ * whole response was valid. Like the rest of forecast.c it depends on nothing but conditions.h, so it's built and
+ * tested on the host too (test/host/test_forecast.c).
+ */
+typedef struct {
+    forecast_header_t header;
+    size_t            header_len;
+    uint8_t           entry_buf[sizeof(forecast_entry_t)];
+    size_t            entry_pos;  // Bytes of the current entry received, including skipped ones
+    uint8_t           entries_received;
+    bool              failed;
+    forecast_t        series;
+} forecast_decoder_t;
+
+void                    forecast_init(forecast_t *forecast);
+void                    forecast_drop_expired(forecast_t *forecast, time_t now_epoch_secs);
+void                    forecast_merge(forecast_t *forecast, const forecast_t *newer);
+const forecast_entry_t *forecast_get_entry(const forecast_t *forecast, uint8_t index, time_t *epoch_secs);
+const forecast_entry_t *forecast_find_entry(const forecast_t *forecast, time_t epoch_secs, uint8_t *index);
+uint8_t                 forecast_get_count(const forecast_t *forecast);
+bool forecast_get_conditions(const forecast_t *forecast, time_t epoch_secs, conditions_t *conditions);
+void forecast_decoder_init(forecast_decoder_t *decoder);
+void forecast_decoder_feed(forecast_decoder_t *decoder, const uint8_t *data, size_t size);
+bool forecast_decoder_finish(forecast_decoder_t *decoder, forecast_t *forecast);
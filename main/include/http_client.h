@@ -6,6 +6,7 @@
 #include "esp_err.h"
 #include "esp_http_client.h"
 #include "esp_partition.h"
+#include "flash_partition.h"
 #include "nvs.h"
 
 // Needs trailing slash!
@@ -24,9 +25,31 @@ typedef struct {
     char *value;
 } query_param;
 
+#define HTTP_CLIENT_ETAG_MAX_LEN (64)
+#define HTTP_CLIENT_LAST_MODIFIED_MAX_LEN (32)
+
+/*
+ * Cache validators from a response's ETag and Last-Modified headers. Empty strings if not present (or too long to
+ * store). url_hash identifies the full request url (with query params) they belong to, a validator for any other url
+ * is ignored.
+ */
+typedef struct {
+    char     etag[HTTP_CLIENT_ETAG_MAX_LEN];
+    char     last_modified[HTTP_CLIENT_LAST_MODIFIED_MAX_LEN];
+    uint32_t url_hash;
+} http_validator_t;
+
 typedef struct {
     query_param *params;
     uint8_t      num_params;
+    // Optional. If set and non-empty, the request is conditional and a 304 is treated as success with not_modified set
+    const http_validator_t *validator;
+    // Filled from the response headers by http_client_perform_with_retries. Caller persists them alongside the data
+    // once it's been saved successfully so they're never out of sync.
+    http_validator_t response_validator;
+    bool             not_modified;
+    // Endpoint the server might not have. A failure that got a response from the server doesn't kick into offline mode
+    bool optional;
 } http_get_args_t;
 
 typedef struct {
@@ -37,12 +60,19 @@ typedef struct {
 typedef struct {
     char           *url;
     http_req_type_t req_type;
+    int             status;  // status code of the last response, 0 if none was received
     union {
         http_get_args_t  get_args;
         http_post_args_t post_args;
     };
 } http_request_t;
 
+/*
+ * Called for every chunk of a response after it was queued for flash by http_client_read_response_to_flash. Offset is
+ * the position of the chunk in the response body.
+ */
+typedef void (*http_client_chunk_cb_t)(const uint8_t *chunk, size_t chunk_size, size_t offset, void *ctx);
+
 // Expose event handler so OTA task can callback to it
 esp_err_t      http_event_handler(esp_http_client_event_t *event);
 void           http_client_init();
@@ -63,11 +93,18 @@ esp_err_t      http_client_read_response_to_buffer(esp_http_client_handle_t *cli
                                                    size_t                   *response_data_size);
 esp_err_t      http_client_read_response_to_flash(esp_http_client_handle_t *client,
                                                   int                       content_length,
-                                                  esp_partition_t          *partition,
-                                                  uint32_t                  offset_into_partition,
-                                                  size_t                   *bytes_saved_size);
+                                                  flash_partition_writer_t *writer,
+                                                  size_t                   *bytes_saved_size,
+                                                  http_client_chunk_cb_t    chunk_cb,
+                                                  void                     *chunk_cb_ctx);
+esp_err_t      http_client_read_response_to_cb(esp_http_client_handle_t *client,
+                                               int                       content_length,
+                                               http_client_chunk_cb_t    chunk_cb,
+                                               void                     *chunk_cb_ctx,
+                                               size_t                   *bytes_received_size);
 bool           http_client_check_internet();
 
 // This is for debugging with cli, isn't necessary long term
 void http_client_get_failures(uint16_t *get_failures, uint16_t *post_failures);
+void http_client_get_pool_stats(uint32_t *hits, uint32_t *misses);
 #endif
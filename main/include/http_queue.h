@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "flash_partition.h"
+#include "http_client.h"
+
+/*
+ * Every network operation runs on a single http queue task, one at a time, highest priority first. Callers fill out a
+ * http_queue_req_t describing the request and where the response goes, then either submit it and await completion
+ * later or just run it (submit + await). Since nothing else opens connections there's no lock to fight over, and
+ * anything with its own http client (memfault uploads, esp_https_ota) is serialized with everything else by running it
+ * as a job.
+ *
+ * Priority only picks which queued request runs next, a running request is never interrupted.
+ */
+typedef enum {
+    HTTP_QUEUE_PRIORITY_HIGH,    // Data for the next render (conditions, charts, custom screen)
+    HTTP_QUEUE_PRIORITY_NORMAL,  // Healthchecks
+    HTTP_QUEUE_PRIORITY_LOW,     // Background work that can take a while (memfault uploads, OTA)
+
+    HTTP_QUEUE_PRIORITY_COUNT,
+} http_queue_priority_t;
+
+typedef enum {
+    HTTP_QUEUE_SINK_BUFFER,  // Response malloced into buffer.data, caller frees it if not NULL
+    HTTP_QUEUE_SINK_FLASH,   // Response written through an already started flash partition writer
+    HTTP_QUEUE_SINK_CB,      // Every chunk of the response handed to cb.chunk_cb
+    HTTP_QUEUE_SINK_JOB,     // No request, job.fn is run on the queue task and its return value is the result
+
+    HTTP_QUEUE_SINK_COUNT,
+} http_queue_sink_t;
+
+typedef bool (*http_queue_job_t)(void *arg);
+
+typedef struct {
+    http_request_t   *request;  // Not used by jobs. Status, validators and not_modified are filled in like a direct call
+    uint8_t           additional_retries;
+    http_queue_sink_t sink;
+    union {
+        struct {
+            char  *data;
+            size_t size;
+        } buffer;
+        struct {
+            flash_partition_writer_t *writer;
+            http_client_chunk_cb_t    chunk_cb;  // Optional
+            void                     *chunk_cb_ctx;
+        } flash;
+        struct {
+            http_client_chunk_cb_t chunk_cb;
+            void                  *chunk_cb_ctx;
+        } cb;
+        struct {
+            http_queue_job_t fn;
+            void            *arg;
+        } job;
+    };
+
+    // Results, valid once the request is complete. A conditional GET answered with a 304 is a success with nothing
+    // received, check request->get_args.not_modified.
+    bool   success;
+    size_t bytes_received;
+
+    // Internal. Pending is only written by the submitting side, the queue task signals completion through done.
+    bool              pending;
+    SemaphoreHandle_t done;
+    StaticSemaphore_t done_buf;
+} http_queue_req_t;
+
+void        http_queue_init();
+void        http_queue_start();
+bool        http_queue_submit(http_queue_req_t *req, http_queue_priority_t priority);
+bool        http_queue_await(http_queue_req_t *req);
+bool        http_queue_run(http_queue_req_t *req, http_queue_priority_t priority);
+bool        http_queue_is_pending(http_queue_req_t *req);
+bool        http_queue_in_queue_task();
+UBaseType_t http_queue_get_stack_high_water();
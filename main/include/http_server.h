@@ -15,6 +15,7 @@
 #define MAX_LENGTH_CUSTOM_SCREEN_URL_PARAM (256)
 #define MAX_LENGTH_CUSTOM_UPDATE_INTERVAL_SECS_PARAM (7)  // Allows at least up to 3 days plus a null term
 #define MAX_LENGTH_ACTIVE_CHART_PARAM (10)
+#define MAX_LENGTH_SCHEDULE_PARAM (32)  // CRON_MAX_EXPR_LEN
 
 void http_server_start();
 void http_server_stop();
@@ -1,8 +1,71 @@
 #ifndef JSON_H
 #define JSON_H
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
 #include "cJSON.h"
 
-cJSON* parse_json(char* server_response);
+// Deepest nesting a json_stream_t tracks. Anything deeper is an error.
+#define JSON_STREAM_MAX_DEPTH (8)
+// Keys and scalar values longer than these (including null terminator) are truncated
+#define JSON_STREAM_MAX_KEY_LEN (32)
+#define JSON_STREAM_MAX_VALUE_LEN (32)
+
+typedef enum {
+    JSON_VALUE_STRING,
+    JSON_VALUE_NUMBER,
+    JSON_VALUE_TRUE,
+    JSON_VALUE_FALSE,
+    JSON_VALUE_NULL,
+} json_value_type_t;
+
+typedef enum {
+    JSON_STREAM_STATE_VALUE,
+    JSON_STREAM_STATE_KEY,
+    JSON_STREAM_STATE_COLON,
+    JSON_STREAM_STATE_STRING,
+    JSON_STREAM_STATE_STRING_ESCAPE,
+    JSON_STREAM_STATE_STRING_UNICODE,
+    JSON_STREAM_STATE_LITERAL,
+    JSON_STREAM_STATE_AFTER_VALUE,
+    JSON_STREAM_STATE_DONE,
+    JSON_STREAM_STATE_ERROR,
+} json_stream_state_t;
+
+typedef struct json_stream json_stream_t;
+
+/*
+ * Called for every scalar value in the document. value is always null terminated text, numbers are left for the
+ * callback to convert. Use json_stream_get_key to find where in the document the value is.
+ */
+typedef void (*json_stream_value_cb_t)(json_stream_t *stream, json_value_type_t type, const char *value, void *ctx);
+
+/*
+ * Callback driven JSON tokenizer that's fed a document in arbitrarily split chunks as they arrive, so nothing the size
+ * of the response is ever buffered and there are no allocations. Only the key path to the current value and the
+ * current scalar are kept.
+ */
+struct json_stream {
+    json_stream_state_t    state;
+    uint8_t                depth;
+    uint8_t                unicode_remaining;
+    bool                   string_is_key;
+    bool                   container_empty;
+    uint16_t               is_array;  // bit per depth
+    char                   keys[JSON_STREAM_MAX_DEPTH + 1][JSON_STREAM_MAX_KEY_LEN];
+    char                   value[JSON_STREAM_MAX_VALUE_LEN];
+    size_t                 len;
+    json_stream_value_cb_t value_cb;
+    void                  *ctx;
+};
+
+cJSON      *parse_json(char *server_response);
+void        json_stream_init(json_stream_t *stream, json_stream_value_cb_t value_cb, void *ctx);
+bool        json_stream_feed(json_stream_t *stream, const char *data, size_t len);
+bool        json_stream_finish(json_stream_t *stream);
+uint8_t     json_stream_get_depth(const json_stream_t *stream);
+const char *json_stream_get_key(const json_stream_t *stream, uint8_t depth);
 
 #endif
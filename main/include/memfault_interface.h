@@ -3,3 +3,4 @@
 #include <stdbool.h>
 
 bool memfault_interface_post_data();
+void memfault_interface_post_data_async();
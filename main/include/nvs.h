@@ -22,6 +22,10 @@ typedef struct {
     uint32_t          custom_update_interval_secs;
     screen_img_t      active_chart_1;
     screen_img_t      active_chart_2;
+    char             *conditions_schedule;  // cron expressions, see cron.h
+    char             *tide_chart_schedule;
+    char             *swell_chart_schedule;
+    char             *wind_chart_schedule;
 } spot_check_config_t;
 
 void                 nvs_init();
@@ -32,6 +36,8 @@ bool                 nvs_get_int8(char *key, int8_t *val, int8_t fallback);
 bool                 nvs_set_int8(char *key, int8_t val);
 bool                 nvs_get_string(char *key, char *val, size_t *val_size, char *fallback);
 bool                 nvs_set_string(char *key, char *val);
+bool                 nvs_get_bytes(char *key, void *val, size_t *val_size);
+bool                 nvs_set_bytes(char *key, const void *val, size_t val_size);
 void                 nvs_save_config(spot_check_config_t *config);
 void                 nvs_print_config(log_level_t level);
 esp_err_t            nvs_full_erase();
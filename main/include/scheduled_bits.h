@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+/*
+ * Bits set from any number of tasks and taken all at once by whoever triggers on them. Setting is an atomic or and
+ * taking is one atomic exchange, so a bit set at any point either makes it into a take or stays set for the next one.
+ * Never lost in between, and never taken twice. Kept header only and free of FreeRTOS so it can be stress tested on
+ * the host.
+ */
+typedef _Atomic uint32_t scheduled_bits_t;
+
+static inline void scheduled_bits_set(scheduled_bits_t *scheduled, uint32_t bits) {
+    atomic_fetch_or(scheduled, bits);
+}
+
+static inline uint32_t scheduled_bits_take(scheduled_bits_t *scheduled) {
+    return atomic_exchange(scheduled, 0x0);
+}
+
+static inline void scheduled_bits_clear(scheduled_bits_t *scheduled) {
+    atomic_store(scheduled, 0x0);
+}
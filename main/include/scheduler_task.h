@@ -3,6 +3,12 @@
 
 #include <stdint.h>
 
+// Default schedules (see cron.h) for the discrete updates that can be changed in the config
+#define SCHEDULER_DEFAULT_CONDITIONS_SCHEDULE "5 *"
+#define SCHEDULER_DEFAULT_TIDE_CHART_SCHEDULE "0 3"
+#define SCHEDULER_DEFAULT_SWELL_CHART_SCHEDULE "0 3,12,17"
+#define SCHEDULER_DEFAULT_WIND_CHART_SCHEDULE "5 *"
+
 typedef enum {
     SCHEDULER_MODE_INIT,
     SCHEDULER_MODE_OFFLINE,
@@ -20,6 +26,8 @@ void             scheduler_schedule_tide_chart_update();
 void             scheduler_schedule_swell_chart_update();
 void             scheduler_schedule_wind_chart_update();
 void             scheduler_schedule_both_charts_update();
+void             scheduler_schedule_forecast_update();
+void             scheduler_schedule_chart_marker_update();
 void             scheduler_schedule_ota_check();
 void             scheduler_schedule_mflt_upload();
 void             scheduler_schedule_screen_dirty();
@@ -30,8 +38,11 @@ void             scheduler_set_idle(uint32_t system_idle_bitmask);
 void             scheduler_set_offline_mode();
 void             scheduler_set_ota_mode();
 void             scheduler_set_online_mode();
+void             scheduler_reschedule();
+void             scheduler_update_schedules();
 scheduler_mode_t scheduler_get_mode();
 UBaseType_t      scheduler_task_get_stack_high_water();
+UBaseType_t      scheduler_render_task_get_stack_high_water();
 void             scheduler_task_init();
 void             scheduler_task_start();
 
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Screen images are either raw 2-pixels-per-byte data (legacy, no header), or start with a screen_img_header_t
+ * followed by the image data in the encoding from the header. Decoded data is always 2-pixels-per-byte with rows of
+ * uneven width padded by a nibble, same as the raw format.
+ */
+#define SCREEN_IMG_HEADER_MAGIC "SCIM"
+#define SCREEN_IMG_HEADER_MAGIC_LEN (4)
+
+typedef enum {
+    SCREEN_IMG_ENCODING_RAW = 0,
+    // Control byte N < 0x80 is followed by N+1 literal bytes, N >= 0x80 by a single byte repeated (N & 0x7F)+1 times
+    SCREEN_IMG_ENCODING_RLE = 1,
+    // zlib stream, decoded with the ROM tinfl
+    SCREEN_IMG_ENCODING_ZLIB = 2,
+
+    SCREEN_IMG_ENCODING_COUNT,
+} screen_img_encoding_t;
+
+typedef struct __attribute__((packed)) {
+    char     magic[SCREEN_IMG_HEADER_MAGIC_LEN];
+    uint16_t width_px;  // little endian
+    uint16_t height_px;
+    uint8_t  encoding;  // screen_img_encoding_t
+    uint8_t  reserved[3];
+} screen_img_header_t;
+
+typedef struct screen_img_decoder screen_img_decoder_t;
+
+/*
+ * Receives decoded image data. Offset is the position of the data in the decoded image.
+ */
+typedef void (*screen_img_decoder_output_cb_t)(screen_img_decoder_t *decoder,
+                                               const uint8_t        *data,
+                                               size_t                size,
+                                               size_t                offset);
+
+struct screen_img_decoder {
+    // Image dimensions. Set by caller for headerless raw images, overwritten from the header if there is one
+    uint32_t                       width_px;
+    uint32_t                       height_px;
+    screen_img_encoding_t          encoding;
+    bool                           has_header;
+    screen_img_decoder_output_cb_t output_cb;
+    void                          *ctx;
+
+    // Internal state
+    uint8_t  header_buf[sizeof(screen_img_header_t)];
+    size_t   header_len;
+    size_t   bytes_out;
+    bool     failed;
+    bool     done;
+    uint8_t  rle_literal_remaining;
+    uint8_t  rle_run_length;
+    uint8_t *out_buf;
+    void    *inflator;
+    size_t   out_pos;
+};
+
+bool screen_img_decoder_parse_header(const uint8_t *data, size_t size, screen_img_header_t *header);
+bool screen_img_decoder_init(screen_img_decoder_t          *decoder,
+                             uint32_t                       default_width_px,
+                             uint32_t                       default_height_px,
+                             screen_img_decoder_output_cb_t output_cb,
+                             void                          *ctx);
+bool screen_img_decoder_feed(screen_img_decoder_t *decoder, const uint8_t *data, size_t size);
+bool screen_img_decoder_finish(screen_img_decoder_t *decoder);
+void screen_img_decoder_deinit(screen_img_decoder_t *decoder);
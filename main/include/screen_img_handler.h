@@ -1,9 +1,20 @@
 #pragma once
 
-// Keys in NVS for the current number of bytes saved in the screen_img partition as a single image.
-// Saving the key separately in the NVS KVS avoids having to use a packed header prefix in the image data partition for
-// metadata
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "flash_partition.h"
+#include "forecast.h"
+
+// Key in NVS for the commit record of each image: which A/B slot in the screen_img partition holds the current image,
+// and its size/dimensions. Written as a single blob so switching to a newly downloaded image is atomic.
 // NOTE : max key length is 15 bytes (null term does not count for a byte)
+#define SCREEN_IMG_TIDE_CHART_RECORD_NVS_KEY "tide_img_rec"
+#define SCREEN_IMG_SWELL_CHART_RECORD_NVS_KEY "swell_img_rec"
+#define SCREEN_IMG_WIND_CHART_RECORD_NVS_KEY "wind_img_rec"
+#define SCREEN_IMG_CUSTOM_SCREEN_RECORD_NVS_KEY "cstm_img_rec"
+
+// Legacy per-value keys from before A/B slots, only read to pick up an image saved by older firmware (always slot A)
 #define SCREEN_IMG_TIDE_CHART_SIZE_NVS_KEY "tide_img_sz"
 #define SCREEN_IMG_TIDE_CHART_WIDTH_PX_NVS_KEY "tide_img_w"
 #define SCREEN_IMG_TIDE_CHART_HEIGHT_PX_NVS_KEY "tide_img_h"
@@ -18,9 +29,10 @@
 #define SCREEN_IMG_CUSTOM_SCREEN_HEIGHT_PX_NVS_KEY "cstm_img_h"
 
 /*
- * Start byte of each image saved inthe screen_img partition. Screen partition as of now is 512kb large. If each chart
- * is 700x200 px with 2-pixels-ber-byte, each takes up 70kb (0x11170). But when erasing with page boundaries, fw will
- * erase up to 0x12000. Could be dynamically calced but this is simpler for now.
+ * Start byte of each image's two slots in the screen_img partition. Screen partition as of now is 512kb large. If each
+ * chart is 700x200 px with 2-pixels-ber-byte, each takes up 70kb (0x11170). But when erasing with page boundaries, fw
+ * will erase up to 0x12000. New downloads are written to the slot not currently in use, so a failed download never
+ * touches the image being displayed. Slot A offsets are the same as the single slot used by older firmware.
  *
  * NOTE: These MUST by 4k aligned for proper erasing
  *
@@ -28,12 +40,19 @@
  * there instead of in its own individual place in the partition. This isn't scalable, but passes for now until more
  * charts might be added.
  */
+#define SCREEN_IMG_CHART_SLOT_SIZE 0x12000
 #define SCREEN_IMG_TIDE_CHART_OFFSET 0x0
 #define SCREEN_IMG_SWELL_CHART_OFFSET 0x12000
 #define SCREEN_IMG_WIND_CHART_OFFSET 0x24000
+#define SCREEN_IMG_TIDE_CHART_SLOT_B_OFFSET 0x36000
+#define SCREEN_IMG_SWELL_CHART_SLOT_B_OFFSET 0x48000
+#define SCREEN_IMG_WIND_CHART_SLOT_B_OFFSET 0x5A000
 
-// Allow the fullscreen custom screen image to occupy the same space as they'll never be used together
+// Allow the fullscreen custom screen image to occupy the same space as they'll never be used together. 800x600 px is
+// 0x3A980 bytes, rounded up to the next sector.
+#define SCREEN_IMG_CUSTOM_SCREEN_SLOT_SIZE 0x3B000
 #define SCREEN_IMG_CUSTOM_SCREEN_OFFSET 0x0
+#define SCREEN_IMG_CUSTOM_SCREEN_SLOT_B_OFFSET 0x3B000
 
 // Name of the NVS partition that the screen data bytes are saved. Generic since it holds multiple images
 #define SCREEN_IMG_PARTITION_LABEL "screen_img"
@@ -47,10 +66,25 @@ typedef enum {
     SCREEN_IMG_COUNT,
 } screen_img_t;
 
+// In-progress save of an image received as part of a larger response, see screen_img_handler_save_start
+typedef struct {
+    screen_img_t             screen_img;
+    flash_partition_writer_t writer;
+    bool                     started;
+    bool                     failed;
+} screen_img_save_ctx_t;
+
 void screen_img_handler_init();
-bool screen_img_handler_download_and_save(screen_img_t screen_img);
+bool screen_img_handler_download_and_save(screen_img_t screen_img, bool *unchanged);
+bool screen_img_handler_download_and_draw_chart(screen_img_t screen_img, bool clear_area, bool *unchanged);
+bool screen_img_handler_download_and_draw_screen_img(screen_img_t screen_img, bool clear_area, bool *unchanged);
+bool screen_img_handler_save_start(screen_img_t screen_img, screen_img_save_ctx_t *ctx);
+bool screen_img_handler_save_write(screen_img_save_ctx_t *ctx, const uint8_t *data, size_t size);
+bool screen_img_handler_save_finish(screen_img_save_ctx_t *ctx, bool complete, bool *unchanged);
 
 bool screen_img_handler_clear_screen_img(screen_img_t screen_img);
 bool screen_img_handler_clear_chart(screen_img_t screen_img);
 bool screen_img_handler_draw_screen_img(screen_img_t screen_img);
 bool screen_img_handler_draw_chart(screen_img_t screen_img);
+bool screen_img_handler_draw_forecast_chart(screen_img_t screen_img, const forecast_t *forecast, bool clear_area);
+bool screen_img_handler_redraw_forecast_chart(screen_img_t screen_img, const forecast_t *forecast);
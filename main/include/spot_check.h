@@ -1,8 +1,14 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+#include "conditions.h"
+#include "conditions_bin.h"
+#include "forecast.h"
+#include "json.h"
+
 typedef enum {
     SPOT_CHECK_MODE_WEATHER,
     SPOT_CHECK_MODE_CUSTOM,
@@ -10,13 +16,23 @@ typedef enum {
     SPOT_CHECK_MODE_COUNT,
 } spot_check_mode_t;
 
+typedef enum {
+    SPOT_CHECK_CONDITIONS_FORMAT_UNKNOWN,  // Nothing received yet
+    SPOT_CHECK_CONDITIONS_FORMAT_JSON,
+    SPOT_CHECK_CONDITIONS_FORMAT_BIN,
+} spot_check_conditions_format_t;
+
 typedef struct {
-    int8_t  temperature;
-    uint8_t wind_speed;
-    char    wind_dir[4];     // 3 characters for dir (SSW, etc) plus null
-    char    tide_height[7];  // minus sign, two digits, decimal point, two digits, null
-    bool    is_tide_rising;
-} conditions_t;
+    spot_check_conditions_format_t format;
+    union {
+        struct {
+            json_stream_t stream;
+            conditions_t  conditions;
+            uint8_t       fields_found;
+        } json;
+        conditions_bin_decoder_t bin;
+    };
+} spot_check_conditions_parser_t;
 
 /*
  * System functions
@@ -24,7 +40,13 @@ typedef struct {
 char             *spot_check_get_serial();
 char             *spot_check_get_fw_version();
 char             *spot_check_get_hw_version();
-bool              spot_check_download_and_save_conditions(conditions_t *new_conditions);
+void              spot_check_conditions_parser_init(spot_check_conditions_parser_t *parser);
+bool              spot_check_conditions_parser_feed(spot_check_conditions_parser_t *parser, const char *data, size_t len);
+bool              spot_check_conditions_parser_finish(spot_check_conditions_parser_t *parser, conditions_t *conditions);
+bool              spot_check_download_and_save_conditions(conditions_t *new_conditions, bool *unchanged);
+bool              spot_check_download_and_save_forecast(bool *unchanged);
+bool              spot_check_get_forecast_conditions(conditions_t *conditions);
+const forecast_t *spot_check_get_forecast();
 void              spot_check_set_mode(spot_check_mode_t new_mode);
 spot_check_mode_t spot_check_string_to_mode(char *in_str);
 const char       *spot_check_mode_to_string(spot_check_mode_t mode);
@@ -1,5 +1,9 @@
 #include "constants.h"
 
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include "cJSON.h"
 #include "freertos/FreeRTOS.h"
 
@@ -22,3 +26,272 @@ cJSON *parse_json(char *server_response) {
 
     return json;
 }
+
+static bool json_stream_is_whitespace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static bool json_stream_in_array(const json_stream_t *stream) {
+    return stream->depth > 0 && (stream->is_array & (1 << stream->depth));
+}
+
+/*
+ * Add a character to the key or value currently being read, silently truncating anything that doesn't fit
+ */
+static void json_stream_append(json_stream_t *stream, char c) {
+    char  *buf  = stream->string_is_key ? stream->keys[stream->depth] : stream->value;
+    size_t size = stream->string_is_key ? JSON_STREAM_MAX_KEY_LEN : JSON_STREAM_MAX_VALUE_LEN;
+    if (stream->len < size - 1) {
+        buf[stream->len++] = c;
+        buf[stream->len]   = '\0';
+    }
+}
+
+static void json_stream_end_value(json_stream_t *stream) {
+    stream->state = stream->depth == 0 ? JSON_STREAM_STATE_DONE : JSON_STREAM_STATE_AFTER_VALUE;
+}
+
+static void json_stream_emit(json_stream_t *stream, json_value_type_t type) {
+    if (stream->value_cb) {
+        stream->value_cb(stream, type, stream->value, stream->ctx);
+    }
+    json_stream_end_value(stream);
+}
+
+static bool json_stream_push(json_stream_t *stream, bool array) {
+    if (stream->depth >= JSON_STREAM_MAX_DEPTH) {
+        log_printf(LOG_LEVEL_INFO, "JSON nested deeper than max of %u", JSON_STREAM_MAX_DEPTH);
+        return false;
+    }
+
+    stream->depth++;
+    if (array) {
+        stream->is_array |= (1 << stream->depth);
+    } else {
+        stream->is_array &= ~(1 << stream->depth);
+    }
+    stream->keys[stream->depth][0] = '\0';
+    stream->container_empty        = true;
+    stream->state                  = array ? JSON_STREAM_STATE_VALUE : JSON_STREAM_STATE_KEY;
+    return true;
+}
+
+static bool json_stream_pop(json_stream_t *stream, bool array) {
+    if (stream->depth == 0 || json_stream_in_array(stream) != array) {
+        return false;
+    }
+
+    stream->depth--;
+    json_stream_end_value(stream);
+    return true;
+}
+
+static bool json_stream_finish_literal(json_stream_t *stream) {
+    if (strcmp(stream->value, "true") == 0) {
+        json_stream_emit(stream, JSON_VALUE_TRUE);
+    } else if (strcmp(stream->value, "false") == 0) {
+        json_stream_emit(stream, JSON_VALUE_FALSE);
+    } else if (strcmp(stream->value, "null") == 0) {
+        json_stream_emit(stream, JSON_VALUE_NULL);
+    } else {
+        char *end = NULL;
+        strtod(stream->value, &end);
+        if (end == stream->value || *end != '\0') {
+            return false;
+        }
+        json_stream_emit(stream, JSON_VALUE_NUMBER);
+    }
+
+    return true;
+}
+
+/*
+ * Advance the tokenizer by one character. Returns false if the character isn't valid where it is.
+ */
+static bool json_stream_step(json_stream_t *stream, char c) {
+    switch (stream->state) {
+        case JSON_STREAM_STATE_VALUE:
+            if (json_stream_is_whitespace(c)) {
+                return true;
+            } else if (c == ']' && stream->container_empty && json_stream_in_array(stream)) {
+                return json_stream_pop(stream, true);
+            }
+
+            stream->container_empty = false;
+            stream->string_is_key   = false;
+            stream->len             = 0;
+            stream->value[0]        = '\0';
+            if (c == '{' || c == '[') {
+                return json_stream_push(stream, c == '[');
+            } else if (c == '"') {
+                stream->state = JSON_STREAM_STATE_STRING;
+                return true;
+            } else if (c == '-' || isdigit((unsigned char)c) || c == 't' || c == 'f' || c == 'n') {
+                json_stream_append(stream, c);
+                stream->state = JSON_STREAM_STATE_LITERAL;
+                return true;
+            }
+            return false;
+        case JSON_STREAM_STATE_KEY:
+            if (json_stream_is_whitespace(c)) {
+                return true;
+            } else if (c == '}' && stream->container_empty) {
+                return json_stream_pop(stream, false);
+            } else if (c == '"') {
+                stream->container_empty        = false;
+                stream->string_is_key          = true;
+                stream->len                    = 0;
+                stream->keys[stream->depth][0] = '\0';
+                stream->state                  = JSON_STREAM_STATE_STRING;
+                return true;
+            }
+            return false;
+        case JSON_STREAM_STATE_COLON:
+            if (json_stream_is_whitespace(c)) {
+                return true;
+            } else if (c == ':') {
+                stream->state = JSON_STREAM_STATE_VALUE;
+                return true;
+            }
+            return false;
+        case JSON_STREAM_STATE_STRING:
+            if (c == '\\') {
+                stream->state = JSON_STREAM_STATE_STRING_ESCAPE;
+            } else if (c == '"' && stream->string_is_key) {
+                stream->state = JSON_STREAM_STATE_COLON;
+            } else if (c == '"') {
+                json_stream_emit(stream, JSON_VALUE_STRING);
+            } else {
+                json_stream_append(stream, c);
+            }
+            return true;
+        case JSON_STREAM_STATE_STRING_ESCAPE:
+            switch (c) {
+                case 'b':
+                    c = '\b';
+                    break;
+                case 'f':
+                    c = '\f';
+                    break;
+                case 'n':
+                    c = '\n';
+                    break;
+                case 'r':
+                    c = '\r';
+                    break;
+                case 't':
+                    c = '\t';
+                    break;
+                case 'u':
+                    // Nothing we display is outside ascii, just mark where it was
+                    stream->unicode_remaining = 4;
+                    stream->state             = JSON_STREAM_STATE_STRING_UNICODE;
+                    json_stream_append(stream, '?');
+                    return true;
+                case '"':
+                case '\\':
+                case '/':
+                    break;
+                default:
+                    return false;
+            }
+            json_stream_append(stream, c);
+            stream->state = JSON_STREAM_STATE_STRING;
+            return true;
+        case JSON_STREAM_STATE_STRING_UNICODE:
+            if (!isxdigit((unsigned char)c)) {
+                return false;
+            }
+            if (--stream->unicode_remaining == 0) {
+                stream->state = JSON_STREAM_STATE_STRING;
+            }
+            return true;
+        case JSON_STREAM_STATE_LITERAL:
+            if (isalnum((unsigned char)c) || c == '.' || c == '+' || c == '-') {
+                json_stream_append(stream, c);
+                return true;
+            }
+
+            // Literals have no terminator, the character after one belongs to whatever comes next
+            return json_stream_finish_literal(stream) && json_stream_step(stream, c);
+        case JSON_STREAM_STATE_AFTER_VALUE:
+            if (json_stream_is_whitespace(c)) {
+                return true;
+            } else if (c == ',') {
+                stream->state = json_stream_in_array(stream) ? JSON_STREAM_STATE_VALUE : JSON_STREAM_STATE_KEY;
+                return true;
+            } else if (c == '}' || c == ']') {
+                return json_stream_pop(stream, c == ']');
+            }
+            return false;
+        case JSON_STREAM_STATE_DONE:
+            return json_stream_is_whitespace(c);
+        case JSON_STREAM_STATE_ERROR:
+        default:
+            return false;
+    }
+}
+
+void json_stream_init(json_stream_t *stream, json_stream_value_cb_t value_cb, void *ctx) {
+    memset(stream, 0, sizeof(json_stream_t));
+    stream->state    = JSON_STREAM_STATE_VALUE;
+    stream->value_cb = value_cb;
+    stream->ctx      = ctx;
+}
+
+/*
+ * Tokenize the next chunk of a document, calling value_cb for every complete scalar in it. Chunks can be split
+ * anywhere. Returns false once the document is known to be invalid, anything fed after that is ignored.
+ */
+bool json_stream_feed(json_stream_t *stream, const char *data, size_t len) {
+    if (stream->state == JSON_STREAM_STATE_ERROR) {
+        return false;
+    }
+
+    for (size_t i = 0; i < len; i++) {
+        if (!json_stream_step(stream, data[i])) {
+            log_printf(LOG_LEVEL_INFO,
+                       "JSON parsing err: unexpected '%c' at depth %u, key '%s'",
+                       data[i],
+                       stream->depth,
+                       json_stream_get_key(stream, stream->depth));
+            stream->state = JSON_STREAM_STATE_ERROR;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Call after the last chunk. Returns true if it was a complete, valid document.
+ */
+bool json_stream_finish(json_stream_t *stream) {
+    // A bare number at the top level only ends with the document
+    if (stream->state == JSON_STREAM_STATE_LITERAL && stream->depth == 0 && !json_stream_finish_literal(stream)) {
+        stream->state = JSON_STREAM_STATE_ERROR;
+    }
+
+    return stream->state == JSON_STREAM_STATE_DONE;
+}
+
+/*
+ * Depth of the value last passed to value_cb. 0 for a bare top-level value, 1 for a member of the top-level object or
+ * array, and so on.
+ */
+uint8_t json_stream_get_depth(const json_stream_t *stream) {
+    return stream->depth;
+}
+
+/*
+ * Key of the member at depth the value last passed to value_cb is under, so json_stream_get_key(stream, depth) is its
+ * own key and json_stream_get_key(stream, depth - 1) the key of the object containing it. Empty string for array
+ * elements and depths outside the current path.
+ */
+const char *json_stream_get_key(const json_stream_t *stream, uint8_t depth) {
+    if (depth == 0 || depth > stream->depth || (stream->is_array & (1 << depth))) {
+        return "";
+    }
+
+    return stream->keys[depth];
+}
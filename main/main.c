@@ -24,6 +24,7 @@
 #include "display.h"
 #include "gpio.h"
 #include "http_client.h"
+#include "http_queue.h"
 #include "http_server.h"
 #include "i2c.h"
 #include "json.h"
@@ -51,31 +52,6 @@
 static uart_handle_t cli_uart_handle;
 static i2c_handle_t  bq24196_i2c_handle;
 
-/*
- * Trigger mflt then wait 2 seconds to make sure scheduler begins executing mflt upload. Then trigger ota check so it
- * has to wait until scheduler loops back around to process the new event bit, otherwise the un-locked ota http reqs
- * will break the mflt one. This is a temporary hack until the http req system is refactored.
- */
-static void special_case_boot_delayed_callback() {
-    if (scheduler_get_mode() == SCHEDULER_MODE_INIT) {
-        // We're in provisioning mode, don't bother with these calls
-        log_printf(LOG_LEVEL_DEBUG, "Skipping special case boot delay callback since device not connected");
-        return;
-    }
-
-    log_printf(LOG_LEVEL_DEBUG, "Starting special case boot delay callback");
-
-    // Reset memfault back to full uploads for the rest of runtime
-    memfault_packetizer_set_active_sources(kMfltDataSourceMask_All);
-
-    scheduler_schedule_mflt_upload();
-    scheduler_trigger();
-    vTaskDelay(pdMS_TO_TICKS(2000));
-    scheduler_schedule_ota_check();
-    scheduler_trigger();
-    log_printf(LOG_LEVEL_DEBUG, "Exiting special case boot delay callback");
-}
-
 static void app_init() {
     // ESP_ERROR_CHECK(esp_task_wdt_init());
 
@@ -112,6 +88,7 @@ static void app_init() {
     mdns_local_init();
     wifi_init();
     http_client_init();
+    http_queue_init();
 
     scheduler_task_init();
     cli_task_init(&cli_uart_handle);
@@ -125,6 +102,7 @@ static void app_start() {
     display_start();
     sleep_handler_start();
     sntp_time_start();
+    http_queue_start();
     scheduler_task_start();
 
     cli_task_start();
@@ -262,47 +240,20 @@ void app_main(void) {
         spot_check_clear_checking_connection_screen();
         scheduler_set_online_mode();
 
+        // Boot upload is done, go back to full uploads (including any coredump) for the rest of runtime. The full upload
+        // and the first OTA check go straight into the http queue behind the initial conditions and chart requests.
+        memfault_packetizer_set_active_sources(kMfltDataSourceMask_All);
+        scheduler_schedule_mflt_upload();
+        scheduler_schedule_ota_check();
+        scheduler_trigger();
+
         log_printf(LOG_LEVEL_INFO, "Boot successful, kicking scheduler taks into online mode");
     } while (0);
 
-    // Delay a minute before we run the on-boot delayed actions. This is because both mflt's http client and the
-    // esp ota version header check for the server image use their own internal http_client, so we can't force them to
-    // obey our http_client module request lock. For a normal boot, waiting a minute or two ensures no further network
-    // connections will be running. There's still the risk of edge cases for a late internet connection or provisioning
-    // that would force http errors from reqs stommping each other, so this is just a dirtyish fix for now.
-    uint8_t       initial_boot_delay_min = 1;
-    TimerHandle_t initial_boot_delay_timer =
-        xTimerCreate("initial-boot-delay-timer",
-                     pdMS_TO_TICKS(initial_boot_delay_min * SECS_PER_MIN * MS_PER_SEC),
-                     pdFALSE,
-                     NULL,
-                     special_case_boot_delayed_callback);
-    if (initial_boot_delay_timer == NULL) {
-        log_printf(LOG_LEVEL_ERROR,
-                   "Initial boot delay timer kickoff could not be created!! MFLT and OTA will eventually upload / "
-                   "check when scheduler "
-                   "in online mode, but this is a very bad sign about the memory levels!");
-    } else {
-        BaseType_t timer_success = xTimerStart(initial_boot_delay_timer, 0);
-        if (timer_success) {
-            log_printf(LOG_LEVEL_INFO,
-                       "Started timer to run initial boot delayed actions after %u minutes (%ums)",
-                       initial_boot_delay_min,
-                       initial_boot_delay_min * SECS_PER_MIN * MS_PER_SEC);
-        } else {
-            log_printf(
-                LOG_LEVEL_ERROR,
-                "Failed to start initial boot delay timer! MFLT & OTA will eventually start checking when scheduler "
-                "in online mode, but this is a very bad sign about the memory levels",
-                initial_boot_delay_min,
-                initial_boot_delay_min * SECS_PER_MIN * MS_PER_SEC);
-        }
-    }
-
     // Wait for all running 'processes' to finish (downloading and image, saving things to flash, running a display
     // update, etc) before entering deep sleep
     sleep_handler_block_until_system_idle();
 
-    // yeet the default task, everything runs from scheduler task, ota task, and timers
+    // yeet the default task, everything runs from scheduler task, http queue task, ota task, and timers
     vTaskDelete(NULL);
 }
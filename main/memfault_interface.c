@@ -4,6 +4,7 @@
 #include "memfault/http/http_client.h"
 
 #include "cli_task.h"
+#include "http_queue.h"
 #include "log.h"
 #include "ota_task.h"
 #include "scheduler_task.h"
@@ -12,10 +13,15 @@
 
 #define UPLOAD_TIMEOUT_MS (30 * MS_PER_SEC)
 
+// Only one background upload in flight, the packetizer would just hand a second one the same data
+static http_queue_req_t async_upload_req;
+
 /*
- * Returns success
+ * Runs on the http queue task so the memfault http client never has a connection open at the same time as ours.
+ * Returns success.
  */
-bool memfault_interface_post_data() {
+static bool memfault_interface_upload(void *arg) {
+    (void)arg;
     log_printf(LOG_LEVEL_INFO, "Executing memfault upload function");
 
     sMfltHttpClient *http_client = memfault_http_client_create();
@@ -55,17 +61,46 @@ bool memfault_interface_post_data() {
     return success;
 }
 
+/*
+ * Upload everything the packetizer has, blocking until done. Returns success
+ */
+bool memfault_interface_post_data() {
+    http_queue_req_t req = {
+        .sink = HTTP_QUEUE_SINK_JOB,
+        .job  = {.fn = memfault_interface_upload},
+    };
+    return http_queue_run(&req, HTTP_QUEUE_PRIORITY_LOW);
+}
+
+/*
+ * Queue an upload behind any other network requests and return right away. Errors are all handled (logged) internally.
+ */
+void memfault_interface_post_data_async() {
+    if (http_queue_is_pending(&async_upload_req)) {
+        log_printf(LOG_LEVEL_INFO, "Memfault upload already queued, not queueing another");
+        return;
+    }
+
+    async_upload_req = (http_queue_req_t){
+        .sink = HTTP_QUEUE_SINK_JOB,
+        .job  = {.fn = memfault_interface_upload},
+    };
+    (void)http_queue_submit(&async_upload_req, HTTP_QUEUE_PRIORITY_LOW);
+}
+
 /*
  * Memfault weak function, override here to bundle custom metrics every time heartbeat elapsed and data sent
  */
 void memfault_metrics_heartbeat_collect_data() {
-    size_t      total                 = heap_caps_get_total_size(MALLOC_CAP_8BIT);
-    size_t      free                  = heap_caps_get_free_size(MALLOC_CAP_8BIT);
-    size_t      min_free              = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
-    size_t      largest_block         = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
-    UBaseType_t cli_total_words       = cli_task_get_stack_high_water();
-    UBaseType_t ota_total_words       = ota_task_get_stack_high_water();
-    UBaseType_t scheduler_total_words = scheduler_task_get_stack_high_water();
+    size_t      total                  = heap_caps_get_total_size(MALLOC_CAP_8BIT);
+    size_t      free                   = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    size_t      min_free               = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    size_t      largest_block          = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    UBaseType_t cli_total_words        = cli_task_get_stack_high_water();
+    UBaseType_t ota_total_words        = ota_task_get_stack_high_water();
+    UBaseType_t scheduler_total_words  = scheduler_task_get_stack_high_water();
+    UBaseType_t render_total_words     = scheduler_render_task_get_stack_high_water();
+    UBaseType_t http_queue_total_words = http_queue_get_stack_high_water();
 
     memfault_metrics_heartbeat_set_unsigned(MEMFAULT_METRICS_KEY(total_heap_bytes), total);
     memfault_metrics_heartbeat_set_unsigned(MEMFAULT_METRICS_KEY(free_heap_bytes), free);
@@ -77,4 +112,8 @@ void memfault_metrics_heartbeat_collect_data() {
                                             ota_total_words * sizeof(uint32_t));
     memfault_metrics_heartbeat_set_unsigned(MEMFAULT_METRICS_KEY(scheduler_task_high_water_stack_bytes),
                                             scheduler_total_words * sizeof(uint32_t));
+    memfault_metrics_heartbeat_set_unsigned(MEMFAULT_METRICS_KEY(render_task_high_water_stack_bytes),
+                                            render_total_words * sizeof(uint32_t));
+    memfault_metrics_heartbeat_set_unsigned(MEMFAULT_METRICS_KEY(http_queue_task_high_water_stack_bytes),
+                                            http_queue_total_words * sizeof(uint32_t));
 }
@@ -31,6 +31,10 @@ static char _tz_str[MAX_LENGTH_TZ_STR_PARAM + 1]                       = {0};
 static char _tz_display_name[MAX_LENGTH_TZ_DISPLAY_NAME_PARAM + 1]     = {0};
 static char _operating_mode[MAX_LENGTH_OPERATING_MODE_PARAM + 1]       = {0};
 static char _custom_screen_url[MAX_LENGTH_CUSTOM_SCREEN_URL_PARAM + 1] = {0};
+static char _conditions_schedule[MAX_LENGTH_SCHEDULE_PARAM + 1]        = {0};
+static char _tide_chart_schedule[MAX_LENGTH_SCHEDULE_PARAM + 1]        = {0};
+static char _swell_chart_schedule[MAX_LENGTH_SCHEDULE_PARAM + 1]       = {0};
+static char _wind_chart_schedule[MAX_LENGTH_SCHEDULE_PARAM + 1]        = {0};
 
 static spot_check_config_t current_config;
 
@@ -96,6 +100,19 @@ static spot_check_config_t *nvs_load_config() {
         active_chart_2 = SCREEN_IMG_SWELL_CHART;
     }
 
+    // Validated by the scheduler when it compiles them, it falls back to its defaults itself
+    max_bytes_to_write = MAX_LENGTH_SCHEDULE_PARAM;
+    nvs_get_string("sched_cond", _conditions_schedule, &max_bytes_to_write, SCHEDULER_DEFAULT_CONDITIONS_SCHEDULE);
+
+    max_bytes_to_write = MAX_LENGTH_SCHEDULE_PARAM;
+    nvs_get_string("sched_tide", _tide_chart_schedule, &max_bytes_to_write, SCHEDULER_DEFAULT_TIDE_CHART_SCHEDULE);
+
+    max_bytes_to_write = MAX_LENGTH_SCHEDULE_PARAM;
+    nvs_get_string("sched_swell", _swell_chart_schedule, &max_bytes_to_write, SCHEDULER_DEFAULT_SWELL_CHART_SCHEDULE);
+
+    max_bytes_to_write = MAX_LENGTH_SCHEDULE_PARAM;
+    nvs_get_string("sched_wind", _wind_chart_schedule, &max_bytes_to_write, SCHEDULER_DEFAULT_WIND_CHART_SCHEDULE);
+
     current_config.spot_name                   = _spot_name;
     current_config.spot_uid                    = _spot_uid;
     current_config.spot_lat                    = _spot_lat;
@@ -107,6 +124,10 @@ static spot_check_config_t *nvs_load_config() {
     current_config.custom_update_interval_secs = temp_custom_update_interval_secs;
     current_config.active_chart_1              = active_chart_1;
     current_config.active_chart_2              = active_chart_2;
+    current_config.conditions_schedule         = _conditions_schedule;
+    current_config.tide_chart_schedule         = _tide_chart_schedule;
+    current_config.swell_chart_schedule        = _swell_chart_schedule;
+    current_config.wind_chart_schedule         = _wind_chart_schedule;
 
     nvs_print_config(LOG_LEVEL_DEBUG);
 
@@ -276,6 +297,51 @@ bool nvs_set_string(char *key, char *val) {
     return retval;
 }
 
+bool nvs_get_bytes(char *key, void *val, size_t *val_size) {
+    bool retval = false;
+    MEMFAULT_ASSERT(handle);
+
+    esp_err_t err = nvs_get_blob(handle, key, val, val_size);
+    switch (err) {
+        case ESP_OK:
+            retval = true;
+            break;
+        case ESP_ERR_NVS_NOT_FOUND:
+            log_printf(LOG_LEVEL_INFO, "The NVS value for key '%s' is not initialized yet", key);
+            break;
+        default:
+            log_printf(LOG_LEVEL_ERROR, "Error (%s) reading blob for key '%s' from NVS", esp_err_to_name(err), key);
+    }
+
+    return retval;
+}
+
+/*
+ * Set and commit a blob. A single blob write is atomic in NVS, so this can be used as a commit record for multiple
+ * related values.
+ */
+bool nvs_set_bytes(char *key, const void *val, size_t val_size) {
+    bool retval = false;
+    MEMFAULT_ASSERT(handle);
+
+    esp_err_t err = nvs_set_blob(handle, key, val, val_size);
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+
+    if (err == ESP_OK) {
+        retval = true;
+    } else {
+        log_printf(LOG_LEVEL_ERROR,
+                   "Error (%s) setting %u byte blob for key '%s' in NVS",
+                   esp_err_to_name(err),
+                   val_size,
+                   key);
+    }
+
+    return retval;
+}
+
 spot_check_config_t *nvs_get_config() {
     MEMFAULT_ASSERT(handle);
 
@@ -301,6 +367,10 @@ void nvs_print_config(log_level_t level) {
             log_printf(LOG_LEVEL_INFO, "custom_ui_secs: %lu", current_config.custom_update_interval_secs);
             log_printf(LOG_LEVEL_INFO, "active_chart_1: %u", current_config.active_chart_1);
             log_printf(LOG_LEVEL_INFO, "active_chart_2: %u", current_config.active_chart_2);
+            log_printf(LOG_LEVEL_INFO, "sched_cond: %s", current_config.conditions_schedule);
+            log_printf(LOG_LEVEL_INFO, "sched_tide: %s", current_config.tide_chart_schedule);
+            log_printf(LOG_LEVEL_INFO, "sched_swell: %s", current_config.swell_chart_schedule);
+            log_printf(LOG_LEVEL_INFO, "sched_wind: %s", current_config.wind_chart_schedule);
             break;
         case LOG_LEVEL_DEBUG:
             log_printf(LOG_LEVEL_DEBUG, "CURRENT IN-MEM SPOT CHECK CONFIG");
@@ -315,6 +385,10 @@ void nvs_print_config(log_level_t level) {
             log_printf(LOG_LEVEL_DEBUG, "custom_ui_secs: %lu", current_config.custom_update_interval_secs);
             log_printf(LOG_LEVEL_DEBUG, "active_chart_1: %u", current_config.active_chart_1);
             log_printf(LOG_LEVEL_DEBUG, "active_chart_2: %u", current_config.active_chart_2);
+            log_printf(LOG_LEVEL_DEBUG, "sched_cond: %s", current_config.conditions_schedule);
+            log_printf(LOG_LEVEL_DEBUG, "sched_tide: %s", current_config.tide_chart_schedule);
+            log_printf(LOG_LEVEL_DEBUG, "sched_swell: %s", current_config.swell_chart_schedule);
+            log_printf(LOG_LEVEL_DEBUG, "sched_wind: %s", current_config.wind_chart_schedule);
             break;
         default:
             MEMFAULT_ASSERT(0);
@@ -334,6 +408,7 @@ void nvs_save_config(spot_check_config_t *config) {
         scheduler_schedule_spot_name_update();
         scheduler_schedule_conditions_update();
         scheduler_schedule_both_charts_update();
+        scheduler_schedule_forecast_update();
         scheduler_trigger();
     }
 
@@ -348,12 +423,17 @@ void nvs_save_config(spot_check_config_t *config) {
     MEMFAULT_ASSERT(nvs_set_uint32("custom_ui_secs", config->custom_update_interval_secs));
     MEMFAULT_ASSERT(nvs_set_string("chart_1", (char *)chart_strings_by_enum[config->active_chart_1]));
     MEMFAULT_ASSERT(nvs_set_string("chart_2", (char *)chart_strings_by_enum[config->active_chart_2]));
+    MEMFAULT_ASSERT(nvs_set_string("sched_cond", config->conditions_schedule));
+    MEMFAULT_ASSERT(nvs_set_string("sched_tide", config->tide_chart_schedule));
+    MEMFAULT_ASSERT(nvs_set_string("sched_swell", config->swell_chart_schedule));
+    MEMFAULT_ASSERT(nvs_set_string("sched_wind", config->wind_chart_schedule));
 
     ESP_ERROR_CHECK(nvs_commit(handle));
 
     // Need to reload back into mem. Could theoretically manually set these to avoid the second flash time hit, but
     // safer to use the existing logic
     nvs_load_config();
+    scheduler_update_schedules();
 }
 
 esp_err_t nvs_full_erase() {
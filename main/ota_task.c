@@ -13,6 +13,7 @@
 
 #include "constants.h"
 #include "http_client.h"
+#include "http_queue.h"
 #include "json.h"
 #include "log.h"
 #include "ota_task.h"
@@ -154,24 +155,20 @@ static bool check_forced_update(esp_app_desc_t *current_image_info, char *versio
     char           url[strlen(URL_BASE) + strlen(version_info_path) + 1];
     http_request_t request_obj = http_client_build_post_request(version_info_path, url, post_data, strlen(post_data));
 
-    char                    *response_data;
-    size_t                   response_data_size;
-    esp_http_client_handle_t client;
-    int                      content_length = 0;
-    bool                     http_success = http_client_perform_with_retries(&request_obj, 1, &client, &content_length);
-    if (!http_success) {
+    // Runs inline since the OTA check is already a job on the http queue task
+    http_queue_req_t queue_req = {
+        .request            = &request_obj,
+        .additional_retries = 1,
+        .sink               = HTTP_QUEUE_SINK_BUFFER,
+    };
+    if (!http_queue_run(&queue_req, HTTP_QUEUE_PRIORITY_LOW)) {
         log_printf(LOG_LEVEL_ERROR,
-                   "Error in http perform request checking to see if need forced update, defaulting to no update");
+                   "Error in http request checking to see if need forced update, defaulting to no update");
         return false;
     }
 
-    esp_err_t http_err =
-        http_client_read_response_to_buffer(&client, content_length, &response_data, &response_data_size);
-    if (http_err != ESP_OK) {
-        log_printf(LOG_LEVEL_ERROR,
-                   "Error in http request readout checking to see if need forced update, defaulting to no update");
-        return false;
-    }
+    char  *response_data      = queue_req.buffer.data;
+    size_t response_data_size = queue_req.buffer.size;
 
     log_printf(LOG_LEVEL_INFO, "%s", response_data);
     bool   force_update      = false;
@@ -222,36 +219,20 @@ static void ota_task_stop(ota_result_t result) {
     vTaskDelete(NULL);
 }
 
-static void check_ota_update_task(void *args) {
-    sleep_handler_set_busy(SYSTEM_IDLE_OTA_BIT);
-    log_printf(LOG_LEVEL_INFO, "Starting OTA task to check update status");
-
-    // Store mode so we can properly revert once OTA is done no matter what state it finishes in
-    mode_at_task_start = scheduler_get_mode();
-
-#ifdef CONFIG_DISABLE_OTA
-    log_printf(LOG_LEVEL_INFO, "FW compiled with ENABLE_OTA menuconfig option disabled, bailing out of OTA task");
-    ota_task_stop(OTA_RESULT_NOT_STARTED);
-    return;
-#endif
-
-    // This only checks if we're connected to a wifi network, but not if there's an active internet connection beyond
-    // that. That's fine, as the status checks for http requests later in the ota process will fail out gracefully if
-    // error codes rcvd
-    if (!wifi_is_connected_to_network()) {
-        log_printf(LOG_LEVEL_INFO, "Not connected to wifi, waiting for 30 seconds then bailing out of OTA task");
-        if (!wifi_block_until_connected_timeout(30 * MS_PER_SEC)) {
-            log_printf(LOG_LEVEL_INFO, "No connection received, bailing out of OTA task");
-            ota_task_stop(OTA_RESULT_NOT_STARTED);
-            return;
-        }
-        log_printf(LOG_LEVEL_INFO, "Got connection, continuing with OTA check");
-    }
+/*
+ * Everything that touches the network, run as a job on the http queue task. esp_https_ota has its own http client, so
+ * this keeps it from ever having a connection open at the same time as any other request (including memfault uploads).
+ * Other requests wait behind it, which is fine since the scheduler doesn't make any while in OTA mode. Sets result for
+ * ota_task_stop, returns whether the update succeeded.
+ */
+static bool ota_task_check_and_download(void *arg) {
+    ota_result_t *result = (ota_result_t *)arg;
 
     // Start our OTA process with the default binary URL first
     bool success = ota_start_ota(CONFIG_OTA_URL);
     if (!success) {
-        ota_task_stop(OTA_RESULT_NOT_STARTED);
+        *result = OTA_RESULT_NOT_STARTED;
+        return false;
     }
 
     // Get our current version
@@ -264,8 +245,8 @@ static void check_ota_update_task(void *args) {
     esp_err_t      error = esp_https_ota_get_img_desc(ota_handle, &ota_image_desc);
     if (error != ESP_OK) {
         log_printf(LOG_LEVEL_ERROR, "OTA failed at esp_https_ota_get_img_desc: %s", esp_err_to_name(error));
-        ota_task_stop(OTA_RESULT_FAIL);
-        return;
+        *result = OTA_RESULT_FAIL;
+        return false;
     }
 
     // Check to see if a basic version comparison results in an update from a newer version on the server
@@ -281,8 +262,8 @@ static void check_ota_update_task(void *args) {
                        "Error cleaning up OTA handle to manually check our force endpoint. Giving up on OTA right now "
                        "and deleting task, but socket lock from ota internal http_client in unknown state, rest of app "
                        "might be broken.");
-            ota_task_stop(OTA_RESULT_FAIL);
-            return;
+            *result = OTA_RESULT_FAIL;
+            return false;
         }
 
         // If we get anything other than success, we don't do our basic upgrade. Check our force upgrade/downgrade
@@ -305,13 +286,13 @@ static void check_ota_update_task(void *args) {
             ota_start_ota(forced_version_url);
         } else {
             log_printf(LOG_LEVEL_INFO, "Still got no go-ahead from force OTA endpoint, deleting OTA task");
-            ota_task_stop(OTA_RESULT_NOT_STARTED);
-            return;
+            *result = OTA_RESULT_NOT_STARTED;
+            return false;
         }
     }
 
     // Notify user on screen and kick scheduler into OTA mode so time updates continue but no other network requests are
-    // made (that would fail anyway since ota is monopolizing http client)
+    // made (they'd only wait in the http queue until the download is done)
     scheduler_set_ota_mode();
     spot_check_draw_ota_start_text();
     spot_check_render();
@@ -342,8 +323,8 @@ static void check_ota_update_task(void *args) {
     bool received_full_image = esp_https_ota_is_complete_data_received(ota_handle);
     if (!received_full_image) {
         log_printf(LOG_LEVEL_ERROR, "Did not receive full image package from server, aborting.");
-        ota_task_stop(OTA_RESULT_FAIL);
-        return;
+        *result = OTA_RESULT_FAIL;
+        return false;
     }
 
     error = esp_https_ota_finish(ota_handle);
@@ -357,8 +338,44 @@ static void check_ota_update_task(void *args) {
         }
     }
 
-    // Catch-all to clear OTA text and clean up task
-    ota_task_stop(OTA_RESULT_SUCCESS);
+    // Catch-all, reboots whether or not the finish succeeded
+    *result = OTA_RESULT_SUCCESS;
+    return true;
+}
+
+static void check_ota_update_task(void *args) {
+    sleep_handler_set_busy(SYSTEM_IDLE_OTA_BIT);
+    log_printf(LOG_LEVEL_INFO, "Starting OTA task to check update status");
+
+    // Store mode so we can properly revert once OTA is done no matter what state it finishes in
+    mode_at_task_start = scheduler_get_mode();
+
+#ifdef CONFIG_DISABLE_OTA
+    log_printf(LOG_LEVEL_INFO, "FW compiled with ENABLE_OTA menuconfig option disabled, bailing out of OTA task");
+    ota_task_stop(OTA_RESULT_NOT_STARTED);
+    return;
+#endif
+
+    // This only checks if we're connected to a wifi network, but not if there's an active internet connection beyond
+    // that. That's fine, as the status checks for http requests later in the ota process will fail out gracefully if
+    // error codes rcvd
+    if (!wifi_is_connected_to_network()) {
+        log_printf(LOG_LEVEL_INFO, "Not connected to wifi, waiting for 30 seconds then bailing out of OTA task");
+        if (!wifi_block_until_connected_timeout(30 * MS_PER_SEC)) {
+            log_printf(LOG_LEVEL_INFO, "No connection received, bailing out of OTA task");
+            ota_task_stop(OTA_RESULT_NOT_STARTED);
+            return;
+        }
+        log_printf(LOG_LEVEL_INFO, "Got connection, continuing with OTA check");
+    }
+
+    ota_result_t     result    = OTA_RESULT_NOT_STARTED;
+    http_queue_req_t queue_req = {
+        .sink = HTTP_QUEUE_SINK_JOB,
+        .job  = {.fn = ota_task_check_and_download, .arg = &result},
+    };
+    (void)http_queue_run(&queue_req, HTTP_QUEUE_PRIORITY_LOW);
+    ota_task_stop(result);
 }
 
 UBaseType_t ota_task_get_stack_high_water() {
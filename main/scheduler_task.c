@@ -1,20 +1,27 @@
 #include <string.h>
+#include <sys/time.h>
 #include <time.h>
 
 #include "esp_wifi.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "freertos/task.h"
 #include "memfault/panics/assert.h"
 #include "memfault_interface.h"
 
 #include "scheduler_task.h"
 
+#include "batch_fetch.h"
+#include "chart.h"
 #include "constants.h"
+#include "cron.h"
 #include "gpio.h"
 #include "http_client.h"
 #include "log.h"
 #include "nvs.h"
 #include "ota_task.h"
+#include "scheduled_bits.h"
 #include "screen_img_handler.h"
 #include "sleep_handler.h"
 #include "sntp_time.h"
@@ -24,13 +31,30 @@
 
 #define TAG SC_TAG_SCHEDULER
 
-#define NUM_DIFFERENTIAL_UPDATES 5
-#define NUM_DISCRETE_UPDATES 9
+#define NUM_DIFFERENTIAL_UPDATES 7
+#define NUM_DISCRETE_UPDATES 7
+#define NUM_SCHEDULER_EVENTS (NUM_DIFFERENTIAL_UPDATES + NUM_DISCRETE_UPDATES)
+
+// Longest the event timer is ever armed for. Anything that moves the wall clock should call scheduler_reschedule, this
+// only bounds how late an event can be if something doesn't
+#define EVENT_TIMER_MAX_SECONDS (15 * SECS_PER_MIN)
 
 #define OTA_CHECK_INTERVAL_SECONDS (CONFIG_OTA_CHECK_INTERVAL_HOURS * MINS_PER_HOUR * SECS_PER_MIN)
 #define NETWORK_CHECK_INTERVAL_SECONDS (30)
 #define MFLT_UPLOAD_INTERVAL_SECONDS (30 * SECS_PER_MIN)
 #define SCREEN_DIRTY_INTERVAL_SECONDS (30 * SECS_PER_MIN)
+// Series covers two days, so a couple of failed refreshes in a row still leave the conditions current
+#define FORECAST_UPDATE_INTERVAL_SECONDS (12 * MINS_PER_HOUR * SECS_PER_MIN)
+// Charts drawn from the forecast are redrawn locally this often to move their current time marker
+#define CHART_MARKER_INTERVAL_SECONDS (15 * SECS_PER_MIN)
+
+// When streaming, the fetch stage draws screen images itself as each chunk arrives, right after the image area was
+// cleared, instead of saving them to flash for the render stage to read back
+#ifdef CONFIG_STREAM_SCREEN_IMG
+#define STREAM_SCREEN_IMGS true
+#else
+#define STREAM_SCREEN_IMGS false
+#endif
 
 #define UPDATE_CONDITIONS_BIT (1 << 0)
 #define UPDATE_TIDE_CHART_BIT (1 << 1)
@@ -44,6 +68,8 @@
 #define MARK_SCREEN_DIRTY_BIT (1 << 9)
 #define CUSTOM_SCREEN_UPDATE_BIT (1 << 10)
 #define UPDATE_WIND_CHART_BIT (1 << 11)
+#define UPDATE_FORECAST_BIT (1 << 12)
+#define UPDATE_CHART_MARKER_BIT (1 << 13)
 
 // Anything that causes a draw to the  screen needs to be added here. This exists so scheduler doesn't re-render screen
 // for logical update structs like memfault or ota check
@@ -51,6 +77,14 @@
     (UPDATE_CONDITIONS_BIT | UPDATE_TIDE_CHART_BIT | UPDATE_SWELL_CHART_BIT | UPDATE_WIND_CHART_BIT | \
      UPDATE_TIME_BIT | UPDATE_SPOT_NAME_BIT | UPDATE_DATE_BIT | CUSTOM_SCREEN_UPDATE_BIT)
 
+// Bits that only draw and need nothing from the network. These go straight to the render stage instead of through the
+// fetch stage, so they're never stuck behind a slow download.
+#define DRAW_ONLY_BITS (UPDATE_TIME_BIT | UPDATE_DATE_BIT | UPDATE_SPOT_NAME_BIT | MARK_SCREEN_DIRTY_BIT)
+
+// Jobs the fetch stage can get ahead of the render stage before it blocks. A full refresh sends one per resource.
+#define RENDER_QUEUE_LENGTH (8)
+#define NUM_CHART_UPDATES (sizeof(chart_updates) / sizeof(chart_updates[0]))
+
 /*
  * Exists only to easily index into the discrete/diff update struct arrays in order to perform special handling for
  * specific entries (rather than always string comparing the name)
@@ -60,9 +94,7 @@ typedef enum {
     DISCRETE_UPDATE_INDEX_DATE,
     DISCRETE_UPDATE_INDEX_CONDITIONS,
     DISCRETE_UPDATE_INDEX_TIDE_CHART,
-    DISCRETE_UPDATE_INDEX_SWELL_CHART_MORNING,
-    DISCRETE_UPDATE_INDEX_SWELL_CHART_MIDDAY,
-    DISCRETE_UPDATE_INDEX_SWELL_CHART_EVENING,
+    DISCRETE_UPDATE_INDEX_SWELL_CHART,
     DISCRETE_UPDATE_INDEX_SPOT_NAME,
     DISCRETE_UPDATE_INDEX_WIND_CHART,
 
@@ -75,6 +107,8 @@ typedef enum {
     DIFFERENTIAL_UPDATE_INDEX_MFLT_UPLOAD,
     DIFFERENTIAL_UPDATE_INDEX_DIRTY_SCREEN,
     DIFFERENTIAL_UPDATE_INDEX_CUSTOM_SCREEN_UPDATE,
+    DIFFERENTIAL_UPDATE_INDEX_FORECAST,
+    DIFFERENTIAL_UPDATE_INDEX_CHART_MARKER,
 
     DIFFERENTIAL_UPDATE_INDEX_COUNT,
 } differential_update_index_t;
@@ -91,9 +125,11 @@ typedef struct {
 } differential_update_t;
 
 typedef struct {
-    char              debug_name[14];  // only used for logging/debugging, not necessary
-    uint8_t           hour;
-    uint8_t           minute;
+    char              debug_name[14];    // only used for logging/debugging, not necessary
+    const char       *default_schedule;  // cron expression (see cron.h), NULL if it only ever runs when forced
+    const char       *schedule_str;      // expression schedule was compiled from, default or from config
+    cron_schedule_t   schedule;
+    screen_img_t      chart;  // chart this update is for, SCREEN_IMG_COUNT if it isn't one
     struct tm         last_executed;
     bool              active;
     spot_check_mode_t active_operating_mode;
@@ -102,13 +138,66 @@ typedef struct {
     bool force_on_transition_to_online;  // set at compile time, should not be changed ever
 } discrete_update_t;
 
+typedef enum {
+    SCHEDULER_EVENT_DIFFERENTIAL,
+    SCHEDULER_EVENT_DISCRETE,
+} scheduler_event_type_t;
+
+/*
+ * Next time an active update struct is due. There's at most one per struct in the queue.
+ */
+typedef struct {
+    time_t                 fire_epoch_secs;
+    scheduler_event_type_t type;
+    uint8_t                index;
+} scheduler_event_t;
+
+/*
+ * Work for the render stage from one point of a round in the fetch stage, e.g. the conditions once they're downloaded.
+ * Draw-only bits from scheduler_trigger are sent as standalone jobs, which can land in the middle of a round.
+ */
+typedef struct {
+    uint32_t     draw_bits;           // Drawn by the render stage
+    uint32_t     drawn_bits;          // Already drawn into the framebuffer by the fetch stage, only refreshed
+    uint32_t     marker_bits;         // Drawn bits whose chart only moved its time marker, never marks the screen dirty
+    bool         full_clear;          // Screen was cleared for this round, nothing needs clearing before it's drawn
+    bool         end_of_round;        // Last job of the round, where the whole screen might get marked dirty
+    bool         standalone;          // Sent by scheduler_trigger, not part of the fetch stage's round
+    bool         conditions_success;  // Draw conditions if set, the conditions error otherwise
+    conditions_t conditions;
+} scheduler_render_job_t;
+
+// Each chart's update bit, for handling all of them the same way in a loop
+static const struct {
+    uint32_t     update_bit;
+    screen_img_t screen_img;
+    uint32_t     idle_bit;
+    char         debug_name[6];
+} chart_updates[] = {
+    {UPDATE_TIDE_CHART_BIT, SCREEN_IMG_TIDE_CHART, SYSTEM_IDLE_TIDE_CHART_BIT, "tide"},
+    {UPDATE_SWELL_CHART_BIT, SCREEN_IMG_SWELL_CHART, SYSTEM_IDLE_SWELL_CHART_BIT, "swell"},
+    {UPDATE_WIND_CHART_BIT, SCREEN_IMG_WIND_CHART, SYSTEM_IDLE_WIND_CHART_BIT, "wind"},
+};
+
 static TaskHandle_t          scheduler_task_handle;
+static TaskHandle_t          render_task_handle;
+static QueueHandle_t         render_queue;
 static scheduler_mode_t      scheduler_mode;
 static volatile unsigned int seconds_elapsed;
 static conditions_t          last_retrieved_conditions;
-static uint32_t              scheduled_bits;
-
-// Execute function cannot be blocking! Will execute from 1 sec timer interrupt callback
+// Set by the render stage, read by the fetch stage to tell whether unchanged conditions can be skipped
+static volatile bool         last_retrieved_conditions_drawn;
+// Set from the event timer, http server, CLI and boot in parallel, only ever touched through scheduled_bits_*
+static scheduled_bits_t      scheduled_bits;
+
+// Min-heap of the next event for every active update struct by fire time, with one one-shot timer armed for the
+// earliest. Locked since it's rebuilt from mode, config and time changes in other tasks while the timer task pops it.
+static scheduler_event_t event_queue[NUM_SCHEDULER_EVENTS];
+static uint8_t           event_queue_len;
+static SemaphoreHandle_t event_queue_lock;
+static timer_info_handle event_timer_handle;
+
+// Execute function cannot be blocking! Will execute from the event timer callback
 static differential_update_t differential_updates[NUM_DIFFERENTIAL_UPDATES] = {
     [DIFFERENTIAL_UPDATE_INDEX_OTA] =
         {
@@ -135,10 +224,8 @@ static differential_update_t differential_updates[NUM_DIFFERENTIAL_UPDATES] = {
             .debug_name        = "mflt_upload",
             .force_next_update = false,
             .force_on_transition_to_online =
-                false,  // do not set this true - it will run immediately on transition from init->online mode at boot,
-                        // and if it has a large payload to upload, it will break any subsequent network requests (like
-                        // custom screen download) because we can't block on the upload, it just triggers the internal
-                        // http client in memfault code
+                false,  // do not set this true - boot already does a heartbeat-only upload and then schedules the
+                        // full one itself once the packetizer is reset, see main.c
             .update_interval_secs  = MFLT_UPLOAD_INTERVAL_SECONDS,
             .active                = false,
             .active_operating_mode = 0xFF,
@@ -165,17 +252,37 @@ static differential_update_t differential_updates[NUM_DIFFERENTIAL_UPDATES] = {
             .active_operating_mode = SPOT_CHECK_MODE_CUSTOM,
             .execute               = scheduler_schedule_custom_screen_update,
         },
+    [DIFFERENTIAL_UPDATE_INDEX_FORECAST] =
+        {
+            .debug_name                    = "forecast",
+            .force_next_update             = false,
+            .force_on_transition_to_online = true,
+            .update_interval_secs          = FORECAST_UPDATE_INTERVAL_SECONDS,
+            .active                        = false,
+            .active_operating_mode         = SPOT_CHECK_MODE_WEATHER,
+            .execute                       = scheduler_schedule_forecast_update,
+        },
+    [DIFFERENTIAL_UPDATE_INDEX_CHART_MARKER] =
+        {
+            .debug_name                    = "chart_marker",
+            .force_next_update             = false,
+            .force_on_transition_to_online = false,
+            .update_interval_secs          = CHART_MARKER_INTERVAL_SECONDS,
+            .active                        = false,
+            .active_operating_mode         = SPOT_CHECK_MODE_WEATHER,
+            .execute                       = scheduler_schedule_chart_marker_update,
+        },
 };
 
-// Execute function cannot be blocking! Will execute from 1 sec timer interrupt callback
+// Execute function cannot be blocking! Will execute from the event timer callback
 static discrete_update_t discrete_updates[NUM_DISCRETE_UPDATES] = {
     [DISCRETE_UPDATE_INDEX_TIME] =
         {
             .debug_name                    = "time",
             .force_next_update             = false,
             .force_on_transition_to_online = true,
-            .hour                          = 0xFF,  // wildcards, should update every minute every hour
-            .minute                        = 0xFF,
+            .default_schedule              = "* *",  // every minute every hour
+            .chart                         = SCREEN_IMG_COUNT,
             .last_executed                 = {0},
             .active                        = false,
             .active_operating_mode         = SPOT_CHECK_MODE_WEATHER,
@@ -186,8 +293,8 @@ static discrete_update_t discrete_updates[NUM_DISCRETE_UPDATES] = {
             .debug_name                    = "date",
             .force_next_update             = false,
             .force_on_transition_to_online = true,
-            .hour                          = 0,
-            .minute                        = 1,
+            .default_schedule              = "1 0",
+            .chart                         = SCREEN_IMG_COUNT,
             .last_executed                 = {0},
             .active                        = false,
             .active_operating_mode         = SPOT_CHECK_MODE_WEATHER,
@@ -198,8 +305,8 @@ static discrete_update_t discrete_updates[NUM_DISCRETE_UPDATES] = {
             .debug_name                    = "conditions",
             .force_next_update             = false,
             .force_on_transition_to_online = true,
-            .hour                          = 0xFF,  // wildcard, runs on 5th minute of every hours
-            .minute                        = 5,
+            .default_schedule              = SCHEDULER_DEFAULT_CONDITIONS_SCHEDULE,
+            .chart                         = SCREEN_IMG_COUNT,
             .last_executed                 = {0},
             .active                        = false,
             .active_operating_mode         = SPOT_CHECK_MODE_WEATHER,
@@ -210,44 +317,20 @@ static discrete_update_t discrete_updates[NUM_DISCRETE_UPDATES] = {
             .debug_name                    = "tide",
             .force_next_update             = false,
             .force_on_transition_to_online = true,
-            .hour                          = 3,
-            .minute                        = 0,
+            .default_schedule              = SCHEDULER_DEFAULT_TIDE_CHART_SCHEDULE,
+            .chart                         = SCREEN_IMG_TIDE_CHART,
             .last_executed                 = {0},
             .active                        = false,
             .active_operating_mode         = SPOT_CHECK_MODE_WEATHER,
             .execute                       = scheduler_schedule_tide_chart_update,
         },
-    [DISCRETE_UPDATE_INDEX_SWELL_CHART_MORNING] =
+    [DISCRETE_UPDATE_INDEX_SWELL_CHART] =
         {
-            .debug_name                    = "swell_morning",
+            .debug_name                    = "swell",
             .force_next_update             = false,
             .force_on_transition_to_online = true,
-            .hour                          = 3,
-            .minute                        = 0,
-            .last_executed                 = {0},
-            .active                        = false,
-            .active_operating_mode         = SPOT_CHECK_MODE_WEATHER,
-            .execute                       = scheduler_schedule_swell_chart_update,
-        },
-    [DISCRETE_UPDATE_INDEX_SWELL_CHART_MIDDAY] =
-        {
-            .debug_name                    = "swell_midday",
-            .force_next_update             = false,
-            .force_on_transition_to_online = false,
-            .hour                          = 12,
-            .minute                        = 0,
-            .last_executed                 = {0},
-            .active                        = false,
-            .active_operating_mode         = SPOT_CHECK_MODE_WEATHER,
-            .execute                       = scheduler_schedule_swell_chart_update,
-        },
-    [DISCRETE_UPDATE_INDEX_SWELL_CHART_EVENING] =
-        {
-            .debug_name                    = "swell_evening",
-            .force_next_update             = false,
-            .force_on_transition_to_online = false,
-            .hour                          = 17,
-            .minute                        = 0,
+            .default_schedule              = SCHEDULER_DEFAULT_SWELL_CHART_SCHEDULE,
+            .chart                         = SCREEN_IMG_SWELL_CHART,
             .last_executed                 = {0},
             .active                        = false,
             .active_operating_mode         = SPOT_CHECK_MODE_WEATHER,
@@ -259,8 +342,8 @@ static discrete_update_t discrete_updates[NUM_DISCRETE_UPDATES] = {
                                         // spot name on first transition from boot offline mode into online mode
             .force_next_update             = false,
             .force_on_transition_to_online = true,
-            .hour                          = 0xEE,  // this hour will obviously never be hit
-            .minute                        = 0xEE,  // this minute will obviously never be hit
+            .default_schedule              = NULL,  // never runs on its own, only when forced
+            .chart                         = SCREEN_IMG_COUNT,
             .last_executed                 = {0},
             .active                        = false,
             .active_operating_mode         = SPOT_CHECK_MODE_WEATHER,
@@ -271,15 +354,13 @@ static discrete_update_t discrete_updates[NUM_DISCRETE_UPDATES] = {
             .debug_name                    = "wind",
             .force_next_update             = false,
             .force_on_transition_to_online = true,
-            .hour                          = 0xFF,  // wildcard, runs on 5th minute of every hours
-            .minute                        = 5,
+            .default_schedule              = SCHEDULER_DEFAULT_WIND_CHART_SCHEDULE,
+            .chart                         = SCREEN_IMG_WIND_CHART,
             .last_executed                 = {0},
             .active                        = false,
             .active_operating_mode         = SPOT_CHECK_MODE_WEATHER,
             .execute                       = scheduler_schedule_wind_chart_update,
         },
-
-    // NOTE :: MAKE SURE update_struct_is_chart IS UPDATED IF ANY NEW UPDATE STRUCTS FOR CHARTS ARE ADDED
 };
 
 // The update structs that should run in offline mode. Right now it's only one, so this can be typed specifically for
@@ -292,15 +373,7 @@ const differential_update_index_t offline_mode_update_indexes[] = {
 };
 
 /*
- * Returns whether or not the two time values (hour or min) match, OR always true if value is 0xFF wildcard (similar
- * to cron's '*')
- */
-static inline bool discrete_time_matches(int current, uint8_t check) {
-    return (current == check) || (check == 0xFF);
-}
-
-/*
- * Similar to the discrete time check, this returns true if the two modes match, or if the structs active_operating_mode
+ * Returns true if the two modes match, or if the structs active_operating_mode
  * is the 0xFF wildcard indicating that it should execute regardless of the operating mode (like memfault for example)
  */
 static inline bool active_operating_mode_matches(spot_check_mode_t current_mode,
@@ -309,128 +382,383 @@ static inline bool active_operating_mode_matches(spot_check_mode_t current_mode,
 }
 
 /*
- * Returns true if the two tm structs match from day to minutes granularity inclusive. Used to prevent discrete checks
- * from executing for every second of a time matching their min/hour fields, but also allow for the advancement of a day
- * to differentiate between last_executed times so it once again triggers the next day
+ * Returns true if the two tm structs differ from day to minutes granularity inclusive. Used to prevent discrete updates
+ * from being scheduled again in a minute they already executed in, but also allow for the advancement of a day to
+ * differentiate between last_executed times so it once again triggers the next day
  */
 static inline bool discrete_time_not_yet_executed_today(struct tm now, struct tm last_executed) {
     return now.tm_wday != last_executed.tm_wday || now.tm_hour != last_executed.tm_hour ||
            now.tm_min != last_executed.tm_min;
 }
 
-static inline bool active_chart_matches(spot_check_config_t *config, discrete_update_index_t index) {
-    screen_img_t screen_img_to_compare;
+static inline bool active_chart_matches(spot_check_config_t *config, screen_img_t chart) {
+    return config->active_chart_1 == chart || config->active_chart_2 == chart;
+}
+
+/*
+ * Schedule expression for a discrete update, from the config for the ones that can be changed there
+ */
+static const char *scheduler_get_configured_schedule(spot_check_config_t *config, discrete_update_index_t index) {
     switch (index) {
+        case DISCRETE_UPDATE_INDEX_CONDITIONS:
+            return config->conditions_schedule;
         case DISCRETE_UPDATE_INDEX_TIDE_CHART:
-            screen_img_to_compare = SCREEN_IMG_TIDE_CHART;
+            return config->tide_chart_schedule;
+        case DISCRETE_UPDATE_INDEX_SWELL_CHART:
+            return config->swell_chart_schedule;
+        case DISCRETE_UPDATE_INDEX_WIND_CHART:
+            return config->wind_chart_schedule;
+        default:
+            return discrete_updates[index].default_schedule;
+    }
+}
+
+/*
+ * Compile every discrete update's schedule. An invalid expression from the config falls back to the default one.
+ */
+static void scheduler_load_schedules() {
+    spot_check_config_t *config = nvs_get_config();
+    for (int i = 0; i < NUM_DISCRETE_UPDATES; i++) {
+        discrete_update_t *discrete_update = &discrete_updates[i];
+        const char        *expr            = scheduler_get_configured_schedule(config, i);
+        if (expr == NULL) {
+            memset(&discrete_update->schedule, 0, sizeof(cron_schedule_t));
+            discrete_update->schedule_str = "never";
+            continue;
+        }
+
+        if (!cron_parse(expr, &discrete_update->schedule)) {
+            log_printf(LOG_LEVEL_ERROR,
+                       "Invalid schedule '%s' for discrete update '%s', falling back to '%s'",
+                       expr,
+                       discrete_update->debug_name,
+                       discrete_update->default_schedule);
+            expr = discrete_update->default_schedule;
+            MEMFAULT_ASSERT(cron_parse(expr, &discrete_update->schedule));
+        }
+        discrete_update->schedule_str = expr;
+    }
+}
+
+static void scheduler_event_queue_push(const scheduler_event_t *event) {
+    MEMFAULT_ASSERT(event_queue_len < NUM_SCHEDULER_EVENTS);
+
+    uint8_t i = event_queue_len++;
+    while (i > 0) {
+        uint8_t parent = (i - 1) / 2;
+        if (event_queue[parent].fire_epoch_secs <= event->fire_epoch_secs) {
             break;
-        case DISCRETE_UPDATE_INDEX_SWELL_CHART_MORNING:
-        case DISCRETE_UPDATE_INDEX_SWELL_CHART_MIDDAY:
-        case DISCRETE_UPDATE_INDEX_SWELL_CHART_EVENING:
-            screen_img_to_compare = SCREEN_IMG_SWELL_CHART;
+        }
+        event_queue[i] = event_queue[parent];
+        i              = parent;
+    }
+    event_queue[i] = *event;
+}
+
+static void scheduler_event_queue_pop(scheduler_event_t *event_out) {
+    MEMFAULT_ASSERT(event_queue_len > 0);
+
+    *event_out                   = event_queue[0];
+    const scheduler_event_t last = event_queue[--event_queue_len];
+    uint8_t                 i    = 0;
+    while (1) {
+        uint8_t child = 2 * i + 1;
+        if (child >= event_queue_len) {
             break;
-        case DISCRETE_UPDATE_INDEX_WIND_CHART:
-            screen_img_to_compare = SCREEN_IMG_WIND_CHART;
+        }
+        if (child + 1 < event_queue_len &&
+            event_queue[child + 1].fire_epoch_secs < event_queue[child].fire_epoch_secs) {
+            child++;
+        }
+        if (last.fire_epoch_secs <= event_queue[child].fire_epoch_secs) {
+            break;
+        }
+        event_queue[i] = event_queue[child];
+        i              = child;
+    }
+    event_queue[i] = last;
+}
+
+/*
+ * First second after the interval has fully elapsed since the last execution, or now if it's forced
+ */
+static time_t scheduler_differential_next_fire(const differential_update_t *diff_update, time_t now_epoch_secs) {
+    if (diff_update->force_next_update) {
+        return now_epoch_secs;
+    }
+
+    return diff_update->last_executed_epoch_secs + diff_update->update_interval_secs + 1;
+}
+
+/*
+ * Start of the next local minute matching the struct's schedule that it hasn't already executed in, or now if it's
+ * forced or that minute is the current one. Returns false if the struct never fires on its own (spot name).
+ */
+static bool scheduler_discrete_next_fire(const discrete_update_t *discrete_update,
+                                         time_t                   now_epoch_secs,
+                                         time_t                  *fire_epoch_secs) {
+    if (discrete_update->force_next_update) {
+        *fire_epoch_secs = now_epoch_secs;
+        return true;
+    }
+
+    if (cron_is_never(&discrete_update->schedule)) {
+        return false;
+    }
+
+    // Skip a minute it already ran in, either the current one or the second pass of an hour repeated by DST ending
+    time_t    next_epoch_secs = cron_next(&discrete_update->schedule, now_epoch_secs);
+    struct tm next_local;
+    localtime_r(&next_epoch_secs, &next_local);
+    while (!discrete_time_not_yet_executed_today(next_local, discrete_update->last_executed)) {
+        next_epoch_secs = cron_next(&discrete_update->schedule, next_epoch_secs + SECS_PER_MIN);
+        localtime_r(&next_epoch_secs, &next_local);
+    }
+
+    *fire_epoch_secs = MAX(next_epoch_secs, now_epoch_secs);
+    return true;
+}
+
+/*
+ * Queue the next event for an update struct if it's active and ever fires again. Event queue lock must be held.
+ */
+static void scheduler_event_queue_add_update(scheduler_event_type_t type, uint8_t index, time_t now_epoch_secs) {
+    scheduler_event_t event = {.type = type, .index = index};
+    switch (type) {
+        case SCHEDULER_EVENT_DIFFERENTIAL:
+            if (!differential_updates[index].active) {
+                return;
+            }
+            event.fire_epoch_secs = scheduler_differential_next_fire(&differential_updates[index], now_epoch_secs);
+            break;
+        case SCHEDULER_EVENT_DISCRETE:
+            if (!discrete_updates[index].active ||
+                !scheduler_discrete_next_fire(&discrete_updates[index], now_epoch_secs, &event.fire_epoch_secs)) {
+                return;
+            }
             break;
         default:
             MEMFAULT_ASSERT(0);
     }
 
-    return config->active_chart_1 == screen_img_to_compare || config->active_chart_2 == screen_img_to_compare;
+    scheduler_event_queue_push(&event);
 }
 
 /*
- * Returns true if the arg index is one of the chart update structs.
- * THIS FUNCTION NEEDS TO BE UPDATED IF A NEW CHART UPDATE STRUCT IS EVER ADDED.
- * I really don't like this implementation, too easy to forget, but the best I can think of for now.
+ * Arm the one-shot timer for the earliest event, or leave it unarmed if nothing's queued. Event queue lock must be
+ * held.
  */
-static inline bool update_struct_is_chart(discrete_update_index_t index) {
-    return index == DISCRETE_UPDATE_INDEX_TIDE_CHART || index == DISCRETE_UPDATE_INDEX_SWELL_CHART_MORNING ||
-           index == DISCRETE_UPDATE_INDEX_SWELL_CHART_MIDDAY || index == DISCRETE_UPDATE_INDEX_SWELL_CHART_EVENING ||
-           index == DISCRETE_UPDATE_INDEX_WIND_CHART;
+static void scheduler_event_timer_arm() {
+    if (event_queue_len == 0) {
+        log_printf(LOG_LEVEL_DEBUG, "No active update structs, event timer not armed");
+        return;
+    }
+
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    int64_t delay_ms = ((int64_t)event_queue[0].fire_epoch_secs - now.tv_sec) * MS_PER_SEC - now.tv_usec / 1000;
+    if (delay_ms < 1) {
+        delay_ms = 1;
+    } else if (delay_ms > EVENT_TIMER_MAX_SECONDS * MS_PER_SEC) {
+        delay_ms = EVENT_TIMER_MAX_SECONDS * MS_PER_SEC;
+    }
+
+    timer_change_period(event_timer_handle, (uint32_t)delay_ms);
+    timer_reset(event_timer_handle, false);
+}
+
+static void scheduler_execute_differential(differential_update_t *diff_update, time_t now_epoch_secs) {
+    // Printing time_t is fucked, have to convert to double with difftime
+    log_printf(LOG_LEVEL_DEBUG,
+               "Executing diff update '%s' (last: %.0f, now: %.0f, intvl: %.0f, force: %u)",
+               diff_update->debug_name,
+               difftime(diff_update->last_executed_epoch_secs, 0),
+               difftime(now_epoch_secs, 0),
+               difftime(diff_update->update_interval_secs, 0),
+               diff_update->force_next_update);
+
+    diff_update->execute();
+    diff_update->last_executed_epoch_secs = now_epoch_secs;
+    diff_update->force_next_update        = false;
+}
+
+static void scheduler_execute_discrete(discrete_update_t *discrete_update, struct tm *now_local) {
+    log_printf(LOG_LEVEL_DEBUG,
+               "Executing discrete update '%s' (curr hr: %u, curr min: %u, schedule: '%s', force: %u)",
+               discrete_update->debug_name,
+               now_local->tm_hour,
+               now_local->tm_min,
+               discrete_update->schedule_str,
+               discrete_update->force_next_update);
+
+    discrete_update->execute();
+    discrete_update->last_executed     = *now_local;
+    discrete_update->force_next_update = false;
 }
 
 /*
- * Polling function that runs every 1 second. Responsible for checking all differential/discrete time update structs
- * and if any have reached their elapsed time, execute and update them. No execute functions for the update structs
- * should be blocking - they should all either call trigger functions for main task to handle or execute very quickly
- * and return.
+ * One-shot timer callback for the earliest queued event. Executes every event that's due, queues the next one for each
+ * and re-arms for whatever's earliest after that, so the timer only ever wakes when something actually has to run. No
+ * execute functions for the update structs should be blocking - they should all either call trigger functions for main
+ * task to handle or execute very quickly and return.
  */
-static void scheduler_polling_timer_callback(void *timer_args) {
-    struct tm now_local;
-    sntp_time_get_local_time(&now_local);
-    time_t now_epoch_secs = mktime(&now_local);
+static void scheduler_event_timer_callback(void *timer_args) {
+    xSemaphoreTake(event_queue_lock, portMAX_DELAY);
 
-    differential_update_t *diff_check = NULL;
-    for (int i = 0; i < NUM_DIFFERENTIAL_UPDATES; i++) {
-        diff_check = &differential_updates[i];
-        if (!diff_check->active) {
-            continue;
+    struct tm now_local;
+    time_t    now_epoch_secs = time(NULL);
+    localtime_r(&now_epoch_secs, &now_local);
+
+    scheduler_event_t event;
+    while (event_queue_len > 0 && event_queue[0].fire_epoch_secs <= now_epoch_secs) {
+        scheduler_event_queue_pop(&event);
+        switch (event.type) {
+            case SCHEDULER_EVENT_DIFFERENTIAL:
+                scheduler_execute_differential(&differential_updates[event.index], now_epoch_secs);
+                break;
+            case SCHEDULER_EVENT_DISCRETE:
+                scheduler_execute_discrete(&discrete_updates[event.index], &now_local);
+                break;
+            default:
+                MEMFAULT_ASSERT(0);
         }
 
-        // If time differential has passed OR force execute flag set, execute and bring up to date.
-        if (((now_epoch_secs - diff_check->last_executed_epoch_secs) > diff_check->update_interval_secs) ||
-            diff_check->force_next_update) {
-            // Printing time_t is fucked, have to convert to double with difftime
-            log_printf(LOG_LEVEL_DEBUG,
-                       "Executing polling diff update '%s' (last: %.0f, now: %.0f, intvl: %.0f, force: %u)",
-                       diff_check->debug_name,
-                       difftime(diff_check->last_executed_epoch_secs, 0),
-                       difftime(now_epoch_secs, 0),
-                       difftime(diff_check->update_interval_secs, 0),
-                       diff_check->force_next_update);
+        scheduler_event_queue_add_update(event.type, event.index, now_epoch_secs);
+    }
 
-            diff_check->execute();
-            diff_check->last_executed_epoch_secs = now_epoch_secs;
-            diff_check->force_next_update        = false;
-        }
+    scheduler_event_timer_arm();
+    xSemaphoreGive(event_queue_lock);
+
+    // After all structs have scheduled their update bits, kick scheduler. This prevents the race condition of freertos
+    // context switching to the scheduler task before the timer task is done scheduling everything
+    scheduler_trigger();
+}
+
+static uint32_t scheduler_get_active_chart_bits() {
+    uint32_t             chart_bits = 0x0;
+    spot_check_config_t *config     = nvs_get_config();
+
+    if (config->active_chart_1 == SCREEN_IMG_TIDE_CHART || config->active_chart_2 == SCREEN_IMG_TIDE_CHART) {
+        chart_bits |= UPDATE_TIDE_CHART_BIT;
     }
 
-    discrete_update_t *discrete_check = NULL;
-    for (int i = 0; i < NUM_DISCRETE_UPDATES; i++) {
-        discrete_check = &discrete_updates[i];
-        if (!discrete_check->active) {
-            continue;
+    if (config->active_chart_1 == SCREEN_IMG_SWELL_CHART || config->active_chart_2 == SCREEN_IMG_SWELL_CHART) {
+        chart_bits |= UPDATE_SWELL_CHART_BIT;
+    }
+
+    if (config->active_chart_1 == SCREEN_IMG_WIND_CHART || config->active_chart_2 == SCREEN_IMG_WIND_CHART) {
+        chart_bits |= UPDATE_WIND_CHART_BIT;
+    }
+
+    return chart_bits;
+}
+
+/*
+ * Active charts that are drawn from the cached forecast instead of downloaded, as long as it has enough hours left
+ */
+static uint32_t scheduler_get_forecast_chart_bits() {
+    return chart_can_draw(spot_check_get_forecast()) ? scheduler_get_active_chart_bits() : 0;
+}
+
+/*
+ * Whether this round starts by erasing the whole screen and drawing everything on it again
+ */
+static bool scheduler_is_full_clear(spot_check_mode_t operating_mode, uint32_t update_bits) {
+    switch (operating_mode) {
+        case SPOT_CHECK_MODE_WEATHER:
+            // If these three are all set, it means scheduler just got kicked back into online mode. Whether or not
+            // this is from a boot, a discon/recon, or a first connection after boot error, do a full erase and redraw
+            return (update_bits & UPDATE_CONDITIONS_BIT) && (update_bits & UPDATE_TIDE_CHART_BIT) &&
+                   (update_bits & UPDATE_SWELL_CHART_BIT);
+        case SPOT_CHECK_MODE_CUSTOM:
+            // For now we always full clear in custom screen mode if this is a screen image update
+            return update_bits & CUSTOM_SCREEN_UPDATE_BIT;
+        default:
+            MEMFAULT_ASSERT(0);
+    }
+}
+
+static bool scheduler_conditions_equal(const conditions_t *a, const conditions_t *b) {
+    return a->temperature == b->temperature && a->wind_speed == b->wind_speed &&
+           a->is_tide_rising == b->is_tide_rising && strcmp(a->wind_dir, b->wind_dir) == 0 &&
+           strcmp(a->tide_height, b->tide_height) == 0;
+}
+
+/*
+ * On a full refresh, fetch the conditions and every chart being updated with one batch request instead of a request
+ * each. Returns the update bits that were fetched, the fetch stage skips these and the render stage draws them from
+ * what was just saved. Anything the batch didn't deliver (or everything, if the server doesn't support batching) falls
+ * back to its own request.
+ */
+static uint32_t scheduler_fetch_batch(uint32_t update_bits) {
+    static const struct {
+        uint32_t         update_bit;
+        batch_resource_t resource;
+    } batch_bits[] = {
+        {UPDATE_CONDITIONS_BIT, BATCH_RESOURCE_CONDITIONS},
+        {UPDATE_TIDE_CHART_BIT, BATCH_RESOURCE_TIDE_CHART},
+        {UPDATE_SWELL_CHART_BIT, BATCH_RESOURCE_SWELL_CHART},
+        {UPDATE_WIND_CHART_BIT, BATCH_RESOURCE_WIND_CHART},
+    };
+    const size_t num_batch_bits = sizeof(batch_bits) / sizeof(batch_bits[0]);
+
+    uint32_t resources = 0;
+    for (size_t i = 0; i < num_batch_bits; i++) {
+        if (update_bits & batch_bits[i].update_bit) {
+            resources |= BATCH_RESOURCE_BIT(batch_bits[i].resource);
         }
+    }
 
-        // If (matching time has arrived AND the update has not yet been executed today (necessary for preventing
-        // multiple executions in the same minute)) OR force execute flag set, execute.
-        if ((discrete_time_matches(now_local.tm_hour, discrete_check->hour) &&
-             discrete_time_matches(now_local.tm_min, discrete_check->minute) &&
-             discrete_time_not_yet_executed_today(now_local, discrete_check->last_executed)) ||
-            discrete_check->force_next_update) {
-            log_printf(LOG_LEVEL_DEBUG,
-                       "Executing discrete update '%s' (curr hr: %u, curr min: %u, check hr: %u, check min: %u, "
-                       "force: %u)",
-                       discrete_check->debug_name,
-                       now_local.tm_hour,
-                       now_local.tm_min,
-                       discrete_check->hour,
-                       discrete_check->minute,
-                       discrete_check->force_next_update);
+    sleep_handler_set_busy(SYSTEM_IDLE_CONDITIONS_BIT);
+    conditions_t new_conditions = {0};
+    uint32_t     saved          = 0;
+    uint32_t     unchanged      = 0;
+    bool         success        = batch_fetch_download_and_save(resources, &new_conditions, &saved, &unchanged);
+    sleep_handler_set_idle(SYSTEM_IDLE_CONDITIONS_BIT);
+    if (!success) {
+        return 0;
+    }
+
+    if (saved & BATCH_RESOURCE_BIT(BATCH_RESOURCE_CONDITIONS)) {
+        memcpy(&last_retrieved_conditions, &new_conditions, sizeof(conditions_t));
+    }
 
-            discrete_check->execute();
-            discrete_check->last_executed     = now_local;
-            discrete_check->force_next_update = false;
+    uint32_t fetched_bits = 0;
+    for (size_t i = 0; i < num_batch_bits; i++) {
+        if (saved & BATCH_RESOURCE_BIT(batch_bits[i].resource)) {
+            fetched_bits |= batch_bits[i].update_bit;
         }
     }
 
-    // After all structs have scheduled their update bits, kick scheduler. This prevents the race condition of freertos
-    // context switching to the scheduler task before the timer task is done scheduling everything
-    scheduler_trigger();
+    return fetched_bits;
+}
+
+/*
+ * Hand a job to the render stage. Blocks if the render stage is behind, so the fetch stage never gets more than a queue
+ * of jobs ahead of what's on screen. Jobs with nothing to draw are dropped, except the one ending a round.
+ */
+static void scheduler_render_send(const scheduler_render_job_t *job) {
+    if (!job->end_of_round && (job->draw_bits | job->drawn_bits) == 0x0) {
+        return;
+    }
+
+    xQueueSend(render_queue, job, portMAX_DELAY);
 }
 
+/*
+ * Fetch stage. Waits on the notification bits from scheduler_trigger, does every network request for them and sends
+ * the render stage a job as soon as each resource is ready, so it's drawn and refreshed while the rest are still
+ * downloading. Anything drawn straight from a download (streamed screen imgs) or from data only this task touches (the
+ * forecast) is drawn here and only refreshed by the render stage.
+ */
 static void scheduler_task(void *args) {
-    // Run polling timer every second that's responsible for triggering any differential or discrete updates that have
-    // reached execution time. Timer only calls trigger function, task waits indefinitely on event bits from triggers.
-    timer_info_handle scheduler_polling_timer_handle =
-        timer_local_init("scheduler-polling", scheduler_polling_timer_callback, NULL, MS_PER_SEC);
-    timer_reset(scheduler_polling_timer_handle, true);
-
-    uint32_t update_bits        = 0;
-    bool     full_clear         = false;
-    bool     scheduler_success  = false;
-    bool     force_screen_dirty = false;
+    // The event timer only calls trigger functions, task waits indefinitely on event bits from triggers
+    uint32_t update_bits         = 0;
+    uint32_t unchanged_bits      = 0;
+    uint32_t batched_bits        = 0;
+    uint32_t forecast_chart_bits = 0;
+    bool     full_clear          = false;
+    bool     scheduler_success   = false;
     while (1) {
         // Wait forever until a notification received. Clears all bits on exit since we'll handle every set bit in one
         // go
@@ -441,63 +769,166 @@ static void scheduler_task(void *args) {
                    update_bits);
 
         spot_check_config_t *config = nvs_get_config();
-        switch (config->operating_mode) {
-            case SPOT_CHECK_MODE_WEATHER:
-                // If these three are all set, it means scheduler just got kicked back into online mode. Whether or not
-                // this is from a boot, a discon/recon, or a first connection after boot error, do a full erase and
-                // redraw
-                full_clear = (update_bits & UPDATE_CONDITIONS_BIT) && (update_bits & UPDATE_TIDE_CHART_BIT) &&
-                             (update_bits & UPDATE_SWELL_CHART_BIT);
-                break;
-            case SPOT_CHECK_MODE_CUSTOM:
-                // For now we always full clear in custom screen mode if this is a screen image update
-                full_clear = update_bits & CUSTOM_SCREEN_UPDATE_BIT;
-                break;
-            default:
-                MEMFAULT_ASSERT(0);
+        full_clear                  = scheduler_is_full_clear(config->operating_mode, update_bits);
+
+        // Bits whose data the server reported as unchanged (304 or identical bytes). Unless the screen was fully
+        // cleared, what's drawn is still current so they're never sent to the render stage instead of clearing and
+        // redrawing the same thing and marking the whole screen dirty for it.
+        unchanged_bits = 0;
+
+        // Cleared before anything from this round is drawn. Draw-only bits are held back from the render stage by
+        // scheduler_trigger on a full clear and come through here, so they go out first now that the screen is blank.
+        if (full_clear) {
+            log_printf(LOG_LEVEL_DEBUG, "Performing full screen clear from scheduler_task");
+            spot_check_full_clear();
         }
+        scheduler_render_send(&(scheduler_render_job_t){
+            .draw_bits  = update_bits & DRAW_ONLY_BITS,
+            .full_clear = full_clear,
+        });
 
         /***************************************
          * Network update section
          * Gate every network request block with a check for scheduler mode so one failed request will short circuit any
          * remaining ones if their update bits are also set
          **************************************/
-        if (update_bits & UPDATE_CONDITIONS_BIT && scheduler_get_mode() != SCHEDULER_MODE_OFFLINE) {
+        // Before everything else so a fresh series can already be used for the conditions and charts
+        bool forecast_changed = false;
+        if (update_bits & UPDATE_FORECAST_BIT && scheduler_get_mode() != SCHEDULER_MODE_OFFLINE) {
+            sleep_handler_set_busy(SYSTEM_IDLE_CONDITIONS_BIT);
+            bool unchanged   = false;
+            forecast_changed = spot_check_download_and_save_forecast(&unchanged) && !unchanged;
+            sleep_handler_set_idle(SYSTEM_IDLE_CONDITIONS_BIT);
+        }
+
+        // Charts drawn from the forecast are never downloaded, and redrawing them to move the time marker is free
+        forecast_chart_bits       = 0;
+        uint32_t marker_only_bits = 0;
+        if (config->operating_mode == SPOT_CHECK_MODE_WEATHER) {
+            forecast_chart_bits = scheduler_get_forecast_chart_bits();
+        }
+        if (update_bits & UPDATE_CHART_MARKER_BIT) {
+            // Charts that weren't due anyway are drawn from the same data again, only their marker moves
+            if (!full_clear && !forecast_changed) {
+                marker_only_bits = forecast_chart_bits & ~update_bits;
+            }
+            update_bits |= forecast_chart_bits;
+        }
+
+        for (size_t i = 0; i < NUM_CHART_UPDATES; i++) {
+            const uint32_t update_bit = chart_updates[i].update_bit;
+            if (update_bits & forecast_chart_bits & update_bit) {
+                sleep_handler_set_busy(chart_updates[i].idle_bit);
+                if (marker_only_bits & update_bit) {
+                    screen_img_handler_redraw_forecast_chart(chart_updates[i].screen_img, spot_check_get_forecast());
+                } else {
+                    screen_img_handler_draw_forecast_chart(chart_updates[i].screen_img,
+                                                           spot_check_get_forecast(),
+                                                           !full_clear);
+                }
+                sleep_handler_set_idle(chart_updates[i].idle_bit);
+                scheduler_render_send(&(scheduler_render_job_t){
+                    .drawn_bits  = update_bit,
+                    .marker_bits = marker_only_bits & update_bit,
+                    .full_clear  = full_clear,
+                });
+            }
+        }
+
+        batched_bits = 0;
+        if (full_clear && config->operating_mode == SPOT_CHECK_MODE_WEATHER &&
+            scheduler_get_mode() != SCHEDULER_MODE_OFFLINE) {
+            batched_bits = scheduler_fetch_batch(update_bits & ~forecast_chart_bits);
+            if (batched_bits & UPDATE_CONDITIONS_BIT) {
+                scheduler_success = true;
+            }
+
+            scheduler_render_send(&(scheduler_render_job_t){
+                .draw_bits          = batched_bits,
+                .full_clear         = full_clear,
+                .conditions_success = scheduler_success,
+                .conditions         = last_retrieved_conditions,
+            });
+        }
+
+        // A cached forecast covering this hour is used as-is, online or not. Only a full refresh always goes to the
+        // server for them.
+        conditions_t forecast_conditions   = {0};
+        bool         conditions_forecasted = false;
+        if (!full_clear && update_bits & UPDATE_CONDITIONS_BIT &&
+            spot_check_get_forecast_conditions(&forecast_conditions)) {
+            if (last_retrieved_conditions_drawn && scheduler_success &&
+                scheduler_conditions_equal(&forecast_conditions, &last_retrieved_conditions)) {
+                unchanged_bits |= UPDATE_CONDITIONS_BIT;
+            }
+            memcpy(&last_retrieved_conditions, &forecast_conditions, sizeof(conditions_t));
+            scheduler_success     = true;
+            conditions_forecasted = true;
+            log_printf(LOG_LEVEL_DEBUG, "Advanced conditions from cached forecast");
+        }
+
+        if (update_bits & UPDATE_CONDITIONS_BIT & ~batched_bits && !conditions_forecasted &&
+            scheduler_get_mode() != SCHEDULER_MODE_OFFLINE) {
             sleep_handler_set_busy(SYSTEM_IDLE_CONDITIONS_BIT);
             conditions_t new_conditions = {0};
-            scheduler_success           = spot_check_download_and_save_conditions(&new_conditions);
-            if (scheduler_success) {
+            bool         unchanged      = false;
+            scheduler_success           = spot_check_download_and_save_conditions(&new_conditions, &unchanged);
+            if (scheduler_success && !unchanged) {
                 memcpy(&last_retrieved_conditions, &new_conditions, sizeof(conditions_t));
+            } else if (scheduler_success && last_retrieved_conditions_drawn) {
+                unchanged_bits |= UPDATE_CONDITIONS_BIT;
             }
             sleep_handler_set_idle(SYSTEM_IDLE_CONDITIONS_BIT);
         }
 
-        if (update_bits & UPDATE_TIDE_CHART_BIT && scheduler_get_mode() != SCHEDULER_MODE_OFFLINE) {
-            sleep_handler_set_busy(SYSTEM_IDLE_TIDE_CHART_BIT);
-            screen_img_handler_download_and_save(SCREEN_IMG_TIDE_CHART);
-            sleep_handler_set_idle(SYSTEM_IDLE_TIDE_CHART_BIT);
+        if (update_bits & UPDATE_CONDITIONS_BIT & ~batched_bits &&
+            (full_clear || !(unchanged_bits & UPDATE_CONDITIONS_BIT))) {
+            // Sent even when the request failed or we're offline, the render stage draws the error or the last ones
+            scheduler_render_send(&(scheduler_render_job_t){
+                .draw_bits          = UPDATE_CONDITIONS_BIT,
+                .full_clear         = full_clear,
+                .conditions_success = scheduler_success,
+                .conditions         = last_retrieved_conditions,
+            });
         }
 
-        if (update_bits & UPDATE_SWELL_CHART_BIT && scheduler_get_mode() != SCHEDULER_MODE_OFFLINE) {
-            sleep_handler_set_busy(SYSTEM_IDLE_SWELL_CHART_BIT);
-            screen_img_handler_download_and_save(SCREEN_IMG_SWELL_CHART);
-            sleep_handler_set_idle(SYSTEM_IDLE_SWELL_CHART_BIT);
-        }
+        for (size_t i = 0; i < NUM_CHART_UPDATES; i++) {
+            const uint32_t update_bit = chart_updates[i].update_bit;
+            if (!(update_bits & update_bit & ~batched_bits & ~forecast_chart_bits)) {
+                continue;
+            }
+
+            // Offline, whatever was saved last is drawn again
+            scheduler_render_job_t job = {.draw_bits = update_bit, .full_clear = full_clear};
+            if (scheduler_get_mode() != SCHEDULER_MODE_OFFLINE) {
+                sleep_handler_set_busy(chart_updates[i].idle_bit);
+                bool unchanged = false;
+                if (STREAM_SCREEN_IMGS) {
+                    // Clears the chart area (unless full_clear did) and draws it itself once new data arrives
+                    bool success = screen_img_handler_download_and_draw_chart(chart_updates[i].screen_img,
+                                                                              !full_clear,
+                                                                              &unchanged);
+                    if (!success || !unchanged) {
+                        job.draw_bits  = 0;
+                        job.drawn_bits = update_bit;
+                    }
+                } else {
+                    screen_img_handler_download_and_save(chart_updates[i].screen_img, &unchanged);
+                }
+                sleep_handler_set_idle(chart_updates[i].idle_bit);
+
+                if (unchanged && !full_clear) {
+                    unchanged_bits |= update_bit;
+                    continue;
+                }
+            }
 
-        if (update_bits & UPDATE_WIND_CHART_BIT && scheduler_get_mode() != SCHEDULER_MODE_OFFLINE) {
-            sleep_handler_set_busy(SYSTEM_IDLE_WIND_CHART_BIT);
-            screen_img_handler_download_and_save(SCREEN_IMG_WIND_CHART);
-            sleep_handler_set_idle(SYSTEM_IDLE_WIND_CHART_BIT);
+            scheduler_render_send(&job);
         }
 
-        // Note: MUST come before OTA bit right now. Special case timer on boot where we delay first memfault and ota
-        // run triggers both ota task and memfault upload simultaneously. If order is reversed, async ota task will be
-        // running http reqs and memfault upload http req will fail. Will be fixed with refactor / improvement of http
-        // req queueing
         if (update_bits & SEND_MFLT_DATA_BIT) {
-            // TODO :: brutally blocking right now for big coredump uploads
-            // Don't care about return value, all error-handling internal
-            (void)memfault_interface_post_data();
+            // Queued behind any other network requests, a big coredump upload doesn't hold up this loop
+            memfault_interface_post_data_async();
         }
 
         if (update_bits & CHECK_OTA_BIT && scheduler_get_mode() != SCHEDULER_MODE_OFFLINE) {
@@ -525,106 +956,153 @@ static void scheduler_task(void *args) {
             }
         }
 
-        if (update_bits & CUSTOM_SCREEN_UPDATE_BIT && scheduler_get_mode() != SCHEDULER_MODE_OFFLINE) {
-            sleep_handler_set_busy(SYSTEM_IDLE_CUSTOM_SCREEN_BIT);
-            screen_img_handler_download_and_save(SCREEN_IMG_CUSTOM_SCREEN);
-            sleep_handler_set_idle(SYSTEM_IDLE_CUSTOM_SCREEN_BIT);
+        if (update_bits & CUSTOM_SCREEN_UPDATE_BIT) {
+            // Offline, whatever was saved last is drawn again
+            scheduler_render_job_t job = {.draw_bits = CUSTOM_SCREEN_UPDATE_BIT, .full_clear = full_clear};
+            if (scheduler_get_mode() != SCHEDULER_MODE_OFFLINE) {
+                sleep_handler_set_busy(SYSTEM_IDLE_CUSTOM_SCREEN_BIT);
+                bool unchanged = false;
+                if (STREAM_SCREEN_IMGS) {
+                    // Clears the screen img area (unless full_clear did) and draws it itself once new data arrives
+                    bool success = screen_img_handler_download_and_draw_screen_img(SCREEN_IMG_CUSTOM_SCREEN,
+                                                                                   !full_clear,
+                                                                                   &unchanged);
+                    if (!success || !unchanged) {
+                        job.draw_bits  = 0;
+                        job.drawn_bits = CUSTOM_SCREEN_UPDATE_BIT;
+                    }
+                } else {
+                    screen_img_handler_download_and_save(SCREEN_IMG_CUSTOM_SCREEN, &unchanged);
+                }
+                sleep_handler_set_idle(SYSTEM_IDLE_CUSTOM_SCREEN_BIT);
+
+                if (unchanged && !full_clear) {
+                    unchanged_bits |= CUSTOM_SCREEN_UPDATE_BIT;
+                }
+            }
+
+            if (!(unchanged_bits & CUSTOM_SCREEN_UPDATE_BIT)) {
+                scheduler_render_send(&job);
+            }
         }
 
+        if (unchanged_bits) {
+            log_printf(LOG_LEVEL_DEBUG, "Skipped drawing unchanged bits 0x%08X", unchanged_bits);
+        }
+
+        // Lets the render stage decide whether the round needs the whole screen refreshed
+        scheduler_render_send(&(scheduler_render_job_t){
+            .full_clear   = full_clear,
+            .end_of_round = true,
+        });
+    }
+}
+
+/*
+ * Refresh the screen at the end of a round, or for a standalone job while no round is in progress. If either the force
+ * dirty flag is set or ANY bits requiring a screen render besides time and chart markers were set, mark entire
+ * framebuffer as dirty. marker_bits are the bits that only moved a chart's time marker in every job of the round.
+ */
+static void scheduler_render_round(uint32_t round_bits, uint32_t marker_bits, bool *force_screen_dirty) {
+    if (!(round_bits & BITS_NEEDING_RENDER)) {
+        return;
+    }
+
+    if (*force_screen_dirty || (round_bits & ~UPDATE_TIME_BIT & ~marker_bits)) {
+        *force_screen_dirty = false;
+        spot_check_mark_all_lines_dirty();
+    }
+
+    spot_check_render();
+}
+
+/*
+ * Render stage. Draws each job from the fetch stage (or straight from scheduler_trigger for draw-only bits) and
+ * refreshes the screen. Framebuffer diffing means a refresh only drives the rows that job changed, so every resource
+ * shows up as soon as it's ready. Whether the whole screen is marked dirty against gray-in is only decided once per
+ * round, on the job that ends it. The fetch stage still draws streamed images and forecast charts itself while this
+ * renders, display serializes every framebuffer write against renders.
+ */
+static void scheduler_render_task(void *args) {
+    scheduler_render_job_t job;
+    uint32_t               round_bits         = 0;
+    uint32_t               round_full_bits    = 0;  // Bits of the round drawn by at least one job that's not marker only
+    bool                   round_open         = false;
+    bool                   force_screen_dirty = false;
+    while (1) {
+        xQueueReceive(render_queue, &job, portMAX_DELAY);
+        sleep_handler_set_busy(SYSTEM_IDLE_RENDER_BIT);
+
+        const uint32_t update_bits = job.draw_bits | job.drawn_bits;
+        log_printf(LOG_LEVEL_DEBUG,
+                   "render task received job drawing 0x%02X, refreshing 0x%02X",
+                   job.draw_bits,
+                   job.drawn_bits);
+
         /***************************************
          * Framebuffer update section
          **************************************/
-        if (full_clear) {
-            log_printf(LOG_LEVEL_DEBUG, "Performing full screen clear from scheduler_task");
-            spot_check_full_clear();
-        }
-
-        if (update_bits & UPDATE_TIME_BIT) {
-            sleep_handler_set_busy(SYSTEM_IDLE_TIME_BIT);
-            if (!full_clear) {
+        if (job.draw_bits & UPDATE_TIME_BIT) {
+            if (!job.full_clear) {
                 spot_check_clear_time();
             }
 
             spot_check_draw_time();
             spot_check_mark_time_dirty();
-            sleep_handler_set_idle(SYSTEM_IDLE_TIME_BIT);
         }
 
-        if (update_bits & UPDATE_DATE_BIT) {
-            sleep_handler_set_busy(SYSTEM_IDLE_TIME_BIT);
-            if (!full_clear) {
+        if (job.draw_bits & UPDATE_DATE_BIT) {
+            if (!job.full_clear) {
                 spot_check_clear_date();
             }
 
             spot_check_draw_date();
-            sleep_handler_set_idle(SYSTEM_IDLE_TIME_BIT);
         }
 
-        if (update_bits & UPDATE_SPOT_NAME_BIT) {
+        if (job.draw_bits & UPDATE_SPOT_NAME_BIT) {
             // Slightly unique case as in it requires no network update, just used as a display update trigger
-            sleep_handler_set_busy(SYSTEM_IDLE_CONDITIONS_BIT);
-
             // TODO :: would be nice to have a 'previous_spot_name' key in config so we could pass to clear function
             // to smart erase with text inverse instead of block erasing max spot name width
-            if (!full_clear) {
+            if (!job.full_clear) {
                 spot_check_clear_spot_name();
             }
-            spot_check_draw_spot_name(config->spot_name);
-            sleep_handler_set_idle(SYSTEM_IDLE_CONDITIONS_BIT);
+            spot_check_draw_spot_name(nvs_get_config()->spot_name);
 
             // This should only ever run once, so whether it was triggered from initial boot or a new config spot, clear
             // the active flag here until it's manually triggered again.
             discrete_updates[DISCRETE_UPDATE_INDEX_SPOT_NAME].active = false;
         }
 
-        if (update_bits & UPDATE_CONDITIONS_BIT) {
-            sleep_handler_set_busy(SYSTEM_IDLE_CONDITIONS_BIT);
+        if (job.draw_bits & UPDATE_CONDITIONS_BIT) {
             // TODO :: don't support clearing spot name logic when changing location yet. Need a way to pass more info
             // to this case if we're clearing for a regular update or becase location changed and spot name will need to
             // be cleared too.
-            if (!full_clear) {
+            if (!job.full_clear) {
                 spot_check_clear_conditions(true, true, true);
             }
-            if (scheduler_success) {
-                spot_check_draw_conditions(&last_retrieved_conditions);
+            if (job.conditions_success) {
+                spot_check_draw_conditions(&job.conditions);
+                last_retrieved_conditions_drawn = true;
             } else {
                 spot_check_draw_conditions_error();
+                last_retrieved_conditions_drawn = false;
             }
-            log_printf(LOG_LEVEL_INFO, "scheduler task updated conditions");
-            sleep_handler_set_idle(SYSTEM_IDLE_CONDITIONS_BIT);
+            log_printf(LOG_LEVEL_INFO, "render task updated conditions");
         }
 
-        if (update_bits & UPDATE_TIDE_CHART_BIT) {
-            sleep_handler_set_busy(SYSTEM_IDLE_TIDE_CHART_BIT);
-            if (!full_clear) {
-                screen_img_handler_clear_chart(SCREEN_IMG_TIDE_CHART);
-            }
-            screen_img_handler_draw_chart(SCREEN_IMG_TIDE_CHART);
-            log_printf(LOG_LEVEL_INFO, "scheduler task updated tide chart");
-            sleep_handler_set_idle(SYSTEM_IDLE_TIDE_CHART_BIT);
-        }
-
-        if (update_bits & UPDATE_SWELL_CHART_BIT) {
-            sleep_handler_set_busy(SYSTEM_IDLE_SWELL_CHART_BIT);
-            if (!full_clear) {
-                screen_img_handler_clear_chart(SCREEN_IMG_SWELL_CHART);
+        for (size_t i = 0; i < NUM_CHART_UPDATES; i++) {
+            if (job.draw_bits & chart_updates[i].update_bit) {
+                if (!job.full_clear) {
+                    screen_img_handler_clear_chart(chart_updates[i].screen_img);
+                }
+                screen_img_handler_draw_chart(chart_updates[i].screen_img);
             }
-            screen_img_handler_draw_chart(SCREEN_IMG_SWELL_CHART);
-            log_printf(LOG_LEVEL_INFO, "scheduler task updated swell chart");
-            sleep_handler_set_idle(SYSTEM_IDLE_SWELL_CHART_BIT);
-        }
-
-        if (update_bits & UPDATE_WIND_CHART_BIT) {
-            sleep_handler_set_busy(SYSTEM_IDLE_WIND_CHART_BIT);
-            if (!full_clear) {
-                screen_img_handler_clear_chart(SCREEN_IMG_WIND_CHART);
+            if (update_bits & chart_updates[i].update_bit) {
+                log_printf(LOG_LEVEL_INFO, "render task updated %s chart", chart_updates[i].debug_name);
             }
-            screen_img_handler_draw_chart(SCREEN_IMG_WIND_CHART);
-            log_printf(LOG_LEVEL_INFO, "scheduler task updated wind chart");
-            sleep_handler_set_idle(SYSTEM_IDLE_WIND_CHART_BIT);
         }
 
-        if (update_bits & MARK_SCREEN_DIRTY_BIT) {
+        if (job.draw_bits & MARK_SCREEN_DIRTY_BIT) {
             // Manually mark the full framebuffer dirty to prevent long-term gray-in happening on longer-static areas of
             // the screen (aka everything but the time & conditions)
             force_screen_dirty = true;
@@ -633,28 +1111,39 @@ static void scheduler_task(void *args) {
                        "full screen");
         }
 
-        if (update_bits & CUSTOM_SCREEN_UPDATE_BIT) {
-            sleep_handler_set_busy(SYSTEM_IDLE_CUSTOM_SCREEN_BIT);
-            if (!full_clear) {
+        if (job.draw_bits & CUSTOM_SCREEN_UPDATE_BIT) {
+            if (!job.full_clear) {
                 screen_img_handler_clear_screen_img(SCREEN_IMG_CUSTOM_SCREEN);
             }
             screen_img_handler_draw_screen_img(SCREEN_IMG_CUSTOM_SCREEN);
-            log_printf(LOG_LEVEL_INFO, "scheduler task updated custom screen");
-            sleep_handler_set_idle(SYSTEM_IDLE_CUSTOM_SCREEN_BIT);
+        }
+        if (update_bits & CUSTOM_SCREEN_UPDATE_BIT) {
+            log_printf(LOG_LEVEL_INFO, "render task updated custom screen");
         }
 
         /***************************************
          * Render section
          **************************************/
-        if (update_bits & BITS_NEEDING_RENDER) {
-            // If either the force dirty flag is set or ANY bits requiring a screen render besides time are set, mark
-            // entire framebuffer as dirty
-            if (force_screen_dirty || (update_bits & ~UPDATE_TIME_BIT)) {
-                force_screen_dirty = false;
-                spot_check_mark_all_lines_dirty();
+        if (job.standalone && !round_open) {
+            scheduler_render_round(update_bits, job.marker_bits, &force_screen_dirty);
+        } else {
+            // A standalone job in the middle of a round (e.g. a clock tick while charts download) only refreshes what
+            // it drew and leaves the full screen decision to the fetch stage's end of round, so it can't close the round
+            // early and have the rest of it trigger a second GC16 pass.
+            round_bits |= update_bits;
+            round_full_bits |= update_bits & ~job.marker_bits;
+            round_open = !job.end_of_round;
+            if (job.end_of_round) {
+                scheduler_render_round(round_bits, round_bits & ~round_full_bits, &force_screen_dirty);
+                round_bits      = 0;
+                round_full_bits = 0;
+            } else if (update_bits & BITS_NEEDING_RENDER) {
+                spot_check_render();
             }
+        }
 
-            spot_check_render();
+        if (uxQueueMessagesWaiting(render_queue) == 0) {
+            sleep_handler_set_idle(SYSTEM_IDLE_RENDER_BIT);
         }
     }
 }
@@ -666,102 +1155,106 @@ static void scheduler_task(void *args) {
  * at once
  */
 void scheduler_trigger() {
-    // Don't trigger if nothing's set, this would result in triggering full task every second at end of update struct
-    // timer func
-    if (scheduled_bits == 0x0) {
+    // A bit set by another task at any point either makes it into this notification or stays set for the next trigger
+    uint32_t bits = scheduled_bits_take(&scheduled_bits);
+
+    // Don't trigger if nothing's set, this would result in waking the full task at the end of every event timer
+    // callback that didn't schedule anything
+    if (bits == 0x0) {
         return;
     }
 
-    uint32_t saved_scheduled_bits = scheduled_bits;
-
-    // TODO :: this should be wrapped in a lock to avoid the race condition of calling notify, another task setting a
-    // bit, and then the scheduler task taking over and not having that set bit in it's bits. Then we'd erase
-    // scheduled_bits below and it would be lost
-    xTaskNotify(scheduler_task_handle, scheduled_bits, eSetBits);
-    scheduled_bits = 0x0;
+    // Draw-only bits skip the fetch stage unless the screen's about to be cleared, then they have to be drawn after it.
+    // If the render stage is too far behind to take them now they go through the fetch stage, which forwards them.
+    uint32_t draw_bits = bits & DRAW_ONLY_BITS;
+    if (draw_bits && !scheduler_is_full_clear(nvs_get_config()->operating_mode, bits)) {
+        scheduler_render_job_t job = {.draw_bits = draw_bits, .standalone = true};
+        if (xQueueSend(render_queue, &job, 0) == pdTRUE) {
+            bits &= ~draw_bits;
+            log_printf(LOG_LEVEL_DEBUG, "Sent render task bits 0x%08X", draw_bits);
+        }
+    }
 
-    // After important work is done, trying to minimize time between notify call and setting bits = 0
-    log_printf(LOG_LEVEL_DEBUG, "Triggered scheduler task with bits 0x%08X", saved_scheduled_bits);
+    if (bits != 0x0) {
+        xTaskNotify(scheduler_task_handle, bits, eSetBits);
+        log_printf(LOG_LEVEL_DEBUG, "Triggered scheduler task with bits 0x%08X", bits);
+    }
 }
 
 void scheduler_schedule_network_check() {
     log_printf(LOG_LEVEL_DEBUG, "Scheduling bit 0x%08X (network check)", CHECK_NETWORK_BIT);
-    scheduled_bits |= CHECK_NETWORK_BIT;
+    scheduled_bits_set(&scheduled_bits, CHECK_NETWORK_BIT);
 }
 
 void scheduler_schedule_time_update() {
     log_printf(LOG_LEVEL_DEBUG, "Scheduling bit 0x%08X (time)", UPDATE_TIME_BIT);
-    scheduled_bits |= UPDATE_TIME_BIT;
+    scheduled_bits_set(&scheduled_bits, UPDATE_TIME_BIT);
 }
 
 void scheduler_schedule_date_update() {
     log_printf(LOG_LEVEL_DEBUG, "Scheduling bit 0x%08X (date)", UPDATE_DATE_BIT);
-    scheduled_bits |= UPDATE_DATE_BIT;
+    scheduled_bits_set(&scheduled_bits, UPDATE_DATE_BIT);
 }
 
 void scheduler_schedule_spot_name_update() {
     log_printf(LOG_LEVEL_DEBUG, "Scheduling bit 0x%08X (spot name)", UPDATE_SPOT_NAME_BIT);
-    scheduled_bits |= UPDATE_SPOT_NAME_BIT;
+    scheduled_bits_set(&scheduled_bits, UPDATE_SPOT_NAME_BIT);
 }
 
 void scheduler_schedule_conditions_update() {
     log_printf(LOG_LEVEL_DEBUG, "Scheduling bit 0x%08X (conditions)", UPDATE_CONDITIONS_BIT);
-    scheduled_bits |= UPDATE_CONDITIONS_BIT;
+    scheduled_bits_set(&scheduled_bits, UPDATE_CONDITIONS_BIT);
 }
 
 void scheduler_schedule_tide_chart_update() {
     log_printf(LOG_LEVEL_DEBUG, "Scheduling bit 0x%08X (tide chart)", UPDATE_TIDE_CHART_BIT);
-    scheduled_bits |= UPDATE_TIDE_CHART_BIT;
+    scheduled_bits_set(&scheduled_bits, UPDATE_TIDE_CHART_BIT);
 }
 
 void scheduler_schedule_swell_chart_update() {
     log_printf(LOG_LEVEL_DEBUG, "Scheduling bit 0x%08X (swell chart)", UPDATE_SWELL_CHART_BIT);
-    scheduled_bits |= UPDATE_SWELL_CHART_BIT;
+    scheduled_bits_set(&scheduled_bits, UPDATE_SWELL_CHART_BIT);
 }
 
 void scheduler_schedule_wind_chart_update() {
     log_printf(LOG_LEVEL_DEBUG, "Scheduling bit 0x%08X (wind chart)", UPDATE_WIND_CHART_BIT);
-    scheduled_bits |= UPDATE_WIND_CHART_BIT;
+    scheduled_bits_set(&scheduled_bits, UPDATE_WIND_CHART_BIT);
 }
 
 void scheduler_schedule_both_charts_update() {
-    uint32_t             chart_bits = 0x0;
-    spot_check_config_t *config     = nvs_get_config();
-
-    if (config->active_chart_1 == SCREEN_IMG_TIDE_CHART || config->active_chart_2 == SCREEN_IMG_TIDE_CHART) {
-        chart_bits |= UPDATE_TIDE_CHART_BIT;
-    }
-
-    if (config->active_chart_1 == SCREEN_IMG_SWELL_CHART || config->active_chart_2 == SCREEN_IMG_SWELL_CHART) {
-        chart_bits |= UPDATE_SWELL_CHART_BIT;
-    }
-
-    if (config->active_chart_1 == SCREEN_IMG_WIND_CHART || config->active_chart_2 == SCREEN_IMG_WIND_CHART) {
-        chart_bits |= UPDATE_WIND_CHART_BIT;
-    }
-
+    uint32_t chart_bits = scheduler_get_active_chart_bits();
     log_printf(LOG_LEVEL_DEBUG, "Scheduling bits 0x%08X (chart 1 and 2)", chart_bits);
-    scheduled_bits |= chart_bits;
+    scheduled_bits_set(&scheduled_bits, chart_bits);
 }
 
 void scheduler_schedule_ota_check() {
     log_printf(LOG_LEVEL_DEBUG, "Scheduling bit 0x%08X (ota)", CHECK_OTA_BIT);
-    scheduled_bits |= CHECK_OTA_BIT;
+    scheduled_bits_set(&scheduled_bits, CHECK_OTA_BIT);
 }
 
 void scheduler_schedule_mflt_upload() {
     log_printf(LOG_LEVEL_DEBUG, "Scheduling bit 0x%08X (memfault)", SEND_MFLT_DATA_BIT);
-    scheduled_bits |= SEND_MFLT_DATA_BIT;
+    scheduled_bits_set(&scheduled_bits, SEND_MFLT_DATA_BIT);
 }
 
 void scheduler_schedule_screen_dirty() {
     log_printf(LOG_LEVEL_DEBUG, "Scheduling bit 0x%08X (mark screen dirty)", MARK_SCREEN_DIRTY_BIT);
-    scheduled_bits |= MARK_SCREEN_DIRTY_BIT;
+    scheduled_bits_set(&scheduled_bits, MARK_SCREEN_DIRTY_BIT);
+}
+
+void scheduler_schedule_forecast_update() {
+    log_printf(LOG_LEVEL_DEBUG, "Scheduling bit 0x%08X (forecast)", UPDATE_FORECAST_BIT);
+    scheduled_bits_set(&scheduled_bits, UPDATE_FORECAST_BIT);
+}
+
+void scheduler_schedule_chart_marker_update() {
+    log_printf(LOG_LEVEL_DEBUG, "Scheduling bit 0x%08X (chart marker)", UPDATE_CHART_MARKER_BIT);
+    scheduled_bits_set(&scheduled_bits, UPDATE_CHART_MARKER_BIT);
 }
 
 void scheduler_schedule_custom_screen_update() {
     log_printf(LOG_LEVEL_DEBUG, "Scheduling bit 0x%08X (custom screen update)", CUSTOM_SCREEN_UPDATE_BIT);
-    scheduled_bits |= CUSTOM_SCREEN_UPDATE_BIT;
+    scheduled_bits_set(&scheduled_bits, CUSTOM_SCREEN_UPDATE_BIT);
 }
 
 scheduler_mode_t scheduler_get_mode() {
@@ -814,6 +1307,7 @@ void scheduler_set_offline_mode() {
     }
 
     scheduler_mode = SCHEDULER_MODE_OFFLINE;
+    scheduler_reschedule();
 }
 
 /*
@@ -841,6 +1335,7 @@ void scheduler_set_ota_mode() {
     }
 
     scheduler_mode = SCHEDULER_MODE_OTA;
+    scheduler_reschedule();
 }
 
 void scheduler_set_online_mode() {
@@ -903,18 +1398,17 @@ void scheduler_set_online_mode() {
             active_operating_mode_matches(config->operating_mode, discrete_updates[i].active_operating_mode);
 
         // If op mode matches and this struct is for a chart, also check against the active chart values in the config
-        if (operating_mode_matches && update_struct_is_chart(i)) {
-            activate_struct = active_chart_matches(config, i);
+        if (operating_mode_matches && discrete_updates[i].chart != SCREEN_IMG_COUNT) {
+            activate_struct = active_chart_matches(config, discrete_updates[i].chart);
         } else {
             activate_struct = operating_mode_matches;
         }
 
         discrete_updates[i].active = activate_struct;
 
-        // Don't force specific discrete updates on activation. Otherwise we'd trigger things like all three swell
-        // updates back to back (and an unnecessary time update but that's a bit less intrusive). Also only worry about
-        // this if the struct was activated in the previous lines, otherwise pointless (1sec callback bails immediately
-        // if not active) and log messages looks funny
+        // Only force the discrete updates flagged for it on activation, the rest wait for their schedule. Also only
+        // worry about this if the struct was activated in the previous lines, otherwise pointless (inactive structs
+        // are never queued) and log messages looks funny
         discrete_updates[i].force_next_update =
             respect_force_flags && activate_struct && discrete_updates[i].force_on_transition_to_online;
         log_printf(LOG_LEVEL_DEBUG,
@@ -925,6 +1419,52 @@ void scheduler_set_online_mode() {
     }
 
     scheduler_mode = SCHEDULER_MODE_ONLINE;
+    scheduler_reschedule();
+}
+
+/*
+ * Recompile the discrete update schedules from the config and reschedule everything with them
+ */
+void scheduler_update_schedules() {
+    if (event_queue_lock == NULL) {
+        return;
+    }
+
+    xSemaphoreTake(event_queue_lock, portMAX_DELAY);
+    scheduler_load_schedules();
+    xSemaphoreGive(event_queue_lock);
+
+    scheduler_reschedule();
+}
+
+/*
+ * Rebuild the event queue from scratch and re-arm the timer. Has to be called after anything that changes which update
+ * structs are active, their force flags or intervals, or the local wall clock time (sntp sync, manual time set,
+ * timezone), since queued fire times were computed from the old values. Safe to call before init, does nothing then.
+ */
+void scheduler_reschedule() {
+    if (event_queue_lock == NULL) {
+        return;
+    }
+
+    xSemaphoreTake(event_queue_lock, portMAX_DELAY);
+    time_t now_epoch_secs = time(NULL);
+    event_queue_len       = 0;
+    for (uint8_t i = 0; i < NUM_DIFFERENTIAL_UPDATES; i++) {
+        scheduler_event_queue_add_update(SCHEDULER_EVENT_DIFFERENTIAL, i, now_epoch_secs);
+    }
+    for (uint8_t i = 0; i < NUM_DISCRETE_UPDATES; i++) {
+        scheduler_event_queue_add_update(SCHEDULER_EVENT_DISCRETE, i, now_epoch_secs);
+    }
+
+    if (event_queue_len > 0) {
+        log_printf(LOG_LEVEL_DEBUG,
+                   "Rescheduled %u update structs, next in %.0f secs",
+                   event_queue_len,
+                   difftime(event_queue[0].fire_epoch_secs, now_epoch_secs));
+    }
+    scheduler_event_timer_arm();
+    xSemaphoreGive(event_queue_lock);
 }
 
 UBaseType_t scheduler_task_get_stack_high_water() {
@@ -932,9 +1472,23 @@ UBaseType_t scheduler_task_get_stack_high_water() {
     return uxTaskGetStackHighWaterMark(scheduler_task_handle);
 }
 
+UBaseType_t scheduler_render_task_get_stack_high_water() {
+    MEMFAULT_ASSERT(render_task_handle);
+    return uxTaskGetStackHighWaterMark(render_task_handle);
+}
+
 void scheduler_task_init() {
-    scheduler_mode = SCHEDULER_MODE_INIT;
-    scheduled_bits = 0x0;
+    scheduled_bits_clear(&scheduled_bits);
+    scheduler_mode   = SCHEDULER_MODE_INIT;
+    event_queue_len  = 0;
+    event_queue_lock = xSemaphoreCreateMutex();
+    MEMFAULT_ASSERT(event_queue_lock);
+    render_queue = xQueueCreate(RENDER_QUEUE_LENGTH, sizeof(scheduler_render_job_t));
+    MEMFAULT_ASSERT(render_queue);
+
+    // Armed for the earliest queued event every time the queue changes. Responsible for triggering any differential or
+    // discrete updates that have reached execution time.
+    event_timer_handle = timer_local_init("scheduler-events", scheduler_event_timer_callback, NULL, MS_PER_SEC);
 }
 
 void scheduler_task_start() {
@@ -952,15 +1506,15 @@ void scheduler_task_start() {
     }
 
     log_printf(LOG_LEVEL_DEBUG, "List of all discrete updates:");
+    scheduler_load_schedules();
     discrete_update_t *discrete_check = NULL;
     for (int i = 0; i < NUM_DISCRETE_UPDATES; i++) {
         discrete_check         = &discrete_updates[i];
         discrete_check->active = false;
         log_printf(LOG_LEVEL_DEBUG,
-                   "'%s' executing at %u:%02u",
+                   "'%s' executing on schedule '%s'",
                    discrete_check->debug_name,
-                   discrete_check->hour,
-                   discrete_check->minute);
+                   discrete_check->schedule_str);
     }
 
     // If we're running in custom mode, set the update_interval_secs field of the custom screen update diff
@@ -984,4 +1538,13 @@ void scheduler_task_start() {
                 NULL,
                 tskIDLE_PRIORITY,
                 &scheduler_task_handle);
+
+    // A notch above the fetch stage so a finished resource is drawn right away, while the fetch stage is blocked on
+    // the next download anyway. Not pinned, so the two run side by side on both cores.
+    xTaskCreate(&scheduler_render_task,
+                "scheduler-render",
+                SPOT_CHECK_MINIMAL_STACK_SIZE_BYTES * 4,
+                NULL,
+                tskIDLE_PRIORITY + 1,
+                &render_task_handle);
 }
@@ -0,0 +1,279 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp32/rom/miniz.h"
+#include "esp_heap_caps.h"
+#include "memfault/panics/assert.h"
+
+#include "constants.h"
+#include "screen_img_decoder.h"
+
+// Must included below constants.h where we overwite the define of LOG_LOCAL_LEVEL
+#include "log.h"
+
+#define TAG SC_TAG_SCREEN_IMG_HANDLER
+
+// Staging buffer for RLE output so the consumer gets reasonably sized chunks instead of single runs
+#define RLE_OUT_BUF_SIZE (1024)
+
+static void screen_img_decoder_emit(screen_img_decoder_t *decoder, const uint8_t *data, size_t size) {
+    if (size == 0) {
+        return;
+    }
+
+    decoder->output_cb(decoder, data, size, decoder->bytes_out);
+    decoder->bytes_out += size;
+}
+
+/*
+ * RLE output goes through out_buf, flushed whenever it's full and at the end of every feed call.
+ */
+static void screen_img_decoder_rle_flush(screen_img_decoder_t *decoder) {
+    screen_img_decoder_emit(decoder, decoder->out_buf, decoder->out_pos);
+    decoder->out_pos = 0;
+}
+
+static void screen_img_decoder_rle_put(screen_img_decoder_t *decoder, const uint8_t *data, uint8_t fill, size_t size) {
+    while (size > 0) {
+        size_t space = MIN(size, RLE_OUT_BUF_SIZE - decoder->out_pos);
+        if (data) {
+            memcpy(decoder->out_buf + decoder->out_pos, data, space);
+            data += space;
+        } else {
+            memset(decoder->out_buf + decoder->out_pos, fill, space);
+        }
+        decoder->out_pos += space;
+        size -= space;
+
+        if (decoder->out_pos == RLE_OUT_BUF_SIZE) {
+            screen_img_decoder_rle_flush(decoder);
+        }
+    }
+}
+
+static bool screen_img_decoder_rle(screen_img_decoder_t *decoder, const uint8_t *data, size_t size) {
+    while (size > 0) {
+        if (decoder->rle_run_length) {
+            screen_img_decoder_rle_put(decoder, NULL, *data, decoder->rle_run_length);
+            decoder->rle_run_length = 0;
+            data++;
+            size--;
+        } else if (decoder->rle_literal_remaining) {
+            size_t literal_len = MIN(size, decoder->rle_literal_remaining);
+            screen_img_decoder_rle_put(decoder, data, 0, literal_len);
+            decoder->rle_literal_remaining -= literal_len;
+            data += literal_len;
+            size -= literal_len;
+        } else {
+            uint8_t control = *data;
+            if (control & 0x80) {
+                decoder->rle_run_length = (control & 0x7F) + 1;
+            } else {
+                decoder->rle_literal_remaining = control + 1;
+            }
+            data++;
+            size--;
+        }
+    }
+
+    screen_img_decoder_rle_flush(decoder);
+    return true;
+}
+
+/*
+ * Inflate into the 32k dictionary ring buffer, handing each newly written section to the consumer before it's
+ * overwritten.
+ */
+static bool screen_img_decoder_inflate(screen_img_decoder_t *decoder, const uint8_t *data, size_t size) {
+    tinfl_decompressor *inflator = (tinfl_decompressor *)decoder->inflator;
+
+    while (!decoder->done) {
+        size_t       in_bytes  = size;
+        size_t       out_bytes = TINFL_LZ_DICT_SIZE - decoder->out_pos;
+        tinfl_status status    = tinfl_decompress(inflator,
+                                               data,
+                                               &in_bytes,
+                                               decoder->out_buf,
+                                               decoder->out_buf + decoder->out_pos,
+                                               &out_bytes,
+                                               TINFL_FLAG_PARSE_ZLIB_HEADER | TINFL_FLAG_HAS_MORE_INPUT);
+        data += in_bytes;
+        size -= in_bytes;
+
+        screen_img_decoder_emit(decoder, decoder->out_buf + decoder->out_pos, out_bytes);
+        decoder->out_pos = (decoder->out_pos + out_bytes) & (TINFL_LZ_DICT_SIZE - 1);
+
+        if (status < TINFL_STATUS_DONE) {
+            log_printf(LOG_LEVEL_ERROR, "Error inflating screen img data, tinfl status %d", status);
+            return false;
+        } else if (status == TINFL_STATUS_DONE) {
+            decoder->done = true;
+        } else if (status == TINFL_STATUS_NEEDS_MORE_INPUT && size == 0) {
+            break;
+        }
+    }
+
+    return true;
+}
+
+static bool screen_img_decoder_decode(screen_img_decoder_t *decoder, const uint8_t *data, size_t size) {
+    bool success = true;
+    switch (decoder->encoding) {
+        case SCREEN_IMG_ENCODING_RAW:
+            screen_img_decoder_emit(decoder, data, size);
+            break;
+        case SCREEN_IMG_ENCODING_RLE:
+            success = screen_img_decoder_rle(decoder, data, size);
+            break;
+        case SCREEN_IMG_ENCODING_ZLIB:
+            success = screen_img_decoder_inflate(decoder, data, size);
+            break;
+        default:
+            MEMFAULT_ASSERT(0);
+    }
+
+    decoder->failed = !success;
+    return success;
+}
+
+/*
+ * Called once the first sizeof(screen_img_header_t) bytes have been received. If they're not a valid header, the image
+ * is legacy raw data and the buffered bytes are passed through as image data.
+ */
+static bool screen_img_decoder_start(screen_img_decoder_t *decoder) {
+    screen_img_header_t header;
+    decoder->has_header = screen_img_decoder_parse_header(decoder->header_buf, decoder->header_len, &header);
+    if (!decoder->has_header) {
+        decoder->encoding = SCREEN_IMG_ENCODING_RAW;
+        screen_img_decoder_emit(decoder, decoder->header_buf, decoder->header_len);
+        return true;
+    }
+
+    decoder->width_px  = header.width_px;
+    decoder->height_px = header.height_px;
+    decoder->encoding  = header.encoding;
+    log_printf(LOG_LEVEL_DEBUG,
+               "Screen img header found, encoding: %u, W: %u, H: %u",
+               header.encoding,
+               header.width_px,
+               header.height_px);
+
+    switch (decoder->encoding) {
+        case SCREEN_IMG_ENCODING_RAW:
+            break;
+        case SCREEN_IMG_ENCODING_RLE:
+            decoder->out_buf = malloc(RLE_OUT_BUF_SIZE);
+            break;
+        case SCREEN_IMG_ENCODING_ZLIB:
+            decoder->inflator = malloc(sizeof(tinfl_decompressor));
+            if (!decoder->inflator) {
+                log_printf(LOG_LEVEL_ERROR, "Malloc of %zu bytes failed for screen img inflator", sizeof(tinfl_decompressor));
+                decoder->failed = true;
+                return false;
+            }
+            tinfl_init((tinfl_decompressor *)decoder->inflator);
+            decoder->out_buf = heap_caps_malloc(TINFL_LZ_DICT_SIZE, MALLOC_CAP_SPIRAM);
+            break;
+        default:
+            MEMFAULT_ASSERT(0);
+    }
+
+    if (decoder->encoding != SCREEN_IMG_ENCODING_RAW && !decoder->out_buf) {
+        log_printf(LOG_LEVEL_ERROR, "Malloc failed for screen img decoder output buffer");
+        decoder->failed = true;
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * Returns true and fills header if data starts with a valid screen img header.
+ */
+bool screen_img_decoder_parse_header(const uint8_t *data, size_t size, screen_img_header_t *header) {
+    if (size < sizeof(screen_img_header_t)) {
+        return false;
+    }
+
+    memcpy(header, data, sizeof(screen_img_header_t));
+    return memcmp(header->magic, SCREEN_IMG_HEADER_MAGIC, SCREEN_IMG_HEADER_MAGIC_LEN) == 0 &&
+           header->encoding < SCREEN_IMG_ENCODING_COUNT && header->width_px > 0 && header->height_px > 0;
+}
+
+/*
+ * Default width and height are used for raw images without a header.
+ */
+bool screen_img_decoder_init(screen_img_decoder_t          *decoder,
+                             uint32_t                       default_width_px,
+                             uint32_t                       default_height_px,
+                             screen_img_decoder_output_cb_t output_cb,
+                             void                          *ctx) {
+    MEMFAULT_ASSERT(decoder);
+    MEMFAULT_ASSERT(output_cb);
+
+    memset(decoder, 0, sizeof(screen_img_decoder_t));
+    decoder->width_px  = default_width_px;
+    decoder->height_px = default_height_px;
+    decoder->encoding  = SCREEN_IMG_ENCODING_RAW;
+    decoder->output_cb = output_cb;
+    decoder->ctx       = ctx;
+    return true;
+}
+
+/*
+ * Feed the next bytes of an encoded image, in any chunk size. Returns false if the data is corrupt, after which all
+ * further data is ignored.
+ */
+bool screen_img_decoder_feed(screen_img_decoder_t *decoder, const uint8_t *data, size_t size) {
+    if (decoder->failed) {
+        return false;
+    }
+
+    if (decoder->header_len < sizeof(screen_img_header_t)) {
+        size_t header_bytes = MIN(size, sizeof(screen_img_header_t) - decoder->header_len);
+        memcpy(decoder->header_buf + decoder->header_len, data, header_bytes);
+        decoder->header_len += header_bytes;
+        data += header_bytes;
+        size -= header_bytes;
+
+        if (decoder->header_len < sizeof(screen_img_header_t)) {
+            return true;
+        }
+
+        if (!screen_img_decoder_start(decoder)) {
+            return false;
+        }
+    }
+
+    return screen_img_decoder_decode(decoder, data, size);
+}
+
+/*
+ * Signal end of input. Returns false if decoding failed at any point or the encoded data was truncated.
+ */
+bool screen_img_decoder_finish(screen_img_decoder_t *decoder) {
+    if (!decoder->failed && decoder->header_len < sizeof(screen_img_header_t)) {
+        // Too short to have a header, must be (a tiny) raw image
+        screen_img_decoder_emit(decoder, decoder->header_buf, decoder->header_len);
+    } else if (!decoder->failed && decoder->encoding == SCREEN_IMG_ENCODING_ZLIB && !decoder->done) {
+        log_printf(LOG_LEVEL_ERROR, "Screen img zlib stream ended before end of data");
+        decoder->failed = true;
+    } else if (!decoder->failed && decoder->encoding == SCREEN_IMG_ENCODING_RLE &&
+               (decoder->rle_literal_remaining || decoder->rle_run_length)) {
+        log_printf(LOG_LEVEL_ERROR, "Screen img RLE data ended in the middle of a run");
+        decoder->failed = true;
+    }
+
+    return !decoder->failed;
+}
+
+void screen_img_decoder_deinit(screen_img_decoder_t *decoder) {
+    if (decoder->inflator) {
+        free(decoder->inflator);
+        decoder->inflator = NULL;
+    }
+    if (decoder->out_buf) {
+        free(decoder->out_buf);
+        decoder->out_buf = NULL;
+    }
+}
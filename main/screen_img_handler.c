@@ -5,13 +5,16 @@
 #include "memfault/panics/assert.h"
 #include "spi_flash_mmap.h"
 
+#include "chart.h"
 #include "constants.h"
 #include "display.h"
 #include "flash_partition.h"
 #include "http_client.h"
+#include "http_queue.h"
 #include "json.h"
 #include "log.h"
 #include "nvs.h"
+#include "screen_img_decoder.h"
 #include "screen_img_handler.h"
 #include "spot_check.h"
 
@@ -20,55 +23,96 @@
 #define WEATHER_CHART_X_COORD (50)
 #define WEATHER_CHART_1_Y_COORD_PX (190)  // make sure this doesn't run into the lowest conditions render line
 #define WEATHER_CHART_2_Y_COORD_PX (400)  // keep this at 400 to separate top axis title and bottom main title by 10px
+#define WEATHER_CHART_MAX_WIDTH_PX (700)
+#define WEATHER_CHART_MAX_HEIGHT_PX (200)
+#define SCREEN_IMG_MAX_WIDTH_PX (800)
+#define SCREEN_IMG_MAX_HEIGHT_PX (600)
 
+// Commit record saved in NVS as a single blob, see SCREEN_IMG_*_RECORD_NVS_KEY
 typedef struct {
-    screen_img_t screen_img;
-    char        *screen_img_size_key;
-    char        *screen_img_width_key;
-    char        *screen_img_height_key;
-    uint32_t     screen_img_offset;
-    uint32_t     screen_img_size;
-    uint32_t     screen_img_width;
-    uint32_t     screen_img_height;
-    char        *endpoint;
+    uint32_t         slot;
+    uint32_t         size;
+    uint32_t         width_px;
+    uint32_t         height_px;
+    http_validator_t validator;  // cache validators the server sent with the image in this slot
+} screen_img_record_t;
+
+typedef struct {
+    screen_img_t     screen_img;
+    char            *screen_img_record_key;
+    char            *screen_img_size_key;
+    char            *screen_img_width_key;
+    char            *screen_img_height_key;
+    uint32_t         screen_img_slot_offsets[2];
+    uint32_t         screen_img_slot_size;
+    uint32_t         screen_img_active_slot;
+    uint32_t         screen_img_offset;  // offset of the active slot
+    uint32_t         screen_img_size;
+    uint32_t         screen_img_width;
+    uint32_t         screen_img_height;
+    http_validator_t validator;  // sent back as If-None-Match/If-Modified-Since, empty if not known
+    char            *endpoint;
 } screen_img_metadata_t;
 
+// Where a screen_img being decoded into the framebuffer is drawn, either from flash or while downloading
+typedef struct {
+    uint32_t             x;
+    uint32_t             y;
+    uint32_t             max_width;
+    uint32_t             max_height;
+    bool                 clear_area;  // clear max area before drawing the first data, then reset
+    size_t               bytes_drawn;
+    screen_img_decoder_t decoder;
+} screen_img_stream_ctx_t;
+
 static void screen_img_handler_get_metadata(screen_img_t screen_img, screen_img_metadata_t *metadata) {
     switch (screen_img) {
         case SCREEN_IMG_TIDE_CHART:
-            metadata->screen_img_size_key   = SCREEN_IMG_TIDE_CHART_SIZE_NVS_KEY;
-            metadata->screen_img_width_key  = SCREEN_IMG_TIDE_CHART_WIDTH_PX_NVS_KEY;
-            metadata->screen_img_height_key = SCREEN_IMG_TIDE_CHART_HEIGHT_PX_NVS_KEY;
-            metadata->screen_img_offset     = SCREEN_IMG_TIDE_CHART_OFFSET;
-            metadata->screen_img_width      = 700;
-            metadata->screen_img_height     = 200;
-            metadata->endpoint              = "tides_chart";
+            metadata->screen_img_record_key      = SCREEN_IMG_TIDE_CHART_RECORD_NVS_KEY;
+            metadata->screen_img_size_key        = SCREEN_IMG_TIDE_CHART_SIZE_NVS_KEY;
+            metadata->screen_img_width_key       = SCREEN_IMG_TIDE_CHART_WIDTH_PX_NVS_KEY;
+            metadata->screen_img_height_key      = SCREEN_IMG_TIDE_CHART_HEIGHT_PX_NVS_KEY;
+            metadata->screen_img_slot_offsets[0] = SCREEN_IMG_TIDE_CHART_OFFSET;
+            metadata->screen_img_slot_offsets[1] = SCREEN_IMG_TIDE_CHART_SLOT_B_OFFSET;
+            metadata->screen_img_slot_size       = SCREEN_IMG_CHART_SLOT_SIZE;
+            metadata->screen_img_width           = 700;
+            metadata->screen_img_height          = 200;
+            metadata->endpoint                   = "tides_chart";
             break;
         case SCREEN_IMG_SWELL_CHART:
-            metadata->screen_img_size_key   = SCREEN_IMG_SWELL_CHART_SIZE_NVS_KEY;
-            metadata->screen_img_width_key  = SCREEN_IMG_SWELL_CHART_WIDTH_PX_NVS_KEY;
-            metadata->screen_img_height_key = SCREEN_IMG_SWELL_CHART_HEIGHT_PX_NVS_KEY;
-            metadata->screen_img_offset     = SCREEN_IMG_SWELL_CHART_OFFSET;
-            metadata->screen_img_width      = 700;
-            metadata->screen_img_height     = 200;
-            metadata->endpoint              = "swell_chart";
+            metadata->screen_img_record_key      = SCREEN_IMG_SWELL_CHART_RECORD_NVS_KEY;
+            metadata->screen_img_size_key        = SCREEN_IMG_SWELL_CHART_SIZE_NVS_KEY;
+            metadata->screen_img_width_key       = SCREEN_IMG_SWELL_CHART_WIDTH_PX_NVS_KEY;
+            metadata->screen_img_height_key      = SCREEN_IMG_SWELL_CHART_HEIGHT_PX_NVS_KEY;
+            metadata->screen_img_slot_offsets[0] = SCREEN_IMG_SWELL_CHART_OFFSET;
+            metadata->screen_img_slot_offsets[1] = SCREEN_IMG_SWELL_CHART_SLOT_B_OFFSET;
+            metadata->screen_img_slot_size       = SCREEN_IMG_CHART_SLOT_SIZE;
+            metadata->screen_img_width           = 700;
+            metadata->screen_img_height          = 200;
+            metadata->endpoint                   = "swell_chart";
             break;
         case SCREEN_IMG_WIND_CHART:
-            metadata->screen_img_size_key   = SCREEN_IMG_WIND_CHART_SIZE_NVS_KEY;
-            metadata->screen_img_width_key  = SCREEN_IMG_WIND_CHART_WIDTH_PX_NVS_KEY;
-            metadata->screen_img_height_key = SCREEN_IMG_WIND_CHART_HEIGHT_PX_NVS_KEY;
-            metadata->screen_img_offset     = SCREEN_IMG_WIND_CHART_OFFSET;
-            metadata->screen_img_width      = 700;
-            metadata->screen_img_height     = 200;
-            metadata->endpoint              = "wind_chart";
+            metadata->screen_img_record_key      = SCREEN_IMG_WIND_CHART_RECORD_NVS_KEY;
+            metadata->screen_img_size_key        = SCREEN_IMG_WIND_CHART_SIZE_NVS_KEY;
+            metadata->screen_img_width_key       = SCREEN_IMG_WIND_CHART_WIDTH_PX_NVS_KEY;
+            metadata->screen_img_height_key      = SCREEN_IMG_WIND_CHART_HEIGHT_PX_NVS_KEY;
+            metadata->screen_img_slot_offsets[0] = SCREEN_IMG_WIND_CHART_OFFSET;
+            metadata->screen_img_slot_offsets[1] = SCREEN_IMG_WIND_CHART_SLOT_B_OFFSET;
+            metadata->screen_img_slot_size       = SCREEN_IMG_CHART_SLOT_SIZE;
+            metadata->screen_img_width           = 700;
+            metadata->screen_img_height          = 200;
+            metadata->endpoint                   = "wind_chart";
             break;
         case SCREEN_IMG_CUSTOM_SCREEN:
-            metadata->screen_img_size_key   = SCREEN_IMG_CUSTOM_SCREEN_SIZE_NVS_KEY;
-            metadata->screen_img_width_key  = SCREEN_IMG_CUSTOM_SCREEN_WIDTH_PX_NVS_KEY;
-            metadata->screen_img_height_key = SCREEN_IMG_CUSTOM_SCREEN_HEIGHT_PX_NVS_KEY;
-            metadata->screen_img_offset     = SCREEN_IMG_CUSTOM_SCREEN_OFFSET;
-            metadata->screen_img_width      = 800;
-            metadata->screen_img_height     = 600;
+            metadata->screen_img_record_key      = SCREEN_IMG_CUSTOM_SCREEN_RECORD_NVS_KEY;
+            metadata->screen_img_size_key        = SCREEN_IMG_CUSTOM_SCREEN_SIZE_NVS_KEY;
+            metadata->screen_img_width_key       = SCREEN_IMG_CUSTOM_SCREEN_WIDTH_PX_NVS_KEY;
+            metadata->screen_img_height_key      = SCREEN_IMG_CUSTOM_SCREEN_HEIGHT_PX_NVS_KEY;
+            metadata->screen_img_slot_offsets[0] = SCREEN_IMG_CUSTOM_SCREEN_OFFSET;
+            metadata->screen_img_slot_offsets[1] = SCREEN_IMG_CUSTOM_SCREEN_SLOT_B_OFFSET;
+            metadata->screen_img_slot_size       = SCREEN_IMG_CUSTOM_SCREEN_SLOT_SIZE;
+            metadata->screen_img_width           = 800;
+            metadata->screen_img_height          = 600;
 
             // Making an assumption this will never be called before nvs is inited and loaded into mem
             spot_check_config_t *config = nvs_get_config();
@@ -78,6 +122,24 @@ static void screen_img_handler_get_metadata(screen_img_t screen_img, screen_img_
             MEMFAULT_ASSERT(0);
     }
 
+    screen_img_record_t record      = {0};
+    size_t              record_size = sizeof(record);
+    if (nvs_get_bytes(metadata->screen_img_record_key, &record, &record_size) &&
+        record_size >= offsetof(screen_img_record_t, validator) &&
+        record.slot < 2) {
+        metadata->screen_img_active_slot = record.slot;
+        metadata->screen_img_size        = record.size;
+        metadata->screen_img_width       = record.width_px;
+        metadata->screen_img_height      = record.height_px;
+        metadata->screen_img_offset      = metadata->screen_img_slot_offsets[record.slot];
+        memcpy(&metadata->validator, &record.validator, sizeof(http_validator_t));
+        return;
+    }
+
+    // No commit record, fall back to the keys saved by firmware from before A/B slots which always used slot A
+    metadata->screen_img_active_slot = 0;
+    metadata->screen_img_offset      = metadata->screen_img_slot_offsets[0];
+
     bool success = nvs_get_uint32(metadata->screen_img_size_key, &metadata->screen_img_size, 0);
     if (!success) {
         log_printf(LOG_LEVEL_WARN, "No screen img size value stored in NVS, setting to zero");
@@ -103,63 +165,176 @@ static void screen_img_handler_get_metadata(screen_img_t screen_img, screen_img_
     }
 }
 static void screen_img_handler_log_metadata(screen_img_metadata_t *metadata) {
-    log_printf(LOG_LEVEL_DEBUG, "SCREEN IMG HANDLER METADATA:");
-    log_printf(LOG_LEVEL_DEBUG, "  %s: %lu", metadata->screen_img_size_key, metadata->screen_img_size);
-    log_printf(LOG_LEVEL_DEBUG, "  %s: %lu", metadata->screen_img_width_key, metadata->screen_img_width);
-    log_printf(LOG_LEVEL_DEBUG, "  %s: %lu", metadata->screen_img_height_key, metadata->screen_img_height);
+    log_printf(LOG_LEVEL_DEBUG, "SCREEN IMG HANDLER METADATA (%s):", metadata->screen_img_record_key);
+    log_printf(LOG_LEVEL_DEBUG, "  size: %lu", metadata->screen_img_size);
+    log_printf(LOG_LEVEL_DEBUG, "  width: %lu", metadata->screen_img_width);
+    log_printf(LOG_LEVEL_DEBUG, "  height: %lu", metadata->screen_img_height);
+    log_printf(LOG_LEVEL_DEBUG, "  slot: %lu", metadata->screen_img_active_slot);
     log_printf(LOG_LEVEL_DEBUG, "  offset: %lu", metadata->screen_img_offset);
 }
 
 /*
- * Finished process of saving a screen_img to the proper location in the flash partition. Request must have been built
- * and sent with http_client_build_request and http_client_perform_with_retries already.
+ * Start a writer into the inactive slot, with the active slot as reference so identical data isn't rewritten.
  */
-static int screen_img_handler_save(esp_http_client_handle_t *client,
-                                   screen_img_t              screen_img,
-                                   screen_img_metadata_t    *metadata,
-                                   int                       content_length) {
-    const esp_partition_t *part = flash_partition_get_screen_img_partition();
-
-    // Erase only the size of the image currently stored (internal spi flash functions will erase to page
-    // boundary automatically)
+static esp_err_t screen_img_handler_start_writer(screen_img_metadata_t *metadata, flash_partition_writer_t *writer) {
+    const esp_partition_t *part        = flash_partition_get_screen_img_partition();
+    uint32_t               target_slot = !metadata->screen_img_active_slot;
+
+    esp_err_t err = flash_partition_writer_start(writer,
+                                                 part,
+                                                 metadata->screen_img_slot_offsets[target_slot],
+                                                 metadata->screen_img_slot_size);
+    if (err != ESP_OK) {
+        return err;
+    }
+
     if (metadata->screen_img_size) {
-        uint32_t alignment_remainder = metadata->screen_img_size % 4096;
-        uint32_t size_to_erase =
-            alignment_remainder ? (metadata->screen_img_size + (4096 - alignment_remainder)) : metadata->screen_img;
-
-        esp_err_t err = esp_partition_erase_range(part, metadata->screen_img_offset, size_to_erase);
-        if (err != ESP_OK) {
-            log_printf(LOG_LEVEL_ERROR, "Error erasing partition range: %s", esp_err_to_name(err));
-            return 0;
-        }
+        flash_partition_writer_set_reference(writer, metadata->screen_img_offset, metadata->screen_img_size);
+    }
 
-        nvs_set_uint32(metadata->screen_img_size_key, 0);
-        nvs_set_uint32(metadata->screen_img_width_key, 0);
-        nvs_set_uint32(metadata->screen_img_height_key, 0);
-        log_printf(LOG_LEVEL_DEBUG, "Erased %u bytes from %u screen_img_t", size_to_erase, screen_img);
-    } else {
-        log_printf(LOG_LEVEL_DEBUG,
-                   "%s NVS key had zero value, not erasing any of screen img partition",
-                   metadata->screen_img_size_key);
+    return ESP_OK;
+}
+
+/*
+ * Send the request through the http queue and write the response into the inactive slot in the flash partition. The
+ * active slot and NVS are not touched, screen_img_handler_commit must be called to switch to the new image. Returns
+ * success, with the bytes saved through bytes_saved. That's zero if the request was answered with a 304. If the
+ * downloaded image is byte for byte the same as the active one, nothing is written to flash and unchanged is set.
+ */
+static bool screen_img_handler_save(http_request_t        *req,
+                                    screen_img_metadata_t *metadata,
+                                    http_client_chunk_cb_t chunk_cb,
+                                    void                  *chunk_cb_ctx,
+                                    size_t                *bytes_saved,
+                                    bool                  *unchanged) {
+    uint32_t target_slot = !metadata->screen_img_active_slot;
+    *bytes_saved         = 0;
+
+    // The response is read out on the queue task, so the writer has to be ready before the request is queued. Nothing
+    // is erased until data arrives, a 304 or failed request costs no flash ops.
+    flash_partition_writer_t writer;
+    esp_err_t                err = screen_img_handler_start_writer(metadata, &writer);
+    if (err != ESP_OK) {
+        return false;
     }
 
-    size_t    bytes_saved = 0;
-    esp_err_t err         = http_client_read_response_to_flash(client,
-                                                       content_length,
-                                                       (esp_partition_t *)part,
-                                                       metadata->screen_img_offset,
-                                                       &bytes_saved);
-    if (err == ESP_OK && bytes_saved > 0) {
-        // Save metadata as last action to make sure all steps have succeeded and there's a valid image in
-        // flash
-        nvs_set_uint32(metadata->screen_img_size_key, bytes_saved);
-        nvs_set_uint32(metadata->screen_img_width_key, metadata->screen_img_width);
-        nvs_set_uint32(metadata->screen_img_height_key, metadata->screen_img_height);
-
-        log_printf(LOG_LEVEL_INFO, "Saved %u bytes to screen_img flash partition at 0x%X offset", bytes_saved, 0);
-    }
-
-    return bytes_saved;
+    http_queue_req_t queue_req = {
+        .request            = req,
+        .additional_retries = 1,
+        .sink               = HTTP_QUEUE_SINK_FLASH,
+        .flash =
+            {
+                .writer       = &writer,
+                .chunk_cb     = chunk_cb,
+                .chunk_cb_ctx = chunk_cb_ctx,
+            },
+    };
+    bool success = http_queue_run(&queue_req, HTTP_QUEUE_PRIORITY_HIGH);
+
+    esp_err_t writer_err = flash_partition_writer_finish(&writer, bytes_saved, unchanged);
+    if (!success) {
+        log_printf(LOG_LEVEL_ERROR, "Error making request, aborting");
+        *unchanged = false;
+        return false;
+    }
+
+    if (req->get_args.not_modified) {
+        *bytes_saved = 0;
+        *unchanged   = false;
+        return true;
+    }
+
+    if (writer_err != ESP_OK || *bytes_saved == 0) {
+        log_printf(LOG_LEVEL_ERROR,
+                   "Failed saving screen img to slot %lu, keeping image in slot %lu",
+                   target_slot,
+                   metadata->screen_img_active_slot);
+        *unchanged = false;
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * Record slot as the active one with a single NVS write, so there's always either the old or the new image recorded
+ * as valid. Used to flip to the slot screen_img_handler_save just wrote, or to refresh the validator of the active one.
+ */
+static bool screen_img_handler_commit(screen_img_metadata_t  *metadata,
+                                      uint32_t                slot,
+                                      size_t                  bytes_saved,
+                                      const http_validator_t *validator) {
+    const esp_partition_t *part        = flash_partition_get_screen_img_partition();
+    uint32_t               slot_offset = metadata->screen_img_slot_offsets[slot];
+
+    screen_img_record_t record = {
+        .slot      = slot,
+        .size      = bytes_saved,
+        .width_px  = metadata->screen_img_width,
+        .height_px = metadata->screen_img_height,
+    };
+    memcpy(&record.validator, validator, sizeof(http_validator_t));
+
+    // Encoded images carry their own dimensions, store those instead of the defaults so clearing the image later
+    // covers the right area
+    screen_img_header_t header;
+    uint8_t             header_buf[sizeof(screen_img_header_t)];
+    if (bytes_saved >= sizeof(header_buf) &&
+        esp_partition_read(part, slot_offset, header_buf, sizeof(header_buf)) == ESP_OK &&
+        screen_img_decoder_parse_header(header_buf, sizeof(header_buf), &header)) {
+        record.width_px  = header.width_px;
+        record.height_px = header.height_px;
+    }
+
+    if (!nvs_set_bytes(metadata->screen_img_record_key, &record, sizeof(record))) {
+        return false;
+    }
+
+    metadata->screen_img_active_slot = slot;
+    metadata->screen_img_offset      = slot_offset;
+    metadata->screen_img_size        = record.size;
+    metadata->screen_img_width       = record.width_px;
+    metadata->screen_img_height      = record.height_px;
+    memcpy(&metadata->validator, validator, sizeof(http_validator_t));
+
+    log_printf(LOG_LEVEL_INFO,
+               "Committed %u byte image in screen_img flash partition slot %lu at 0x%X offset",
+               bytes_saved,
+               slot,
+               slot_offset);
+    return true;
+}
+
+/*
+ * The custom screen's slots overlap the charts' slots since they're never used together. Before writing one kind, drop
+ * the records of the other so a stale record (and its validator) can never claim data that's been overwritten. Records
+ * that are already empty aren't rewritten to save NVS wear.
+ */
+static void screen_img_handler_invalidate_overlapping(screen_img_t screen_img) {
+    char *chart_record_keys[] = {
+        SCREEN_IMG_TIDE_CHART_RECORD_NVS_KEY,
+        SCREEN_IMG_SWELL_CHART_RECORD_NVS_KEY,
+        SCREEN_IMG_WIND_CHART_RECORD_NVS_KEY,
+    };
+    char  *custom_record_keys[] = {SCREEN_IMG_CUSTOM_SCREEN_RECORD_NVS_KEY};
+    char **keys                 = chart_record_keys;
+    size_t num_keys             = sizeof(chart_record_keys) / sizeof(chart_record_keys[0]);
+    if (screen_img != SCREEN_IMG_CUSTOM_SCREEN) {
+        keys     = custom_record_keys;
+        num_keys = sizeof(custom_record_keys) / sizeof(custom_record_keys[0]);
+    }
+
+    for (size_t i = 0; i < num_keys; i++) {
+        screen_img_record_t record      = {0};
+        size_t              record_size = sizeof(record);
+        if (nvs_get_bytes(keys[i], &record, &record_size) && record.size == 0) {
+            continue;
+        }
+
+        memset(&record, 0, sizeof(record));
+        nvs_set_bytes(keys[i], &record, sizeof(record));
+        log_printf(LOG_LEVEL_DEBUG, "Invalidated overlapping screen img record %s", keys[i]);
+    }
 }
 
 /*
@@ -181,15 +356,49 @@ static uint32_t screen_img_handler_get_y_for_chart(screen_img_t screen_img) {
     return y;
 }
 
+/*
+ * screen_img_decoder output callback, draws decoded data into the framebuffer at the location in the stream ctx
+ */
+static void screen_img_handler_draw_decoded(screen_img_decoder_t *decoder,
+                                            const uint8_t        *data,
+                                            size_t                size,
+                                            size_t                offset) {
+    screen_img_stream_ctx_t *stream = (screen_img_stream_ctx_t *)decoder->ctx;
+
+    // Don't trust dimensions from a header to stay inside the area reserved for this image
+    if (decoder->width_px > stream->max_width || decoder->height_px > stream->max_height) {
+        if (offset == 0) {
+            log_printf(LOG_LEVEL_ERROR,
+                       "Screen img dimensions %lu x %lu larger than max %lu x %lu, not drawing",
+                       decoder->width_px,
+                       decoder->height_px,
+                       stream->max_width,
+                       stream->max_height);
+        }
+        return;
+    }
+
+    if (stream->clear_area) {
+        display_clear_area(stream->x, stream->y, stream->max_width, stream->max_height);
+        stream->clear_area = false;
+    }
+
+    display_draw_image_chunk(data, size, offset, decoder->width_px, decoder->height_px, stream->x, stream->y);
+    stream->bytes_drawn += size;
+}
+
 /*
  * Static function to hold to shared logic of drawing either a chart or any other screen image to the screen. The args
- * are calculated differently for the two cases, then passed into a call for this func.
+ * are calculated differently for the two cases, then passed into a call for this func. Images with a
+ * screen_img_header_t are decoded straight into the framebuffer, legacy raw images are drawn directly.
  */
 static void screen_img_handler_retrieve_and_render(uint32_t x,
                                                    uint32_t y,
                                                    size_t   size,
                                                    size_t   width,
                                                    size_t   height,
+                                                   size_t   max_width,
+                                                   size_t   max_height,
                                                    size_t   nvs_address_offset) {
     // TODO :: make sure screen_img_len length is less that buffer size (or at least a reasonable number to
     // malloc) mmap handles the large malloc internally, and the call the munmap below frees it
@@ -202,7 +411,23 @@ static void screen_img_handler_retrieve_and_render(uint32_t x,
                        SPI_FLASH_MMAP_DATA,
                        (const void **)&mapped_flash,
                        &spi_flash_handle);
-    display_draw_image((uint8_t *)mapped_flash, width, height, 1, x, y);
+    screen_img_header_t header;
+    if (screen_img_decoder_parse_header(mapped_flash, size, &header)) {
+        screen_img_stream_ctx_t stream = {
+            .x          = x,
+            .y          = y,
+            .max_width  = max_width,
+            .max_height = max_height,
+        };
+        screen_img_decoder_init(&stream.decoder, width, height, screen_img_handler_draw_decoded, &stream);
+        screen_img_decoder_feed(&stream.decoder, mapped_flash, size);
+        if (!screen_img_decoder_finish(&stream.decoder)) {
+            log_printf(LOG_LEVEL_ERROR, "Error decoding screen img from flash, drew %u bytes", stream.bytes_drawn);
+        }
+        screen_img_decoder_deinit(&stream.decoder);
+    } else {
+        display_draw_image((uint8_t *)mapped_flash, width, height, 1, x, y);
+    }
     spi_flash_munmap(spi_flash_handle);
 
     log_printf(LOG_LEVEL_INFO,
@@ -214,6 +439,15 @@ static void screen_img_handler_retrieve_and_render(uint32_t x,
                height);
 }
 
+/*
+ * http_client chunk callback to draw a screen_img into the framebuffer while it's being saved to flash
+ */
+static void screen_img_handler_render_chunk(const uint8_t *chunk, size_t chunk_size, size_t offset, void *ctx) {
+    (void)offset;
+    screen_img_stream_ctx_t *stream = (screen_img_stream_ctx_t *)ctx;
+    screen_img_decoder_feed(&stream->decoder, chunk, chunk_size);
+}
+
 void screen_img_handler_init() {
 }
 
@@ -260,6 +494,8 @@ bool screen_img_handler_draw_screen_img(screen_img_t screen_img) {
                                            metadata.screen_img_size,
                                            metadata.screen_img_width,
                                            metadata.screen_img_height,
+                                           SCREEN_IMG_MAX_WIDTH_PX,
+                                           SCREEN_IMG_MAX_HEIGHT_PX,
                                            metadata.screen_img_offset);
     return true;
 }
@@ -283,11 +519,73 @@ bool screen_img_handler_draw_chart(screen_img_t screen_img) {
                                            metadata.screen_img_size,
                                            metadata.screen_img_width,
                                            metadata.screen_img_height,
+                                           WEATHER_CHART_MAX_WIDTH_PX,
+                                           WEATHER_CHART_MAX_HEIGHT_PX,
                                            metadata.screen_img_offset);
     return true;
 }
 
-bool screen_img_handler_download_and_save(screen_img_t screen_img) {
+/*
+ * Blank out the chart area with blank_area if it's not NULL, then draw the chart rasterized from the forecast series.
+ */
+static bool screen_img_handler_draw_forecast_chart_over(screen_img_t      screen_img,
+                                                        const forecast_t *forecast,
+                                                        void (*blank_area)(uint32_t, uint32_t, uint32_t, uint32_t)) {
+    chart_series_t series;
+    switch (screen_img) {
+        case SCREEN_IMG_TIDE_CHART:
+            series = CHART_SERIES_TIDE;
+            break;
+        case SCREEN_IMG_SWELL_CHART:
+            series = CHART_SERIES_SWELL;
+            break;
+        case SCREEN_IMG_WIND_CHART:
+            series = CHART_SERIES_WIND;
+            break;
+        default:
+            MEMFAULT_ASSERT(0);
+    }
+
+    if (!chart_can_draw(forecast)) {
+        return false;
+    }
+
+    uint32_t y = screen_img_handler_get_y_for_chart(screen_img);
+    if (blank_area) {
+        blank_area(WEATHER_CHART_X_COORD, y, WEATHER_CHART_MAX_WIDTH_PX, WEATHER_CHART_MAX_HEIGHT_PX);
+    }
+
+    time_t now = 0;
+    time(&now);
+    chart_draw(series, forecast, now, WEATHER_CHART_X_COORD, y);
+    return true;
+}
+
+/*
+ * Draw a chart rasterized from the forecast series in place of the downloaded image, see chart_draw. The whole chart
+ * area is cleared first if clear_area is set, there may not be a downloaded image whose size says what to clear.
+ */
+bool screen_img_handler_draw_forecast_chart(screen_img_t screen_img, const forecast_t *forecast, bool clear_area) {
+    return screen_img_handler_draw_forecast_chart_over(screen_img, forecast, clear_area ? display_clear_area : NULL);
+}
+
+/*
+ * Redraw a chart drawn by screen_img_handler_draw_forecast_chart from the same forecast, to move its time marker. The
+ * area is only whitened in the framebuffer rather than cleared, so the next render just drives the columns the marker
+ * left and moved to instead of the whole chart.
+ */
+bool screen_img_handler_redraw_forecast_chart(screen_img_t screen_img, const forecast_t *forecast) {
+    return screen_img_handler_draw_forecast_chart_over(screen_img, forecast, display_erase_area);
+}
+
+/*
+ * Shared logic for downloading a screen_img to flash. If stream is not NULL, the image is also drawn into the
+ * framebuffer at the location it describes as it's received. The request is conditional on the validators stored with
+ * the active image, unchanged is set if the server answered 304 or sent the same bytes again, in which case the active
+ * slot is kept. Same bytes that were already drawn while streaming don't count as unchanged, the area was cleared and
+ * has to be rendered.
+ */
+static bool screen_img_handler_download(screen_img_t screen_img, screen_img_stream_ctx_t *stream, bool *unchanged) {
     screen_img_metadata_t metadata = {0};
     screen_img_handler_get_metadata(screen_img, &metadata);
     screen_img_handler_log_metadata(&metadata);
@@ -306,19 +604,189 @@ bool screen_img_handler_download_and_save(screen_img_t screen_img) {
         req = http_client_build_get_request(metadata.endpoint, config, url, params, num_params);
     }
 
-    esp_http_client_handle_t client;
-    int                      content_length = 0;
-    success                                 = http_client_perform_with_retries(&req, 1, &client, &content_length);
-    if (!success) {
-        log_printf(LOG_LEVEL_ERROR, "Error making request, aborting");
-        return false;
+    // Only worth asking if there's an image to fall back on
+    if (metadata.screen_img_size > 0) {
+        req.get_args.validator = &metadata.validator;
+    }
+
+    *unchanged = false;
+
+    // The response is saved and decoded on the http queue task as it arrives, so this all has to be ready before the
+    // request is queued
+    screen_img_handler_invalidate_overlapping(screen_img);
+    if (stream) {
+        screen_img_decoder_init(&stream->decoder,
+                                metadata.screen_img_width,
+                                metadata.screen_img_height,
+                                screen_img_handler_draw_decoded,
+                                stream);
+    }
+
+    size_t bytes_saved = 0;
+    success            = screen_img_handler_save(&req,
+                                                 &metadata,
+                                                 stream ? screen_img_handler_render_chunk : NULL,
+                                                 stream,
+                                                 &bytes_saved,
+                                                 unchanged);
+    if (stream) {
+        // Check before committing so a corrupt image never becomes the active one
+        if (success && bytes_saved > 0 && !screen_img_decoder_finish(&stream->decoder)) {
+            log_printf(LOG_LEVEL_ERROR, "Error decoding screen img while downloading");
+            success = false;
+        }
+        screen_img_decoder_deinit(&stream->decoder);
     }
 
-    success = screen_img_handler_save(&client, screen_img, &metadata, content_length);
     if (!success) {
         log_printf(LOG_LEVEL_ERROR, "Error saving screen img");
+        *unchanged = false;
         return false;
     }
 
+    if (req.get_args.not_modified) {
+        log_printf(LOG_LEVEL_INFO, "Screen img %u not modified on server, keeping stored image", screen_img);
+        *unchanged = true;
+        return true;
+    }
+
+    if (*unchanged) {
+        // Server may not support conditional requests, or rotated its validators without changing the image. Only
+        // touch NVS if there's something new to send next time.
+        if (memcmp(&metadata.validator, &req.get_args.response_validator, sizeof(http_validator_t)) != 0) {
+            screen_img_handler_commit(&metadata,
+                                      metadata.screen_img_active_slot,
+                                      metadata.screen_img_size,
+                                      &req.get_args.response_validator);
+        }
+        log_printf(LOG_LEVEL_INFO,
+                   "Downloaded screen img %u identical to stored image, left flash untouched",
+                   screen_img);
+        if (stream && stream->bytes_drawn > 0) {
+            // Otherwise the caller skips rendering and the pending clear of the area flashes with the next render
+            *unchanged = false;
+        }
+        return true;
+    }
+
+    return screen_img_handler_commit(&metadata,
+                                     !metadata.screen_img_active_slot,
+                                     bytes_saved,
+                                     &req.get_args.response_validator);
+}
+
+/*
+ * Download a screen_img to flash without drawing it. Unchanged is set if the stored image is still current, in which
+ * case it doesn't need to be redrawn.
+ */
+bool screen_img_handler_download_and_save(screen_img_t screen_img, bool *unchanged) {
+    return screen_img_handler_download(screen_img, NULL, unchanged);
+}
+
+/*
+ * Start saving an image that arrives as part of a larger response instead of its own request (see batch_fetch). Same
+ * A/B handling as a download, the data goes into the inactive slot and only becomes the active image in
+ * screen_img_handler_save_finish. Any validators stored for the image are dropped when it changes since the response
+ * doesn't carry them per image.
+ */
+bool screen_img_handler_save_start(screen_img_t screen_img, screen_img_save_ctx_t *ctx) {
+    screen_img_metadata_t metadata = {0};
+    screen_img_handler_get_metadata(screen_img, &metadata);
+
+    memset(ctx, 0, sizeof(screen_img_save_ctx_t));
+    ctx->screen_img = screen_img;
+
+    screen_img_handler_invalidate_overlapping(screen_img);
+    ctx->started = screen_img_handler_start_writer(&metadata, &ctx->writer) == ESP_OK;
+    ctx->failed  = !ctx->started;
+    return ctx->started;
+}
+
+bool screen_img_handler_save_write(screen_img_save_ctx_t *ctx, const uint8_t *data, size_t size) {
+    if (ctx->failed) {
+        return false;
+    }
+
+    ctx->failed = flash_partition_writer_write(&ctx->writer, data, size) != ESP_OK;
+    return !ctx->failed;
+}
+
+/*
+ * Wait for the data to be in flash and make it the active image. Must be called for every successful
+ * screen_img_handler_save_start. Pass complete as false if the image data was cut off to just free the writer and keep
+ * the previous image.
+ */
+bool screen_img_handler_save_finish(screen_img_save_ctx_t *ctx, bool complete, bool *unchanged) {
+    *unchanged = false;
+    if (!ctx->started) {
+        return false;
+    }
+
+    size_t    bytes_saved = 0;
+    bool      same        = false;
+    esp_err_t err         = flash_partition_writer_finish(&ctx->writer, &bytes_saved, &same);
+    ctx->started          = false;
+    if (err != ESP_OK || ctx->failed || !complete || bytes_saved == 0) {
+        log_printf(LOG_LEVEL_ERROR, "Error saving screen img %u, keeping previous image", ctx->screen_img);
+        return false;
+    }
+
+    screen_img_metadata_t metadata = {0};
+    screen_img_handler_get_metadata(ctx->screen_img, &metadata);
+
+    if (same) {
+        // Validators stored with the active image still describe these exact bytes, leave the record alone
+        log_printf(LOG_LEVEL_INFO, "Screen img %u identical to stored image, left flash untouched", ctx->screen_img);
+        *unchanged = true;
+        return true;
+    }
+
+    http_validator_t no_validator = {0};
+    return screen_img_handler_commit(&metadata, !metadata.screen_img_active_slot, bytes_saved, &no_validator);
+}
+
+/*
+ * Download a chart and draw it into the framebuffer in the same pass, instead of reading it back from flash with
+ * screen_img_handler_draw_chart afterwards. Image is still persisted to flash for later redraws. If clear_area is set,
+ * the chart area is cleared once new image data arrives, pass false if the whole screen was just cleared. Unchanged is
+ * only set if no image data was received (a 304), so nothing was drawn and the framebuffer is untouched. On failure the
+ * previous image is still intact in its slot, so it's redrawn over whatever part of the new one was received.
+ */
+bool screen_img_handler_download_and_draw_chart(screen_img_t screen_img, bool clear_area, bool *unchanged) {
+    screen_img_stream_ctx_t stream = {
+        .x          = WEATHER_CHART_X_COORD,
+        .y          = screen_img_handler_get_y_for_chart(screen_img),
+        .max_width  = WEATHER_CHART_MAX_WIDTH_PX,
+        .max_height = WEATHER_CHART_MAX_HEIGHT_PX,
+        .clear_area = clear_area,
+    };
+
+    bool success = screen_img_handler_download(screen_img, &stream, unchanged);
+    if (!success && stream.bytes_drawn > 0) {
+        display_clear_area(stream.x, stream.y, stream.max_width, stream.max_height);
+        screen_img_handler_draw_chart(screen_img);
+    }
+
+    return success;
+}
+
+/*
+ * Same as screen_img_handler_download_and_draw_chart, for non-chart images (see screen_img_handler_draw_screen_img)
+ */
+bool screen_img_handler_download_and_draw_screen_img(screen_img_t screen_img, bool clear_area, bool *unchanged) {
+    screen_img_stream_ctx_t stream = {
+        .x          = 0,
+        .y          = 0,
+        .max_width  = SCREEN_IMG_MAX_WIDTH_PX,
+        .max_height = SCREEN_IMG_MAX_HEIGHT_PX,
+        .clear_area = clear_area,
+    };
+
+    bool success = screen_img_handler_download(screen_img, &stream, unchanged);
+    if (!success && stream.bytes_drawn > 0) {
+        display_clear_area(stream.x, stream.y, stream.max_width, stream.max_height);
+        screen_img_handler_draw_screen_img(screen_img);
+    }
+
     return success;
 }
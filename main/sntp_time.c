@@ -1,15 +1,17 @@
 #include "esp_sntp.h"
+#include "freertos/FreeRTOS.h"
 #include "memfault/panics/assert.h"
 
 #include "constants.h"
 #include "log.h"
+#include "scheduler_task.h"
 #include "sntp_time.h"
 
 #define TAG SC_TAG_SNTP
 
 /*
- * Callback that fires every time the SNTP service syncs system time with received rmeote value. Superfluous with the
- * sntp_time_is_synced function below unless we wanted this to set a flag so we didn't have to poll that function
+ * Callback that fires every time the SNTP service syncs system time with received rmeote value. The scheduler's queued
+ * update times were computed against the old clock, so they're recomputed here.
  */
 static void sntp_time_sync_notification_cb(struct timeval *tv) {
     (void)tv;
@@ -21,6 +23,8 @@ static void sntp_time_sync_notification_cb(struct timeval *tv) {
     char time_string[64];
     strftime(time_string, 64, "%c", &timeinfo);
     log_printf(LOG_LEVEL_DEBUG, "SNTP updated current time to %s", time_string);
+
+    scheduler_reschedule();
 }
 
 void sntp_time_init() {
@@ -122,6 +126,7 @@ void sntp_set_time(uint32_t epoch_secs) {
 
     const struct timeval time = {.tv_sec = epoch_secs, .tv_usec = 0};
     MEMFAULT_ASSERT(settimeofday(&time, NULL) == 0);
+    scheduler_reschedule();
 }
 
 void sntp_set_tz_str(char *new_tz_str) {
@@ -134,4 +139,7 @@ void sntp_set_tz_str(char *new_tz_str) {
     // https://www.gnu.org/software/libc/manual/html_node/TZ-Variable.html
     setenv("TZ", new_tz_str, 1);
     tzset();
+
+    // Discrete updates are scheduled on local wall clock time
+    scheduler_reschedule();
 }
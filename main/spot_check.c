@@ -1,12 +1,17 @@
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "esp_app_desc.h"
 #include "esp_mac.h"
 #include "memfault/panics/assert.h"
 
+#include "conditions_bin.h"
 #include "constants.h"
 #include "display.h"
+#include "forecast.h"
 #include "http_client.h"
+#include "http_queue.h"
 #include "json.h"
 #include "log.h"
 #include "nvs.h"
@@ -39,6 +44,13 @@
 
 #define NUM_BYTES_VERSION_STR (26)
 
+// Which conditions fields a parse has seen
+#define CONDITIONS_FIELD_TEMPERATURE_BIT (1 << 0)
+#define CONDITIONS_FIELD_WIND_SPEED_BIT (1 << 1)
+#define CONDITIONS_FIELD_WIND_DIR_BIT (1 << 2)
+#define CONDITIONS_FIELD_TIDE_HEIGHT_BIT (1 << 3)
+#define CONDITIONS_FIELD_IS_RISING_BIT (1 << 4)
+
 static const char *const ota_start_text    = "Firmware update in progress, please do not unplug Spot Check device";
 static const char *const ota_finished_text = "Firmware update successful! Rebooting...";
 static const char *const offline_text =
@@ -53,6 +65,18 @@ static struct tm last_time_displayed = {0};
 static struct tm last_date_displayed = {
     0};  // Need separate storage for date because date is updated on different sequence than time
 
+// Validators of the last conditions response. Only kept in RAM like the conditions themselves, after a reboot there's
+// nothing to compare against anyway.
+static http_validator_t conditions_validator;
+
+// Hourly forecast for the spot it was fetched for, lets the conditions advance every hour without a request and keep
+// going while offline. RAM only, refetched on boot. Scratch decoder is static since it holds a whole series.
+static forecast_t         forecast;
+static forecast_decoder_t forecast_decoder;
+static http_validator_t   forecast_validator;
+static char               forecast_spot_uid[64];
+static bool               forecast_unsupported = false;
+
 static char device_serial[20];
 static char firmware_version[NUM_BYTES_VERSION_STR + 1];  // 5-8 bytes for version, 1 for dash, 16 msb of elf hash.
 static char hw_version[10];                               // always less, hardcoded below in ifdefs
@@ -71,126 +95,306 @@ char *spot_check_get_hw_version() {
 }
 
 /*
- * Returns success
- * */
-bool spot_check_download_and_save_conditions(conditions_t *new_conditions) {
-    if (new_conditions == NULL) {
-        return false;
-    }
-
-    spot_check_config_t *config = nvs_get_config();
-    char                 url_buf[strlen(URL_BASE) + 80];
-    uint8_t              num_params = 4;
-    query_param          params[num_params];
-    http_request_t       request = http_client_build_get_request("conditions", config, url_buf, params, num_params);
-
-    char                    *server_response    = NULL;
-    size_t                   response_data_size = 0;
-    esp_http_client_handle_t client;
-    int                      content_length = 0;
-    bool                     success        = http_client_perform_with_retries(&request, 1, &client, &content_length);
-
-    // This MUST be here to short circuit execution. If http_client_read_response_to_* is called after a failure of
-    // http_client_perform_with_retries, the inner call to client cleanup function will assert and crash and there's
-    // nothing we can do to wrap or error check it
-    if (!success) {
-        log_printf(LOG_LEVEL_ERROR,
-                   "Received false success trying to perform req before reading response, bailing out of process");
-        return false;
+ * json_stream value callback, picks the conditions fields out of the 'data' object. Fields with an unexpected type get
+ * a fallback value.
+ */
+static void spot_check_conditions_parse_value(json_stream_t    *stream,
+                                              json_value_type_t type,
+                                              const char       *value,
+                                              void             *ctx) {
+    spot_check_conditions_parser_t *parser     = (spot_check_conditions_parser_t *)ctx;
+    conditions_t                   *conditions = &parser->json.conditions;
+    if (json_stream_get_depth(stream) != 2 || strcmp(json_stream_get_key(stream, 1), "data") != 0) {
+        return;
     }
 
-    esp_err_t http_err =
-        http_client_read_response_to_buffer(&client, content_length, &server_response, &response_data_size);
-
-    if (http_err == ESP_OK && response_data_size != 0) {
-        cJSON *json                  = parse_json(server_response);
-        cJSON *data_value            = cJSON_GetObjectItem(json, "data");
-        cJSON *temperature_object    = cJSON_GetObjectItem(data_value, "temp");
-        cJSON *wind_speed_object     = cJSON_GetObjectItem(data_value, "wind_speed");
-        cJSON *wind_dir_object       = cJSON_GetObjectItem(data_value, "wind_dir");
-        cJSON *tide_height_object    = cJSON_GetObjectItem(data_value, "tide_height");
-        cJSON *is_tide_rising_object = cJSON_GetObjectItem(data_value, "is_rising");
-
-        log_printf(LOG_LEVEL_DEBUG, "Server response: %s", server_response);
-        if (server_response != NULL) {
-            free(server_response);
-            server_response = NULL;
-        }
-
-        if (wind_dir_object == NULL || tide_height_object == NULL || wind_speed_object == NULL ||
-            temperature_object == NULL) {
-            log_printf(LOG_LEVEL_ERROR,
-                       "Parsed at least one field to a null cJSON object. That means the field wasn't in the response "
-                       "at all but a successful request response "
-                       "code (could be a wifi login portal default login page)");
-            return false;
-        }
-
-        // Parse out end-result values with fallbacks in case value for key is not expected type
-        int8_t temperature = 0;
-        if (cJSON_IsNumber(temperature_object)) {
-            temperature = temperature_object->valueint;
+    const char *key = json_stream_get_key(stream, 2);
+    if (strcmp(key, "temp") == 0) {
+        parser->json.fields_found |= CONDITIONS_FIELD_TEMPERATURE_BIT;
+        if (type == JSON_VALUE_NUMBER) {
+            conditions->temperature = (int)strtod(value, NULL);
         } else {
             log_printf(LOG_LEVEL_WARN, "Expecting number from api for temp key, did not get one. Defaulting to -99");
-            temperature = -99;
+            conditions->temperature = -99;
         }
-
-        uint8_t wind_speed = 0;
-        if (cJSON_IsNumber(wind_speed_object)) {
-            wind_speed = wind_speed_object->valueint;
+    } else if (strcmp(key, "wind_speed") == 0) {
+        parser->json.fields_found |= CONDITIONS_FIELD_WIND_SPEED_BIT;
+        if (type == JSON_VALUE_NUMBER) {
+            conditions->wind_speed = (int)strtod(value, NULL);
         } else {
             log_printf(LOG_LEVEL_WARN,
                        "Expecting number from api for wind_speed key, did not get one. Defaulting to 99");
-            wind_speed = 99;
+            conditions->wind_speed = 99;
         }
-
-        char *wind_dir_str = NULL;
-        if (cJSON_IsString(wind_dir_object)) {
-            wind_dir_str = cJSON_GetStringValue(wind_dir_object);
+    } else if (strcmp(key, "wind_dir") == 0) {
+        parser->json.fields_found |= CONDITIONS_FIELD_WIND_DIR_BIT;
+        if (type == JSON_VALUE_STRING) {
+            snprintf(conditions->wind_dir, sizeof(conditions->wind_dir), "%s", value);
         } else {
             log_printf(LOG_LEVEL_WARN, "Expecting string from api for wind_dir key, did not get one. Defaulting to ?");
-            wind_dir_str = "X";
+            strcpy(conditions->wind_dir, "X");
         }
-
-        char *tide_height_str = NULL;
-        if (cJSON_IsString(tide_height_object)) {
-            tide_height_str = cJSON_GetStringValue(tide_height_object);
+    } else if (strcmp(key, "tide_height") == 0) {
+        parser->json.fields_found |= CONDITIONS_FIELD_TIDE_HEIGHT_BIT;
+        if (type == JSON_VALUE_STRING) {
+            snprintf(conditions->tide_height, sizeof(conditions->tide_height), "%s", value);
         } else {
             log_printf(LOG_LEVEL_WARN,
                        "Expecting string from api for tide_height key, did not get one. Defaulting to ?");
-            tide_height_str = "?";
+            strcpy(conditions->tide_height, "?");
+        }
+    } else if (strcmp(key, "is_rising") == 0) {
+        parser->json.fields_found |= CONDITIONS_FIELD_IS_RISING_BIT;
+        if (type == JSON_VALUE_TRUE || type == JSON_VALUE_FALSE) {
+            conditions->is_tide_rising = type == JSON_VALUE_TRUE;
+        } else {
+            log_printf(LOG_LEVEL_WARN, "Expecting bool from api for is_rising key, did not get one. Defaulting to true");
+            conditions->is_tide_rising = true;
         }
+    }
+}
+
+/*
+ * Start parsing a conditions response (from the conditions endpoint or a batch part), JSON or binary. The response is
+ * fed in as it arrives with spot_check_conditions_parser_feed, nothing is buffered or allocated.
+ */
+void spot_check_conditions_parser_init(spot_check_conditions_parser_t *parser) {
+    memset(parser, 0, sizeof(spot_check_conditions_parser_t));
+    parser->format = SPOT_CHECK_CONDITIONS_FORMAT_UNKNOWN;
+}
 
-        bool is_tide_rising;
-        if (cJSON_IsBool(is_tide_rising_object)) {
-            is_tide_rising = cJSON_IsTrue(is_tide_rising_object);
+/*
+ * The format is picked from the first byte, the server may not support binary and answer in JSON.
+ */
+bool spot_check_conditions_parser_feed(spot_check_conditions_parser_t *parser, const char *data, size_t len) {
+    if (len == 0) {
+        return true;
+    }
+
+    if (parser->format == SPOT_CHECK_CONDITIONS_FORMAT_UNKNOWN) {
+        if (conditions_bin_is_magic_start((uint8_t)data[0])) {
+            parser->format = SPOT_CHECK_CONDITIONS_FORMAT_BIN;
+            conditions_bin_decoder_init(&parser->bin);
         } else {
-            log_printf(LOG_LEVEL_WARN,
-                       "Expecting bool from api for is_rising key, did not get one. Defaulting to true");
-            is_tide_rising = true;
+            parser->format                         = SPOT_CHECK_CONDITIONS_FORMAT_JSON;
+            parser->json.conditions.is_tide_rising = true;
+            json_stream_init(&parser->json.stream, spot_check_conditions_parse_value, parser);
         }
+    }
+
+    if (parser->format == SPOT_CHECK_CONDITIONS_FORMAT_BIN) {
+        conditions_bin_decoder_feed(&parser->bin, (const uint8_t *)data, len);
+        return true;
+    }
 
-        // Copy into global conditions after every field set
-        new_conditions->temperature    = temperature;
-        new_conditions->wind_speed     = wind_speed;
-        new_conditions->is_tide_rising = is_tide_rising;
-        strcpy(new_conditions->wind_dir, wind_dir_str);
-        strcpy(new_conditions->tide_height, tide_height_str);
+    return json_stream_feed(&parser->json.stream, data, len);
+}
 
-        cJSON_Delete(json);
-    } else {
+static bool spot_check_conditions_parser_finish_json(spot_check_conditions_parser_t *parser, conditions_t *conditions) {
+    if (!json_stream_finish(&parser->json.stream)) {
+        log_printf(LOG_LEVEL_ERROR, "Conditions response was not a complete JSON document");
+        return false;
+    }
+
+    uint8_t required_fields = CONDITIONS_FIELD_TEMPERATURE_BIT | CONDITIONS_FIELD_WIND_SPEED_BIT |
+                              CONDITIONS_FIELD_WIND_DIR_BIT | CONDITIONS_FIELD_TIDE_HEIGHT_BIT;
+    if ((parser->json.fields_found & required_fields) != required_fields) {
+        log_printf(LOG_LEVEL_ERROR,
+                   "At least one field (found 0x%02X) wasn't in the response at all but a successful request response "
+                   "code (could be a wifi login portal default login page)",
+                   parser->json.fields_found);
+        return false;
+    }
+
+    if (!(parser->json.fields_found & CONDITIONS_FIELD_IS_RISING_BIT)) {
+        log_printf(LOG_LEVEL_WARN, "Expecting bool from api for is_rising key, did not get one. Defaulting to true");
+    }
+
+    memcpy(conditions, &parser->json.conditions, sizeof(conditions_t));
+    return true;
+}
+
+/*
+ * Check the whole response was valid and copy the parsed values out. For JSON a missing field (other than is_rising)
+ * fails the parse since that means it's not a conditions response at all. conditions is only written on success.
+ */
+bool spot_check_conditions_parser_finish(spot_check_conditions_parser_t *parser, conditions_t *conditions) {
+    switch (parser->format) {
+        case SPOT_CHECK_CONDITIONS_FORMAT_JSON:
+            return spot_check_conditions_parser_finish_json(parser, conditions);
+        case SPOT_CHECK_CONDITIONS_FORMAT_BIN:
+            if (!conditions_bin_decoder_finish(&parser->bin, conditions)) {
+                log_printf(LOG_LEVEL_ERROR,
+                           "Binary conditions response invalid or unsupported version (%zu bytes)",
+                           parser->bin.len);
+                return false;
+            }
+            return true;
+        default:
+            log_printf(LOG_LEVEL_ERROR, "Conditions response was empty");
+            return false;
+    }
+}
+
+static void spot_check_conditions_parse_chunk(const uint8_t *chunk, size_t chunk_size, size_t offset, void *ctx) {
+    (void)offset;
+    spot_check_conditions_parser_feed((spot_check_conditions_parser_t *)ctx, (const char *)chunk, chunk_size);
+}
+
+/*
+ * Returns success. Request is conditional on the last successful response. If the server says nothing changed,
+ * unchanged is set and new_conditions is left untouched, the last retrieved conditions are current.
+ * */
+bool spot_check_download_and_save_conditions(conditions_t *new_conditions, bool *unchanged) {
+    if (new_conditions == NULL || unchanged == NULL) {
+        return false;
+    }
+
+    *unchanged = false;
+
+    spot_check_config_t *config = nvs_get_config();
+    char                 url_buf[strlen(URL_BASE) + 80];
+    query_param          params[5];
+    http_request_t       request = http_client_build_get_request("conditions", config, url_buf, params, 4);
+
+    // Build only fills in the params shared by every endpoint
+    params[4]                   = (query_param){.key = CONDITIONS_BIN_QUERY_KEY, .value = CONDITIONS_BIN_QUERY_VALUE};
+    request.get_args.num_params = 5;
+    request.get_args.validator  = &conditions_validator;
+
+    // Parsed as it arrives so the response never has to fit in a buffer
+    spot_check_conditions_parser_t parser;
+    spot_check_conditions_parser_init(&parser);
+    http_queue_req_t queue_req = {
+        .request            = &request,
+        .additional_retries = 1,
+        .sink               = HTTP_QUEUE_SINK_CB,
+        .cb =
+            {
+                .chunk_cb     = spot_check_conditions_parse_chunk,
+                .chunk_cb_ctx = &parser,
+            },
+    };
+    if (!http_queue_run(&queue_req, HTTP_QUEUE_PRIORITY_HIGH)) {
         log_printf(LOG_LEVEL_INFO, "Failed to get new conditions, leaving last saved values displayed");
         return false;
     }
 
-    // Caller responsible for freeing buffer if non-null on return
-    if (server_response != NULL) {
-        free(server_response);
-        server_response = NULL;
+    if (request.get_args.not_modified) {
+        log_printf(LOG_LEVEL_INFO, "Conditions not modified since last request");
+        *unchanged = true;
+        return true;
+    }
+
+    bool success = spot_check_conditions_parser_finish(&parser, new_conditions);
+    if (success) {
+        memcpy(&conditions_validator, &request.get_args.response_validator, sizeof(http_validator_t));
+    }
+
+    return success;
+}
+
+static void spot_check_forecast_decode_chunk(const uint8_t *chunk, size_t chunk_size, size_t offset, void *ctx) {
+    (void)offset;
+    forecast_decoder_feed((forecast_decoder_t *)ctx, chunk, chunk_size);
+}
+
+/*
+ * Fetch the hourly forecast series and merge it into the cached one. Returns success, unchanged is set if the server
+ * said nothing changed since the last one. Servers without the endpoint are only asked once per boot.
+ */
+bool spot_check_download_and_save_forecast(bool *unchanged) {
+    if (unchanged == NULL) {
+        return false;
+    }
+
+    *unchanged = false;
+    if (forecast_unsupported) {
+        return false;
     }
 
+    spot_check_config_t *config = nvs_get_config();
+    char                 url_buf[strlen(URL_BASE) + 80];
+    query_param          params[4];
+    http_request_t       request = http_client_build_get_request("forecast", config, url_buf, params, 4);
+
+    // Validator is ignored for a different spot's url, so a 304 always means the cached series is for this spot
+    request.get_args.validator = &forecast_validator;
+    request.get_args.optional  = true;
+
+    forecast_decoder_init(&forecast_decoder);
+    http_queue_req_t queue_req = {
+        .request = &request,
+        .sink    = HTTP_QUEUE_SINK_CB,
+        .cb =
+            {
+                .chunk_cb     = spot_check_forecast_decode_chunk,
+                .chunk_cb_ctx = &forecast_decoder,
+            },
+    };
+    if (!http_queue_run(&queue_req, HTTP_QUEUE_PRIORITY_NORMAL)) {
+        if (queue_req.bytes_received == 0 && (request.status == 404 || request.status == 501)) {
+            log_printf(LOG_LEVEL_INFO, "Server doesn't support forecasts (%d), not trying again", request.status);
+            forecast_unsupported = true;
+        } else {
+            log_printf(LOG_LEVEL_INFO, "Failed to get forecast, keeping cached series");
+        }
+        return false;
+    }
+
+    if (request.get_args.not_modified) {
+        log_printf(LOG_LEVEL_INFO, "Forecast not modified since last request");
+        *unchanged = true;
+        return true;
+    }
+
+    // Series for another spot must not be merged into
+    if (strcmp(forecast_spot_uid, config->spot_uid) != 0) {
+        forecast_init(&forecast);
+    }
+    if (!forecast_decoder_finish(&forecast_decoder, &forecast)) {
+        log_printf(LOG_LEVEL_ERROR,
+                   "Forecast response invalid or unsupported version (%zu bytes)",
+                   queue_req.bytes_received);
+        return false;
+    }
+
+    memcpy(&forecast_validator, &request.get_args.response_validator, sizeof(http_validator_t));
+    snprintf(forecast_spot_uid, sizeof(forecast_spot_uid), "%s", config->spot_uid);
+    log_printf(LOG_LEVEL_INFO, "Saved forecast, %u hours cached", forecast_get_count(&forecast));
     return true;
 }
+
+/*
+ * Cached forecast starting at the current hour, NULL if there's none for the configured spot
+ */
+const forecast_t *spot_check_get_forecast() {
+    spot_check_config_t *config = nvs_get_config();
+    if (strcmp(forecast_spot_uid, config->spot_uid) != 0) {
+        return NULL;
+    }
+
+    time_t now = 0;
+    time(&now);
+    forecast_drop_expired(&forecast, now);
+    return &forecast;
+}
+
+/*
+ * Conditions for the current hour from the cached forecast. False if there's no forecast for the configured spot
+ * covering it, the conditions have to be fetched.
+ */
+bool spot_check_get_forecast_conditions(conditions_t *conditions) {
+    const forecast_t *cached = spot_check_get_forecast();
+    if (cached == NULL) {
+        return false;
+    }
+
+    time_t now = 0;
+    time(&now);
+    return forecast_get_conditions(cached, now, conditions);
+}
+
 /*
  * Dirties the whole time rect to ensure no gray-in in the time bounding box over time (mostly noticeable around the
 minutes digits)
@@ -214,6 +418,11 @@ void spot_check_mark_time_dirty() {
                                 TIME_DRAW_Y_PX - previous_time_height_px - 5,
                                 previous_time_width_px + 10,
                                 previous_time_height_px + 10);
+        // Redrawn every minute, so it gets the fast waveform. The periodic full screen dirty cleans it up.
+        display_mark_rect_fast(TIME_DRAW_X_PX - 5,
+                               TIME_DRAW_Y_PX - previous_time_height_px - 5,
+                               previous_time_width_px + 10,
+                               previous_time_height_px + 10);
         log_printf(LOG_LEVEL_DEBUG,
                    "Marking text rect as dirty coords (%u, %u) width: %u height: %u",
                    TIME_DRAW_X_PX,
@@ -267,6 +476,10 @@ void spot_check_clear_date() {
                            DATE_DRAW_Y_PX - previous_date_height_px - 10,
                            previous_date_width_px + 20,
                            previous_date_height_px + 20);
+        display_mark_rect_fast(DATE_DRAW_X_PX - 10,
+                               DATE_DRAW_Y_PX - previous_date_height_px - 10,
+                               previous_date_width_px + 20,
+                               previous_date_height_px + 20);
     }
 }
 
@@ -0,0 +1,127 @@
+/*
+ * Times the framebuffer kernels in components/epd_driver/kernels.c against the per-pixel loops they replaced, on full
+ * EPD_WIDTH x EPD_HEIGHT framebuffers. Host numbers only show the relative gain, the ESP32 is far slower in absolute
+ * terms and has no vector units to flatter either version.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "kernels.h"
+#include "reference_kernels.h"
+
+#define FB_BYTES (EPD_WIDTH / 2 * EPD_HEIGHT)
+#define ITERATIONS (200)
+
+// Keeps the compiler from dropping calls whose results are otherwise unused
+static volatile int sink;
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static void report(const char *name, double reference_ms, double kernel_ms) {
+    printf("%-40s per-pixel %8.3f ms   kernel %8.3f ms   %5.1fx\n",
+           name,
+           reference_ms / ITERATIONS,
+           kernel_ms / ITERATIONS,
+           reference_ms / kernel_ms);
+}
+
+static void bench_difference(const char *name, const uint8_t *to, const uint8_t *from) {
+    uint8_t *interlaced = malloc(EPD_WIDTH * EPD_HEIGHT);
+    bool     dirty_lines[EPD_HEIGHT];
+    uint8_t  from_or, from_and;
+    EpdRect  full_screen = {.x = 0, .y = 0, .width = EPD_WIDTH, .height = EPD_HEIGHT};
+
+    double start = now_ms();
+    for (int i = 0; i < ITERATIONS; i++) {
+        EpdRect r = difference_image_reference(to,
+                                               from,
+                                               full_screen,
+                                               EPD_WIDTH,
+                                               EPD_HEIGHT,
+                                               interlaced,
+                                               dirty_lines,
+                                               &from_or,
+                                               &from_and);
+        sink += r.width;
+    }
+    double reference_ms = now_ms() - start;
+
+    start = now_ms();
+    for (int i = 0; i < ITERATIONS; i++) {
+        EpdRect r = epd_difference_image_base(to,
+                                              from,
+                                              full_screen,
+                                              EPD_WIDTH,
+                                              EPD_HEIGHT,
+                                              interlaced,
+                                              dirty_lines,
+                                              &from_or,
+                                              &from_and);
+        sink += r.width;
+    }
+    double kernel_ms = now_ms() - start;
+
+    report(name, reference_ms, kernel_ms);
+    free(interlaced);
+}
+
+static void bench_copy(const char *name, EpdRect area, uint8_t *framebuffer) {
+    uint8_t *image = malloc((area.width + 1) / 2 * area.height);
+    memset(image, 0x5A, (area.width + 1) / 2 * area.height);
+
+    double start = now_ms();
+    for (int i = 0; i < ITERATIONS; i++) {
+        copy_to_framebuffer_reference(area, image, framebuffer, EPD_WIDTH, EPD_HEIGHT);
+        sink += framebuffer[0];
+    }
+    double reference_ms = now_ms() - start;
+
+    start = now_ms();
+    for (int i = 0; i < ITERATIONS; i++) {
+        epd_copy_to_framebuffer_base(area, image, framebuffer, EPD_WIDTH, EPD_HEIGHT);
+        sink += framebuffer[0];
+    }
+    double kernel_ms = now_ms() - start;
+
+    report(name, reference_ms, kernel_ms);
+    free(image);
+}
+
+int main(void) {
+    uint8_t *to   = malloc(FB_BYTES);
+    uint8_t *from = malloc(FB_BYTES);
+    srand(1);
+    for (int i = 0; i < FB_BYTES; i++) {
+        from[i] = rand();
+    }
+
+    // A clock tick, one small text area changed on an otherwise static screen
+    memcpy(to, from, FB_BYTES);
+    for (int y = 20; y < 70; y++) {
+        memset(to + y * EPD_WIDTH / 2 + 300 / 2, 0xFF, 200 / 2);
+    }
+    bench_difference("difference, clock-sized change", to, from);
+
+    memcpy(to, from, FB_BYTES);
+    bench_difference("difference, identical", to, from);
+
+    for (int i = 0; i < FB_BYTES; i++) {
+        to[i] = rand();
+    }
+    bench_difference("difference, every pixel changed", to, from);
+
+    // A forecast chart sized image, at an even and an odd x offset
+    bench_copy("copy, nibble aligned", (EpdRect){.x = 100, .y = 200, .width = 600, .height = 300}, to);
+    bench_copy("copy, nibble misaligned", (EpdRect){.x = 101, .y = 200, .width = 600, .height = 300}, to);
+
+    free(to);
+    free(from);
+    return 0;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+/*
+ * The straightforward per-pixel implementations the kernels in components/epd_driver/kernels.c replaced, as the
+ * reference for test_epd_kernels and the baseline for bench_epd_kernels.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "kernels.h"
+
+static int imin(int x, int y) {
+    return x < y ? x : y;
+}
+
+static int imax(int x, int y) {
+    return x > y ? x : y;
+}
+
+/*
+ * epd_difference_image_base before it compared whole words, see the history of render.c.
+ */
+static EpdRect difference_image_reference(const uint8_t *to,
+                                          const uint8_t *from,
+                                          EpdRect        crop_to,
+                                          int            fb_width,
+                                          int            fb_height,
+                                          uint8_t       *interlaced,
+                                          bool          *dirty_lines,
+                                          uint8_t       *from_or,
+                                          uint8_t       *from_and) {
+    *from_or  = 0x00;
+    *from_and = 0x0F;
+
+    uint8_t *dirty_cols = calloc(fb_width, 1);
+    int      x_end      = imin(fb_width, crop_to.x + crop_to.width);
+    int      y_end      = imin(fb_height, crop_to.y + crop_to.height);
+
+    for (int y = crop_to.y; y < y_end; y++) {
+        uint8_t dirty = 0;
+        for (int x = crop_to.x; x < x_end; x++) {
+            uint8_t t = *(to + y * fb_width / 2 + x / 2);
+            t         = (x % 2) ? (t >> 4) : (t & 0x0f);
+            uint8_t f = *(from + y * fb_width / 2 + x / 2);
+            f         = (x % 2) ? (f >> 4) : (f & 0x0f);
+            *from_or |= f;
+            *from_and &= f;
+            dirty |= (t ^ f);
+            dirty_cols[x] |= (t ^ f);
+            interlaced[y * fb_width + x] = (t << 4) | f;
+        }
+        dirty_lines[y] = dirty > 0;
+    }
+    int min_x, min_y, max_x, max_y;
+    for (min_x = crop_to.x; min_x < x_end; min_x++) {
+        if (dirty_cols[min_x] != 0) break;
+    }
+    for (max_x = x_end - 1; max_x >= crop_to.x; max_x--) {
+        if (dirty_cols[max_x] != 0) break;
+    }
+    for (min_y = crop_to.y; min_y < y_end; min_y++) {
+        if (dirty_lines[min_y] != 0) break;
+    }
+    for (max_y = y_end - 1; max_y >= crop_to.y; max_y--) {
+        if (dirty_lines[max_y] != 0) break;
+    }
+    free(dirty_cols);
+
+    EpdRect crop_rect = {
+        .x      = min_x,
+        .y      = min_y,
+        .width  = imax(max_x - min_x + 1, 0),
+        .height = imax(max_y - min_y + 1, 0),
+    };
+    return crop_rect;
+}
+
+/*
+ * epd_copy_to_framebuffer before it copied row segments, see the history of epd_driver.c.
+ */
+static void copy_to_framebuffer_reference(EpdRect        image_area,
+                                          const uint8_t *image_data,
+                                          uint8_t       *framebuffer,
+                                          int            fb_width,
+                                          int            fb_height) {
+    for (int i = 0; i < image_area.width * image_area.height; i++) {
+        int value_index = i;
+        // for images of uneven width,
+        // consume an additional nibble per row.
+        if (image_area.width % 2) {
+            value_index += i / image_area.width;
+        }
+        uint8_t val = (value_index % 2) ? (image_data[value_index / 2] & 0xF0) >> 4 : image_data[value_index / 2] & 0x0F;
+
+        int xx = image_area.x + i % image_area.width;
+        if (xx < 0 || xx >= fb_width) {
+            continue;
+        }
+        int yy = image_area.y + i / image_area.width;
+        if (yy < 0 || yy >= fb_height) {
+            continue;
+        }
+        uint8_t *buf_ptr = &framebuffer[yy * fb_width / 2 + xx / 2];
+        if (xx % 2) {
+            *buf_ptr = (*buf_ptr & 0x0F) | (val << 4);
+        } else {
+            *buf_ptr = (*buf_ptr & 0xF0) | val;
+        }
+    }
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+// Host builds only, section and placement attributes are meaningless off target.
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
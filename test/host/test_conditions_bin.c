@@ -0,0 +1,126 @@
+/*
+ * Checks the binary conditions decoder in main/conditions_bin.c: a good payload whole and fed in chunks, payloads with
+ * appended fields, and the malformed ones it has to reject without touching the output.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "conditions_bin.h"
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                  \
+    do {                                  \
+        if (!(cond)) {                    \
+            failures++;                   \
+            fprintf(stderr, "FAIL: ");    \
+            fprintf(stderr, __VA_ARGS__); \
+            fprintf(stderr, "\n");        \
+        }                                 \
+    } while (0)
+
+static conditions_bin_t good_payload(void) {
+    conditions_bin_t bin = {
+        .version     = CONDITIONS_BIN_VERSION,
+        .flags       = CONDITIONS_BIN_FLAG_TIDE_RISING,
+        .temperature = -3,
+        .wind_speed  = 12,
+        .wind_dir    = {'S', 'S', 'W'},
+        .tide_height = {'-', '0', '.', '4', '2'},
+    };
+    memcpy(bin.magic, CONDITIONS_BIN_MAGIC, CONDITIONS_BIN_MAGIC_LEN);
+    return bin;
+}
+
+static bool conditions_equal(const conditions_t *a, const conditions_t *b) {
+    return a->temperature == b->temperature && a->wind_speed == b->wind_speed &&
+           strcmp(a->wind_dir, b->wind_dir) == 0 && strcmp(a->tide_height, b->tide_height) == 0 &&
+           a->is_tide_rising == b->is_tide_rising;
+}
+
+static void test_good_payload(void) {
+    conditions_bin_t   bin      = good_payload();
+    const conditions_t expected = {
+        .temperature    = -3,
+        .wind_speed     = 12,
+        .wind_dir       = "SSW",
+        .tide_height    = "-0.42",
+        .is_tide_rising = true,
+    };
+
+    conditions_t decoded = {0};
+    CHECK(conditions_bin_decode((const uint8_t *)&bin, sizeof(bin), &decoded), "good payload rejected");
+    CHECK(conditions_equal(&decoded, &expected), "good payload decoded wrong");
+
+    // A byte at a time, the way http chunks may split it
+    conditions_bin_decoder_t decoder;
+    conditions_bin_decoder_init(&decoder);
+    for (size_t i = 0; i < sizeof(bin); i++) {
+        conditions_bin_decoder_feed(&decoder, (const uint8_t *)&bin + i, 1);
+    }
+    memset(&decoded, 0, sizeof(decoded));
+    CHECK(conditions_bin_decoder_finish(&decoder, &decoded), "chunked good payload rejected");
+    CHECK(conditions_equal(&decoded, &expected), "chunked good payload decoded wrong");
+
+    // Fields appended by a newer server are ignored
+    uint8_t longer[sizeof(bin) + 5];
+    memcpy(longer, &bin, sizeof(bin));
+    memset(longer + sizeof(bin), 0xAB, 5);
+    conditions_bin_decoder_init(&decoder);
+    conditions_bin_decoder_feed(&decoder, longer, 7);
+    conditions_bin_decoder_feed(&decoder, longer + 7, sizeof(longer) - 7);
+    memset(&decoded, 0, sizeof(decoded));
+    CHECK(conditions_bin_decoder_finish(&decoder, &decoded), "payload with appended fields rejected");
+    CHECK(conditions_equal(&decoded, &expected), "payload with appended fields decoded wrong");
+
+    CHECK(conditions_bin_is_magic_start(CONDITIONS_BIN_MAGIC[0]), "magic start not recognized");
+    CHECK(!conditions_bin_is_magic_start('{'), "JSON taken for binary");
+}
+
+static void check_rejected(const char *name, const uint8_t *data, size_t size) {
+    conditions_t untouched = {.temperature = 99, .wind_dir = "N", .tide_height = "1.00"};
+    conditions_t decoded   = untouched;
+    CHECK(!conditions_bin_decode(data, size, &decoded), "%s accepted", name);
+    CHECK(memcmp(&decoded, &untouched, sizeof(conditions_t)) == 0, "%s wrote to conditions", name);
+}
+
+static void test_malformed_payloads(void) {
+    conditions_bin_t bin = good_payload();
+    bin.magic[3]         = 'X';
+    check_rejected("bad magic", (const uint8_t *)&bin, sizeof(bin));
+
+    bin         = good_payload();
+    bin.version = CONDITIONS_BIN_VERSION + 1;
+    check_rejected("bad version", (const uint8_t *)&bin, sizeof(bin));
+
+    bin = good_payload();
+    for (size_t len = 0; len < sizeof(bin); len++) {
+        check_rejected("truncated payload", (const uint8_t *)&bin, len);
+    }
+
+    bin             = good_payload();
+    bin.wind_dir[1] = '\n';
+    check_rejected("unprintable wind dir", (const uint8_t *)&bin, sizeof(bin));
+
+    // Fields may use their full width without a terminator
+    bin = good_payload();
+    memcpy(bin.tide_height, "-10.42", sizeof(bin.tide_height));
+    conditions_t decoded = {0};
+    CHECK(conditions_bin_decode((const uint8_t *)&bin, sizeof(bin), &decoded) &&
+              strcmp(decoded.tide_height, "-10.42") == 0,
+          "full width tide height decoded wrong");
+}
+
+int main(void) {
+    test_good_payload();
+    test_malformed_payloads();
+
+    if (failures) {
+        fprintf(stderr, "test_conditions_bin: %d failures\n", failures);
+        return 1;
+    }
+    printf("test_conditions_bin: OK\n");
+    return 0;
+}
@@ -0,0 +1,169 @@
+/*
+ * Checks the cron schedules in main/cron.c: parsing lists, ranges and steps into bitmasks, rejecting malformed
+ * expressions without touching the output, and finding the next run across hours, days and DST transitions.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "cron.h"
+
+// US Pacific without depending on tzdata being installed: DST from the second Sunday in March to the first in November
+#define TZ_PACIFIC "PST8PDT,M3.2.0,M11.1.0"
+
+#define ALL_HOURS ((1UL << 24) - 1)
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                  \
+    do {                                  \
+        if (!(cond)) {                    \
+            failures++;                   \
+            fprintf(stderr, "FAIL: ");    \
+            fprintf(stderr, __VA_ARGS__); \
+            fprintf(stderr, "\n");        \
+        }                                 \
+    } while (0)
+
+static uint64_t bits(const int *values, int count) {
+    uint64_t mask = 0;
+    for (int i = 0; i < count; i++) {
+        mask |= 1ULL << values[i];
+    }
+    return mask;
+}
+
+#define BITS(...) bits((const int[]){__VA_ARGS__}, sizeof((const int[]){__VA_ARGS__}) / sizeof(int))
+
+static void check_parsed(const char *expr, uint64_t minutes, uint32_t hours) {
+    cron_schedule_t schedule = {0};
+    CHECK(cron_parse(expr, &schedule), "'%s' rejected", expr);
+    CHECK(schedule.minutes == minutes, "'%s': minutes %llx, expected %llx", expr,
+          (unsigned long long)schedule.minutes, (unsigned long long)minutes);
+    CHECK(schedule.hours == hours, "'%s': hours %x, expected %x", expr, schedule.hours, hours);
+}
+
+static void check_rejected(const char *expr) {
+    cron_schedule_t schedule = {.minutes = 1, .hours = 1};
+    CHECK(!cron_parse(expr, &schedule), "'%s' accepted", expr ? expr : "NULL");
+    CHECK(schedule.minutes == 1 && schedule.hours == 1, "'%s' wrote to the schedule", expr ? expr : "NULL");
+}
+
+static void test_parse(void) {
+    check_parsed("5 *", BITS(5), ALL_HOURS);
+    check_parsed("0 3,12,17", BITS(0), BITS(3, 12, 17));
+    check_parsed("1-3,7 8-10", BITS(1, 2, 3, 7), BITS(8, 9, 10));
+    check_parsed("0-30/10 *", BITS(0, 10, 20, 30), ALL_HOURS);
+    check_parsed("*/15 */6", BITS(0, 15, 30, 45), BITS(0, 6, 12, 18));
+    check_parsed("10/20 22/1", BITS(10, 30, 50), BITS(22, 23));
+    check_parsed("0,5-6,50-59/4 0,23", BITS(0, 5, 6, 50, 54, 58), BITS(0, 23));
+    check_parsed("  59   23  ", BITS(59), BITS(23));
+    check_parsed("* *", UINT64_MAX >> 4, ALL_HOURS);
+
+    check_rejected(NULL);
+    check_rejected("");
+    check_rejected("5");
+    check_rejected("5 ");
+    check_rejected("60 *");
+    check_rejected("5 24");
+    check_rejected("5-3 *");
+    check_rejected("*/0 *");
+    check_rejected("5- *");
+    check_rejected("5, *");
+    check_rejected(",5 *");
+    check_rejected("5 * *");
+    check_rejected("5 *x");
+    check_rejected("a *");
+    check_rejected("-5 *");
+    check_rejected("5\t*");
+    check_rejected("0,1,2,3,4,5,6,7,8,9,10,11,12,13 *");
+
+    cron_schedule_t never = {0};
+    CHECK(cron_is_never(&never), "zeroed schedule isn't never");
+    cron_schedule_t hourly;
+    cron_parse("0 *", &hourly);
+    CHECK(!cron_is_never(&hourly), "hourly schedule is never");
+}
+
+static time_t local_time(int year, int month, int day, int hour, int min, int sec) {
+    struct tm local = {
+        .tm_year  = year - 1900,
+        .tm_mon   = month - 1,
+        .tm_mday  = day,
+        .tm_hour  = hour,
+        .tm_min   = min,
+        .tm_sec   = sec,
+        .tm_isdst = -1,
+    };
+    return mktime(&local);
+}
+
+static time_t utc_time(int year, int month, int day, int hour, int min) {
+    struct tm utc = {
+        .tm_year = year - 1900,
+        .tm_mon  = month - 1,
+        .tm_mday = day,
+        .tm_hour = hour,
+        .tm_min  = min,
+    };
+    return timegm(&utc);
+}
+
+static void check_next(const char *expr, time_t from, time_t expected) {
+    cron_schedule_t schedule;
+    CHECK(cron_parse(expr, &schedule), "'%s' rejected", expr);
+    time_t next = cron_next(&schedule, from);
+    CHECK(next == expected, "'%s' from %lld: next %lld, expected %lld", expr, (long long)from, (long long)next,
+          (long long)expected);
+}
+
+static void test_next(void) {
+    // Later in the same hour, including the minute it's called in
+    check_next("5,40 *", local_time(2024, 1, 15, 10, 4, 30), local_time(2024, 1, 15, 10, 5, 0));
+    check_next("5,40 *", local_time(2024, 1, 15, 10, 5, 0), local_time(2024, 1, 15, 10, 5, 0));
+    check_next("5,40 *", local_time(2024, 1, 15, 10, 6, 0), local_time(2024, 1, 15, 10, 40, 0));
+
+    // Hour rollover, into the next hour and past ones that don't match
+    check_next("5 *", local_time(2024, 1, 15, 10, 6, 0), local_time(2024, 1, 15, 11, 5, 0));
+    check_next("5,40 *", local_time(2024, 1, 15, 10, 59, 59), local_time(2024, 1, 15, 11, 5, 0));
+    check_next("0 3,12,17", local_time(2024, 1, 15, 12, 30, 0), local_time(2024, 1, 15, 17, 0, 0));
+
+    // Day rollover, including into the next month and year
+    check_next("0 3,12,17", local_time(2024, 1, 15, 18, 0, 0), local_time(2024, 1, 16, 3, 0, 0));
+    check_next("0 3,12,17", local_time(2024, 1, 31, 23, 59, 0), local_time(2024, 2, 1, 3, 0, 0));
+    check_next("30 0", local_time(2024, 12, 31, 23, 45, 0), local_time(2025, 1, 1, 0, 30, 0));
+    check_next("30 23", local_time(2024, 1, 15, 23, 31, 0), local_time(2024, 1, 16, 23, 30, 0));
+
+    // DST starts 2024-03-10 at 2:00 PST, skipping to 3:00 PDT. Hours past it are still an hour apart in epoch time.
+    check_next("15 *", utc_time(2024, 3, 10, 9, 30), utc_time(2024, 3, 10, 10, 15));
+    check_next("0 4", local_time(2024, 3, 9, 12, 0, 0), utc_time(2024, 3, 10, 11, 0));
+
+    // A daily run in the skipped hour lands an hour late
+    check_next("30 2", local_time(2024, 3, 9, 12, 0, 0), utc_time(2024, 3, 10, 10, 30));
+
+    // DST ends 2024-11-03 at 2:00 PDT, repeating 1:00-2:00 as PST. The repeated hour is run through like any other.
+    check_next("15 *", utc_time(2024, 11, 3, 8, 20), utc_time(2024, 11, 3, 9, 15));
+    check_next("15 1", utc_time(2024, 11, 3, 7, 30), utc_time(2024, 11, 3, 8, 15));
+    check_next("15 1", utc_time(2024, 11, 3, 8, 30), utc_time(2024, 11, 3, 9, 15));
+    check_next("15 1", utc_time(2024, 11, 3, 9, 30), utc_time(2024, 11, 4, 9, 15));
+
+    // Later the same day through mktime, after the repeated hour
+    check_next("0 1,5", utc_time(2024, 11, 3, 9, 30), utc_time(2024, 11, 3, 13, 0));
+}
+
+int main(void) {
+    setenv("TZ", TZ_PACIFIC, 1);
+    tzset();
+
+    test_parse();
+    test_next();
+
+    if (failures) {
+        fprintf(stderr, "test_cron: %d failures\n", failures);
+        return 1;
+    }
+    printf("test_cron: OK\n");
+    return 0;
+}
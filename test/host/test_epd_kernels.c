@@ -0,0 +1,206 @@
+/*
+ * Checks the framebuffer kernels in components/epd_driver/kernels.c against the straightforward per-pixel
+ * implementations they replaced, on random framebuffers and crop areas with odd widths and offsets.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "kernels.h"
+#include "reference_kernels.h"
+
+#define NUM_ROUNDS (2000)
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                      \
+    do {                                      \
+        if (!(cond)) {                        \
+            failures++;                       \
+            fprintf(stderr, "FAIL: ");        \
+            fprintf(stderr, __VA_ARGS__);     \
+            fprintf(stderr, "\n");            \
+        }                                     \
+    } while (0)
+
+static int rand_range(int lo, int hi) {
+    return lo + rand() % (hi - lo + 1);
+}
+
+static void fill_random(uint8_t *buf, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        buf[i] = rand();
+    }
+}
+
+static void test_difference_image_round(int round) {
+    // Widths of 2 mod 8 leave rows unaligned to a word, and an odd base offset misaligns the whole buffer
+    int    fb_width  = 2 * rand_range(1, 120);
+    int    fb_height = rand_range(1, 40);
+    size_t fb_bytes  = fb_width / 2 * fb_height;
+    int    offset    = rand_range(0, 3);
+
+    uint8_t *to_buf   = malloc(fb_bytes + 3);
+    uint8_t *from_buf = malloc(fb_bytes + 3);
+    uint8_t *to       = to_buf + offset;
+    uint8_t *from     = from_buf + (rand() % 2 ? offset : rand_range(0, 3));
+
+    fill_random(from, fb_bytes);
+    memcpy(to, from, fb_bytes);
+    switch (rand() % 4) {
+        case 0:
+            // Identical, nothing dirty
+            break;
+        case 1:
+            fill_random(to, fb_bytes);
+            break;
+        default: {
+            // A few isolated changed pixels, so the bounding box lands on arbitrary nibbles of a word
+            int changes = rand_range(1, 6);
+            for (int i = 0; i < changes; i++) {
+                int x = rand_range(0, fb_width - 1);
+                int y = rand_range(0, fb_height - 1);
+                to[y * fb_width / 2 + x / 2] ^= (x % 2) ? 0x10 << (rand() % 4) : 0x01 << (rand() % 4);
+            }
+            break;
+        }
+    }
+
+    EpdRect crop = {
+        .x = rand_range(0, fb_width - 1),
+        .y = rand_range(0, fb_height - 1),
+    };
+    crop.width  = rand_range(1, fb_width - crop.x + 4);
+    crop.height = rand_range(1, fb_height - crop.y + 4);
+
+    uint8_t *interlaced_ref = calloc(fb_width * fb_height, 1);
+    uint8_t *interlaced     = calloc(fb_width * fb_height, 1);
+    bool    *dirty_ref      = calloc(fb_height, sizeof(bool));
+    bool    *dirty          = calloc(fb_height, sizeof(bool));
+    uint8_t  or_ref, and_ref, or_new, and_new;
+
+    EpdRect ref = difference_image_reference(to,
+                                             from,
+                                             crop,
+                                             fb_width,
+                                             fb_height,
+                                             interlaced_ref,
+                                             dirty_ref,
+                                             &or_ref,
+                                             &and_ref);
+    EpdRect got =
+        epd_difference_image_base(to, from, crop, fb_width, fb_height, interlaced, dirty, &or_new, &and_new);
+
+    CHECK(ref.x == got.x && ref.y == got.y && ref.width == got.width && ref.height == got.height,
+          "round %d: fb %dx%d crop (%d,%d %dx%d): rect (%d,%d %dx%d), expected (%d,%d %dx%d)",
+          round,
+          fb_width,
+          fb_height,
+          crop.x,
+          crop.y,
+          crop.width,
+          crop.height,
+          got.x,
+          got.y,
+          got.width,
+          got.height,
+          ref.x,
+          ref.y,
+          ref.width,
+          ref.height);
+    CHECK(or_ref == or_new, "round %d: from_or 0x%X, expected 0x%X", round, or_new, or_ref);
+    CHECK(and_ref == and_new, "round %d: from_and 0x%X, expected 0x%X", round, and_new, and_ref);
+
+    int x_end = imin(fb_width, crop.x + crop.width);
+    int y_end = imin(fb_height, crop.y + crop.height);
+    for (int y = crop.y; y < y_end; y++) {
+        CHECK(dirty_ref[y] == dirty[y], "round %d: dirty line %d is %d, expected %d", round, y, dirty[y], dirty_ref[y]);
+        // Interlaced data of clean lines is never read, so it's allowed to differ
+        if (!dirty_ref[y]) {
+            continue;
+        }
+        for (int x = crop.x; x < x_end; x++) {
+            int i = y * fb_width + x;
+            CHECK(interlaced_ref[i] == interlaced[i],
+                  "round %d: interlaced (%d,%d) 0x%02X, expected 0x%02X",
+                  round,
+                  x,
+                  y,
+                  interlaced[i],
+                  interlaced_ref[i]);
+        }
+    }
+
+    free(interlaced_ref);
+    free(interlaced);
+    free(dirty_ref);
+    free(dirty);
+    free(to_buf);
+    free(from_buf);
+}
+
+static void test_copy_to_framebuffer_round(int round) {
+    int    fb_width  = 2 * rand_range(1, 120);
+    int    fb_height = rand_range(1, 40);
+    size_t fb_bytes  = fb_width / 2 * fb_height;
+
+    // Odd widths and offsets, partially or fully off screen on any side
+    EpdRect area = {
+        .x      = rand_range(-20, fb_width + 4),
+        .y      = rand_range(-10, fb_height + 2),
+        .width  = rand_range(1, fb_width + 20),
+        .height = rand_range(1, fb_height + 10),
+    };
+    size_t   image_bytes = (area.width + 1) / 2 * area.height;
+    uint8_t *image       = malloc(image_bytes);
+    uint8_t *fb_ref      = malloc(fb_bytes);
+    uint8_t *fb          = malloc(fb_bytes);
+    fill_random(image, image_bytes);
+    fill_random(fb_ref, fb_bytes);
+    memcpy(fb, fb_ref, fb_bytes);
+
+    copy_to_framebuffer_reference(area, image, fb_ref, fb_width, fb_height);
+    epd_copy_to_framebuffer_base(area, image, fb, fb_width, fb_height);
+
+    for (size_t i = 0; i < fb_bytes; i++) {
+        if (fb_ref[i] != fb[i]) {
+            CHECK(false,
+                  "round %d: fb %dx%d image (%d,%d %dx%d): byte %zu (x %zu, y %zu) 0x%02X, expected 0x%02X",
+                  round,
+                  fb_width,
+                  fb_height,
+                  area.x,
+                  area.y,
+                  area.width,
+                  area.height,
+                  i,
+                  i % (fb_width / 2) * 2,
+                  i / (fb_width / 2),
+                  fb[i],
+                  fb_ref[i]);
+            break;
+        }
+    }
+
+    free(image);
+    free(fb_ref);
+    free(fb);
+}
+
+int main(void) {
+    srand(1);
+
+    for (int round = 0; round < NUM_ROUNDS && failures < 20; round++) {
+        test_difference_image_round(round);
+        test_copy_to_framebuffer_round(round);
+    }
+
+    if (failures) {
+        fprintf(stderr, "test_epd_kernels: %d failures\n", failures);
+        return 1;
+    }
+    printf("test_epd_kernels: OK\n");
+    return 0;
+}
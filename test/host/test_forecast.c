@@ -0,0 +1,334 @@
+/*
+ * Checks the forecast series in main/forecast.c: the ring buffer across wraparound, merging newer series into the
+ * cached one, decoding responses fed in arbitrary chunks, and rejecting malformed ones without touching the cache.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "forecast.h"
+
+#define HOUR (FORECAST_INTERVAL_SECS)
+#define BASE_EPOCH_SECS ((time_t)1700000000 / HOUR * HOUR)
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                  \
+    do {                                  \
+        if (!(cond)) {                    \
+            failures++;                   \
+            fprintf(stderr, "FAIL: ");    \
+            fprintf(stderr, __VA_ARGS__); \
+            fprintf(stderr, "\n");        \
+        }                                 \
+    } while (0)
+
+/*
+ * Every field is derived from the hour and a tag for the series it came from, so a lookup can tell which hour and which
+ * series an entry is from.
+ */
+static forecast_entry_t entry_for(int hour, int tag) {
+    forecast_entry_t entry = {
+        .temperature     = (int8_t)(hour % 100),
+        .wind_speed      = (uint8_t)tag,
+        .wind_dir_deg    = (uint16_t)(hour * 10 % 360),
+        .tide_height_cft = (int16_t)(hour * 7 - 150),
+    };
+    return entry;
+}
+
+static bool entry_is(const forecast_entry_t *entry, int hour, int tag) {
+    forecast_entry_t expected = entry_for(hour, tag);
+    return entry != NULL && memcmp(entry, &expected, sizeof(forecast_entry_t)) == 0;
+}
+
+/*
+ * A series of count hours starting first_hour hours after BASE_EPOCH_SECS, built the way the decoder builds one
+ */
+static forecast_t series_for(int first_hour, int count, int tag) {
+    forecast_t series;
+    forecast_init(&series);
+    series.head_epoch_secs = BASE_EPOCH_SECS + (time_t)first_hour * HOUR;
+    for (int i = 0; i < count; i++) {
+        series.entries[i] = entry_for(first_hour + i, tag);
+    }
+    series.count = count;
+    return series;
+}
+
+/*
+ * Check that forecast covers exactly hours [first_hour, first_hour + count), taking each hour's tag from tag_for_hour
+ */
+static void check_series(const char        *name,
+                         const forecast_t *forecast,
+                         int                first_hour,
+                         int                count,
+                         int (*tag_for_hour)(int hour)) {
+    CHECK(forecast_get_count(forecast) == count, "%s: %u entries, expected %d", name, forecast_get_count(forecast), count);
+    CHECK(forecast->head_epoch_secs == BASE_EPOCH_SECS + (time_t)first_hour * HOUR, "%s: wrong head hour", name);
+
+    for (int i = 0; i < count; i++) {
+        int    hour       = first_hour + i;
+        time_t epoch_secs = 0;
+        CHECK(entry_is(forecast_get_entry(forecast, i, &epoch_secs), hour, tag_for_hour(hour)),
+              "%s: entry %d isn't hour %d",
+              name,
+              i,
+              hour);
+        CHECK(epoch_secs == BASE_EPOCH_SECS + (time_t)hour * HOUR, "%s: entry %d has the wrong start", name, i);
+
+        // Anywhere within the hour finds it
+        uint8_t index = 0xFF;
+        CHECK(forecast_find_entry(forecast, epoch_secs + HOUR - 1, &index) == forecast_get_entry(forecast, i, NULL) &&
+                  index == i,
+              "%s: hour %d not found by time",
+              name,
+              hour);
+    }
+    CHECK(forecast_get_entry(forecast, count, NULL) == NULL, "%s: entry past the end", name);
+    CHECK(forecast_find_entry(forecast, BASE_EPOCH_SECS + (time_t)(first_hour + count) * HOUR, NULL) == NULL,
+          "%s: found an hour past the end",
+          name);
+    CHECK(forecast_find_entry(forecast, BASE_EPOCH_SECS + (time_t)first_hour * HOUR - 1, NULL) == NULL,
+          "%s: found an hour before the head",
+          name);
+}
+
+static int tag_1(int hour) {
+    return 1;
+}
+
+static int tag_2(int hour) {
+    return 2;
+}
+
+// Hours 0-29 from series 1, 30 and later from series 2
+static int tag_split_at_30(int hour) {
+    return hour < 30 ? 1 : 2;
+}
+
+// Hours 0-9 from series 1, 10 and later from series 2
+static int tag_split_at_10(int hour) {
+    return hour < 10 ? 1 : 2;
+}
+
+static void test_ring_wraparound(void) {
+    forecast_t forecast;
+    forecast_init(&forecast);
+    forecast_t first = series_for(0, FORECAST_MAX_ENTRIES, 1);
+    forecast_merge(&forecast, &first);
+    check_series("full", &forecast, 0, FORECAST_MAX_ENTRIES, tag_1);
+
+    // 20 hours later the head sits in the middle of the buffer
+    forecast_drop_expired(&forecast, BASE_EPOCH_SECS + 20 * HOUR + HOUR / 2);
+    check_series("expired", &forecast, 20, FORECAST_MAX_ENTRIES - 20, tag_1);
+    CHECK(forecast.head == 20, "expired: head %u, expected 20", forecast.head);
+
+    // Appending past the end of the array wraps around to the slots the expired hours freed
+    forecast_t newer = series_for(30, 30, 2);
+    forecast_merge(&forecast, &newer);
+    check_series("wrapped", &forecast, 20, 40, tag_split_at_30);
+
+    // More than fits drops the oldest hours
+    newer = series_for(40, 40, 2);
+    forecast_merge(&forecast, &newer);
+    check_series("overflowed", &forecast, 80 - FORECAST_MAX_ENTRIES, FORECAST_MAX_ENTRIES, tag_split_at_30);
+
+    // Every hour over leaves nothing
+    forecast_drop_expired(&forecast, BASE_EPOCH_SECS + 80 * HOUR);
+    CHECK(forecast_get_count(&forecast) == 0, "all expired: %u entries left", forecast_get_count(&forecast));
+    CHECK(forecast_find_entry(&forecast, BASE_EPOCH_SECS + 80 * HOUR, NULL) == NULL, "all expired: found an hour");
+}
+
+static void test_merge(void) {
+    forecast_t forecast;
+    forecast_t newer;
+
+    // Overlapping hours are replaced, later ones appended
+    forecast = series_for(0, 40, 1);
+    newer    = series_for(30, 15, 2);
+    forecast_merge(&forecast, &newer);
+    check_series("overlapping", &forecast, 0, 45, tag_split_at_30);
+
+    // A newer series ending early drops the cached hours after it, they'd be older data than what surrounds them
+    forecast = series_for(0, 40, 1);
+    newer    = series_for(30, 5, 2);
+    forecast_merge(&forecast, &newer);
+    check_series("shorter", &forecast, 0, 35, tag_split_at_30);
+
+    // Starting right after the last cached hour appends
+    forecast = series_for(0, 30, 1);
+    newer    = series_for(30, 10, 2);
+    forecast_merge(&forecast, &newer);
+    check_series("adjacent", &forecast, 0, 40, tag_split_at_30);
+
+    // A gap, an earlier start or a start that's not on the hour grid replace the cache
+    forecast = series_for(0, 10, 1);
+    newer    = series_for(11, 10, 2);
+    forecast_merge(&forecast, &newer);
+    check_series("gap", &forecast, 11, 10, tag_2);
+
+    forecast = series_for(5, 10, 1);
+    newer    = series_for(0, 10, 2);
+    forecast_merge(&forecast, &newer);
+    check_series("earlier", &forecast, 0, 10, tag_2);
+
+    forecast = series_for(0, 10, 1);
+    newer    = series_for(2, 10, 2);
+    newer.head_epoch_secs += 60;
+    forecast_merge(&forecast, &newer);
+    CHECK(forecast.head_epoch_secs == newer.head_epoch_secs && forecast_get_count(&forecast) == 10 &&
+              entry_is(forecast_get_entry(&forecast, 0, NULL), 2, 2),
+          "off grid: not replaced");
+
+    // An empty series changes nothing
+    forecast = series_for(0, 10, 1);
+    forecast_init(&newer);
+    forecast_merge(&forecast, &newer);
+    check_series("empty", &forecast, 0, 10, tag_1);
+}
+
+/*
+ * Serialize a response the way the forecast endpoint sends it, entry_size may be larger than what this firmware knows
+ */
+static size_t build_response(uint8_t *buf, int first_hour, int count, uint8_t entry_size, int tag) {
+    forecast_header_t header = {
+        .version          = FORECAST_VERSION,
+        .num_entries      = count,
+        .entry_size       = entry_size,
+        .start_epoch_secs = (uint32_t)(BASE_EPOCH_SECS + (time_t)first_hour * HOUR),
+    };
+    memcpy(header.magic, FORECAST_MAGIC, FORECAST_MAGIC_LEN);
+    memcpy(buf, &header, sizeof(header));
+
+    size_t len = sizeof(header);
+    for (int i = 0; i < count; i++) {
+        forecast_entry_t entry = entry_for(first_hour + i, tag);
+        memset(buf + len, 0xEE, entry_size);
+        memcpy(buf + len, &entry, sizeof(entry));
+        len += entry_size;
+    }
+    return len;
+}
+
+static bool decode_in_chunks(const uint8_t *data, size_t len, forecast_t *forecast) {
+    forecast_decoder_t decoder;
+    forecast_decoder_init(&decoder);
+    size_t pos = 0;
+    while (pos < len) {
+        size_t chunk = 1 + rand() % 13;
+        if (chunk > len - pos) {
+            chunk = len - pos;
+        }
+        forecast_decoder_feed(&decoder, data + pos, chunk);
+        pos += chunk;
+    }
+    return forecast_decoder_finish(&decoder, forecast);
+}
+
+static void test_decoder(void) {
+    static uint8_t response[sizeof(forecast_header_t) + FORECAST_MAX_ENTRIES * 32];
+    forecast_t     forecast;
+
+    for (int round = 0; round < 50; round++) {
+        // Entries grown by a newer server are skipped over
+        uint8_t entry_size = sizeof(forecast_entry_t) + (round % 3) * 5;
+        size_t  len        = build_response(response, 10, 24, entry_size, 2);
+
+        forecast = series_for(0, 20, 1);
+        CHECK(decode_in_chunks(response, len, &forecast), "round %d: good response rejected", round);
+        check_series("decoded", &forecast, 0, 34, tag_split_at_10);
+    }
+}
+
+static void check_rejected(const char *name, const uint8_t *data, size_t len) {
+    forecast_t forecast = series_for(0, 20, 1);
+    CHECK(!decode_in_chunks(data, len, &forecast), "%s accepted", name);
+    check_series(name, &forecast, 0, 20, tag_1);
+}
+
+static void test_malformed_responses(void) {
+    static uint8_t response[sizeof(forecast_header_t) + FORECAST_MAX_ENTRIES * 32];
+    size_t         len = build_response(response, 10, 24, sizeof(forecast_entry_t), 2);
+
+    response[0] = 'X';
+    check_rejected("bad magic", response, len);
+
+    len = build_response(response, 10, 24, sizeof(forecast_entry_t), 2);
+    response[FORECAST_MAGIC_LEN] = FORECAST_VERSION + 1;
+    check_rejected("bad version", response, len);
+
+    len = build_response(response, 10, 24, sizeof(forecast_entry_t) - 1, 2);
+    check_rejected("entries too small", response, len);
+
+    len = build_response(response, 10, 24, sizeof(forecast_entry_t), 2);
+    check_rejected("truncated header", response, sizeof(forecast_header_t) - 1);
+    check_rejected("truncated entry", response, len - 1);
+    check_rejected("missing entry", response, len - sizeof(forecast_entry_t));
+    check_rejected("empty", response, 0);
+
+    // One entry more than the header says
+    len = build_response(response, 10, 24, sizeof(forecast_entry_t), 2);
+    response[FORECAST_MAGIC_LEN + 1] = 23;
+    check_rejected("extra entry", response, len);
+}
+
+static void test_conditions(void) {
+    forecast_t forecast;
+    forecast_init(&forecast);
+    forecast.head_epoch_secs = BASE_EPOCH_SECS;
+    forecast.count           = 3;
+    forecast.entries[0]      = (forecast_entry_t){.temperature = 61, .wind_speed = 8, .wind_dir_deg = 350,
+                                                  .tide_height_cft = -5};
+    forecast.entries[1]      = (forecast_entry_t){.temperature = 63, .wind_speed = 9, .wind_dir_deg = 202,
+                                                  .tide_height_cft = 123};
+    forecast.entries[2]      = (forecast_entry_t){.temperature = 64, .wind_speed = 10, .wind_dir_deg = 0,
+                                                  .tide_height_cft = 40};
+
+    conditions_t conditions;
+    CHECK(forecast_get_conditions(&forecast, BASE_EPOCH_SECS + 10, &conditions), "first hour not covered");
+    CHECK(conditions.temperature == 61 && conditions.wind_speed == 8 && strcmp(conditions.wind_dir, "N") == 0 &&
+              strcmp(conditions.tide_height, "-0.05") == 0 && conditions.is_tide_rising,
+          "first hour: %d %u %s %s %d",
+          conditions.temperature,
+          conditions.wind_speed,
+          conditions.wind_dir,
+          conditions.tide_height,
+          conditions.is_tide_rising);
+
+    CHECK(forecast_get_conditions(&forecast, BASE_EPOCH_SECS + HOUR, &conditions), "second hour not covered");
+    CHECK(strcmp(conditions.wind_dir, "SSW") == 0 && strcmp(conditions.tide_height, "1.23") == 0 &&
+              !conditions.is_tide_rising,
+          "second hour: %s %s %d",
+          conditions.wind_dir,
+          conditions.tide_height,
+          conditions.is_tide_rising);
+
+    // The last hour has no next one, so the trend comes from the one before
+    CHECK(forecast_get_conditions(&forecast, BASE_EPOCH_SECS + 2 * HOUR, &conditions) && !conditions.is_tide_rising,
+          "last hour: trend from the previous hour");
+
+    conditions_t untouched = conditions;
+    CHECK(!forecast_get_conditions(&forecast, BASE_EPOCH_SECS + 3 * HOUR, &conditions) &&
+              memcmp(&conditions, &untouched, sizeof(conditions_t)) == 0,
+          "uncovered hour wrote conditions");
+}
+
+int main(void) {
+    srand(1);
+
+    test_ring_wraparound();
+    test_merge();
+    test_decoder();
+    test_malformed_responses();
+    test_conditions();
+
+    if (failures) {
+        fprintf(stderr, "test_forecast: %d failures\n", failures);
+        return 1;
+    }
+    printf("test_forecast: OK\n");
+    return 0;
+}
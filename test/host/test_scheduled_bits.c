@@ -0,0 +1,117 @@
+/*
+ * Stress test for main/include/scheduled_bits.h. Producers each own one bit and, like the scheduler_schedule_* +
+ * scheduler_trigger callers, set it and then take whatever is set, forwarding it to a consumer that stands in for the
+ * scheduler task's notification value. A producer only sets its bit again once the consumer has seen it, so every set
+ * must be delivered exactly once, no matter which producer's take picked it up.
+ */
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "scheduled_bits.h"
+
+#define NUM_PRODUCERS (8)
+#define NUM_ROUNDS (20000)
+#define TIMEOUT_SEC (30)
+
+static scheduled_bits_t scheduled;
+// Stands in for xTaskNotify(..., eSetBits) / xTaskNotifyWait
+static _Atomic uint32_t notified;
+static _Atomic bool     delivered[NUM_PRODUCERS];
+static _Atomic long     total_delivered;
+static _Atomic int      failures;
+static time_t           deadline;
+
+static void trigger() {
+    uint32_t bits = scheduled_bits_take(&scheduled);
+    if (bits == 0x0) {
+        return;
+    }
+
+    atomic_fetch_or(&notified, bits);
+}
+
+static void *producer(void *arg) {
+    int      id  = (int)(intptr_t)arg;
+    uint32_t bit = 1u << id;
+
+    for (int i = 0; i < NUM_ROUNDS; i++) {
+        atomic_store(&delivered[id], false);
+        scheduled_bits_set(&scheduled, bit);
+        trigger();
+
+        while (!atomic_load(&delivered[id])) {
+            if (time(NULL) > deadline) {
+                fprintf(stderr, "FAIL: bit 0x%02X of round %d never delivered\n", bit, i);
+                atomic_fetch_add(&failures, 1);
+                return NULL;
+            }
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+static void *consumer(void *arg) {
+    (void)arg;
+
+    while (atomic_load(&total_delivered) < (long)NUM_PRODUCERS * NUM_ROUNDS && time(NULL) <= deadline) {
+        uint32_t bits = atomic_exchange(&notified, 0x0);
+        if (bits == 0x0) {
+            sched_yield();
+            continue;
+        }
+
+        for (int id = 0; id < NUM_PRODUCERS; id++) {
+            if (!(bits & (1u << id))) {
+                continue;
+            }
+            if (atomic_load(&delivered[id])) {
+                fprintf(stderr, "FAIL: bit 0x%02X delivered twice for one set\n", 1u << id);
+                atomic_fetch_add(&failures, 1);
+            }
+            atomic_store(&delivered[id], true);
+            atomic_fetch_add(&total_delivered, 1);
+        }
+        if (bits >> NUM_PRODUCERS) {
+            fprintf(stderr, "FAIL: bits 0x%08X delivered that were never set\n", bits);
+            atomic_fetch_add(&failures, 1);
+        }
+    }
+
+    return NULL;
+}
+
+int main(void) {
+    pthread_t producers[NUM_PRODUCERS];
+    pthread_t consumer_thread;
+
+    scheduled_bits_clear(&scheduled);
+    deadline = time(NULL) + TIMEOUT_SEC;
+
+    pthread_create(&consumer_thread, NULL, consumer, NULL);
+    for (intptr_t id = 0; id < NUM_PRODUCERS; id++) {
+        pthread_create(&producers[id], NULL, producer, (void *)id);
+    }
+    for (int id = 0; id < NUM_PRODUCERS; id++) {
+        pthread_join(producers[id], NULL);
+    }
+    pthread_join(consumer_thread, NULL);
+
+    long expected = (long)NUM_PRODUCERS * NUM_ROUNDS;
+    if (atomic_load(&failures) || atomic_load(&total_delivered) != expected) {
+        fprintf(stderr,
+                "test_scheduled_bits: %d failures, %ld of %ld sets delivered\n",
+                atomic_load(&failures),
+                atomic_load(&total_delivered),
+                expected);
+        return 1;
+    }
+    printf("test_scheduled_bits: OK\n");
+    return 0;
+}